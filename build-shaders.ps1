@@ -1,3 +1,7 @@
+param(
+	[string]$ToolsPath
+)
+
 try
 {
 	foreach($file in (Get-ChildItem -File -Recurse "$PSScriptRoot/shader" -Exclude *.spv))
@@ -5,10 +9,24 @@ try
         Write-Host "Compiling shader $file"
         & "$env:VULKAN_SDK/bin/glslangValidator" -V $file.FullName -o "$($file.Directory.FullName)\$($file.Name).spv" | Out-Null
     }
+
+	if($ToolsPath)
+	{
+		New-Item -ItemType Directory -Force -Path "$PSScriptRoot/mesh" | Out-Null
+		foreach($file in (Get-ChildItem -File -Recurse "$PSScriptRoot/models" -Include *.obj))
+		{
+			Write-Host "Importing mesh $file"
+			& "$ToolsPath/MeshImporter.exe" $file.FullName "$PSScriptRoot/mesh/$($file.BaseName).vkmesh" | Out-Null
+			if($LASTEXITCODE -ne 0) { throw "MeshImporter failed for $file" }
+		}
+
+		Write-Host "Packing assets into $PSScriptRoot/assets.vkpa"
+		& "$ToolsPath/AssetPacker.exe" "$PSScriptRoot/assets.vkpa" "$PSScriptRoot/shader" "$PSScriptRoot/mesh" "$PSScriptRoot/textures"
+		if($LASTEXITCODE -ne 0) { throw "AssetPacker failed with exit code $LASTEXITCODE" }
+	}
 }
 catch
 {
     Write-Error $_
 	exit 1
 }
-
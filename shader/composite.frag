@@ -0,0 +1,22 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+// tonemapped color of the previous subpass, see RenderDevice::GetRenderPass
+layout(input_attachment_index = 0, set = 0, binding = 0) uniform subpassInput tonemapped;
+
+layout(push_constant) uniform PushConstants {
+    float exposure;
+    float vignette;
+    vec2 extent;
+} pc;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    vec2 offset = gl_FragCoord.xy / pc.extent - 0.5;
+    float vignette = 1.0 - pc.vignette * dot(offset, offset) * 2.0;
+
+    // interleaved gradient noise of one 8 bit step hides the banding of dark gradients in 8 bit targets
+    float noise = fract(52.9829189 * fract(dot(gl_FragCoord.xy, vec2(0.06711056, 0.00583715))));
+    outColor = vec4(subpassLoad(tonemapped).rgb * vignette + (noise - 0.5) / 255.0, 1.0);
+}
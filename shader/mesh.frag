@@ -0,0 +1,66 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(location = 0) in vec3 fragNormal;
+layout(location = 1) in vec2 fragUV;
+layout(location = 2) in vec3 fragPosition;
+
+layout(set = 0, binding = 0) uniform sampler2D albedoTexture;
+
+// written by cluster_lights.comp, see LightClusterParams in src/gfx/LightClusters.hpp
+layout(set = 1, binding = 0) uniform ClusterParams {
+    uvec4 grid;       // clusters in x, y and z, light count
+    vec4 tile;        // tile size in pixels, rendered extent
+    vec4 slices;      // near, far, slice scale, slice bias
+    vec4 projection;  // projection[0][0], projection[1][1], depth linearization a and b
+} params;
+
+struct PointLight {
+    vec4 positionRadius;   // world space
+    vec4 colorIntensity;
+};
+
+layout(std430, set = 1, binding = 1) readonly buffer Lights {
+    PointLight lights[];
+};
+
+layout(std430, set = 1, binding = 2) readonly buffer Clusters {
+    uvec2 clusters[];      // offset into lightIndices, light count
+};
+
+layout(std430, set = 1, binding = 3) readonly buffer LightIndices {
+    uint lightIndexCount;
+    uint lightIndices[];
+};
+
+layout(location = 0) out vec4 outColor;
+
+uint clusterIndex() {
+    // view distance from the hyperbolic depth, slices are spaced exponentially between near and far
+    float viewDepth = params.projection.w / (gl_FragCoord.z + params.projection.z);
+    uint slice = uint(clamp(log(viewDepth) * params.slices.z - params.slices.w, 0.0, float(params.grid.z - 1)));
+    uvec2 tile = min(uvec2(gl_FragCoord.xy / params.tile.xy), params.grid.xy - 1);
+    return (slice * params.grid.y + tile.y) * params.grid.x + tile.x;
+}
+
+void main() {
+    vec3 normal = normalize(fragNormal);
+    vec3 lightDir = normalize(vec3(0.4, 1.0, 0.6));
+    vec3 lighting = vec3(0.2 + 0.8 * max(dot(normal, lightDir), 0.0));
+
+    // only the lights the culling pass assigned to the cluster of this fragment
+    if (params.grid.w > 0) {
+        uvec2 cluster = clusters[clusterIndex()];
+        for (uint i = 0; i < cluster.y; i++) {
+            PointLight light = lights[lightIndices[cluster.x + i]];
+            vec3 toLight = light.positionRadius.xyz - fragPosition;
+            float distanceSquared = dot(toLight, toLight);
+            float falloff = clamp(1.0 - distanceSquared / (light.positionRadius.w * light.positionRadius.w), 0.0, 1.0);
+            float diffuse = max(dot(normal, toLight * inversesqrt(max(distanceSquared, 1e-6))), 0.0);
+            lighting += light.colorIntensity.rgb * light.colorIntensity.w * falloff * falloff * diffuse;
+        }
+    }
+
+    vec3 albedo = texture(albedoTexture, fragUV).rgb;
+    outColor = vec4(albedo * lighting, 1.0);
+}
@@ -0,0 +1,44 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(push_constant) uniform PushConstants {
+    mat4 mvp;
+    vec4 positionScale;
+    vec4 positionOffset;
+    vec4 uvScaleOffset;
+    vec4 modelTransform; // translation xyz, rotation about y in w
+} pc;
+
+// quantized vertex layout, see src/assets/MeshFormat.hpp
+layout(location = 0) in vec4 inPosition;
+layout(location = 1) in vec2 inNormal;
+layout(location = 2) in vec2 inUV;
+
+layout(location = 0) out vec3 fragNormal;
+// the depth pre-pass runs this shader too, eEqual depth tests need bit identical positions in both passes
+invariant gl_Position;
+layout(location = 1) out vec2 fragUV;
+layout(location = 2) out vec3 fragPosition;
+
+vec3 decodeOctahedral(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+
+vec3 rotateY(vec3 v, float angle) {
+    float c = cos(angle);
+    float s = sin(angle);
+    return vec3(c * v.x + s * v.z, v.y, -s * v.x + c * v.z);
+}
+
+void main() {
+    vec3 position = inPosition.xyz * pc.positionScale.xyz + pc.positionOffset.xyz;
+    gl_Position = pc.mvp * vec4(position, 1.0);
+    // world space for the point lights, the model matrix is a rotation about y followed by a translation
+    fragPosition = rotateY(position, pc.modelTransform.w) + pc.modelTransform.xyz;
+    fragNormal = rotateY(decodeOctahedral(inNormal), pc.modelTransform.w);
+    fragUV = inUV * pc.uvScaleOffset.xy + pc.uvScaleOffset.zw;
+}
@@ -0,0 +1,23 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+// scene color of the previous subpass, see RenderDevice::GetRenderPass
+layout(input_attachment_index = 0, set = 0, binding = 0) uniform subpassInput sceneColor;
+
+layout(push_constant) uniform PushConstants {
+    float exposure;
+    float vignette;
+    vec2 extent;
+} pc;
+
+layout(location = 0) out vec4 outColor;
+
+// filmic curve fitted to the ACES reference tonemapper
+vec3 tonemapAces(vec3 x) {
+    return clamp((x * (2.51 * x + 0.03)) / (x * (2.43 * x + 0.59) + 0.14), 0.0, 1.0);
+}
+
+void main() {
+    vec3 color = subpassLoad(sceneColor).rgb * pc.exposure;
+    outColor = vec4(tonemapAces(color), 1.0);
+}
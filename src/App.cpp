@@ -1,4 +1,8 @@
 #include "App.hpp"
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
 #include <spdlog/spdlog.h>
 #include <vulkan/vulkan.hpp>
 #include <SDL_vulkan.h>
@@ -15,7 +19,8 @@ bool is64Bit()
 #endif
 }
 
-App::App(const std::function<std::unique_ptr<IRenderer>()> renderFactory)
+App::App(const std::function<std::unique_ptr<IRenderer>()> renderFactory, uint32_t maxFrameLatency, uint64_t frameLimit, uint32_t windowCount)
+	: windowCount(std::max(windowCount, 1u)), maxFrameLatency(maxFrameLatency), frameLimit(frameLimit)
 {
 	this->renderer = renderFactory();
 }
@@ -26,30 +31,100 @@ App::~App()
 	this->Cleanup();
 }
 
-void App::InitWindow()
+void App::InitWindows()
 {
 	auto log = spdlog::get("logger");
-	this->window = SDL_CreateWindow(
-		!is64Bit() ? "VkPlayground - 32Bit" : "VkPlayground - 64Bit",
-		SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
-		800, 480,
-		SDL_WINDOW_SHOWN | SDL_WINDOW_VULKAN | SDL_WINDOW_RESIZABLE
-	);
+	for (uint32_t i = 0; i < this->windowCount; i++)
+	{
+		std::string title = !is64Bit() ? "VkPlayground - 32Bit" : "VkPlayground - 64Bit";
+		if (this->windowCount > 1)
+			title += " - " + std::to_string(i);
+
+		// additional windows are cascaded so they do not cover each other
+		const auto offset = static_cast<int>(i) * 40;
+		const auto window = SDL_CreateWindow(
+			title.c_str(),
+			i == 0 ? SDL_WINDOWPOS_UNDEFINED : 100 + offset, i == 0 ? SDL_WINDOWPOS_UNDEFINED : 100 + offset,
+			800, 480,
+			SDL_WINDOW_SHOWN | SDL_WINDOW_VULKAN | SDL_WINDOW_RESIZABLE
+		);
 
-	if (this->window == nullptr)
-		throw std::exception(SDL_GetError());
+		if (window == nullptr)
+			throw std::exception(SDL_GetError());
+		this->windows.push_back(window);
 
-	log->info("SDL2 window created");
+		const auto screenSurface = SDL_GetWindowSurface(window);
+		SDL_FillRect(screenSurface, nullptr, SDL_MapRGB(screenSurface->format, 0x44, 0x44, 0x44));
+		SDL_UpdateWindowSurface(window);
+	}
+
+	log->info("{0} SDL2 window(s) created", this->windows.size());
+}
 
-	const auto screenSurface = SDL_GetWindowSurface(this->window);
-	SDL_FillRect(screenSurface, nullptr, SDL_MapRGB(screenSurface->format, 0x44, 0x44, 0x44));
-	SDL_UpdateWindowSurface(this->window);
+size_t App::FindWindow(uint32_t windowId) const
+{
+	const auto window = SDL_GetWindowFromID(windowId);
+	const auto found = std::find(this->windows.begin(), this->windows.end(), window);
+	return found != this->windows.end() ? static_cast<size_t>(found - this->windows.begin()) : this->windows.size();
+}
+
+void App::Simulate(FrameSnapshot& snapshot)
+{
+	snapshot.cameraPosition = { 3.f, 2.5f, 4.f };
+	snapshot.cameraTarget = { 0.f, 0.f, 0.f };
+	snapshot.meshRotation = static_cast<float>(snapshot.time * 0.5);
+}
+
+void App::RenderLoop(vkp::FramePipeline<FrameSnapshot>& pipeline, std::vector<WindowState> windowStates)
+{
+	try
+	{
+		while (const auto snapshot = pipeline.BeginConsume())
+		{
+			// resizes are picked up from the snapshots so only this thread ever touches the device,
+			// each window is resized on its own without waiting for the others
+			auto visible = false;
+			for (size_t i = 0; i < windowStates.size(); i++)
+			{
+				const auto& state = snapshot->windows[i];
+				if (state.width != windowStates[i].width || state.height != windowStates[i].height)
+					this->renderer->Resize(i, state.width, state.height);
+				windowStates[i] = state;
+				visible |= !state.minimized;
+			}
+
+			if (visible)
+				this->renderer->Draw(*snapshot);
+			pipeline.EndConsume();
+		}
+	}
+	catch (...)
+	{
+		this->renderError = std::current_exception();
+		pipeline.Close();
+	}
 }
 
 void App::MainLoop()
 {
 	auto log = spdlog::get("logger");
-	log->info("Entering main loop");
+	log->info("Entering main loop, max frame latency {0}", this->maxFrameLatency);
+
+	std::vector<WindowState> windowStates(this->windows.size());
+	for (size_t i = 0; i < this->windows.size(); i++)
+	{
+		int width, height;
+		SDL_GetWindowSize(this->windows[i], &width, &height);
+		windowStates[i] = { static_cast<uint32_t>(width), static_cast<uint32_t>(height), false };
+	}
+
+	// the render thread records and submits frame N while this thread handles events and simulates frame N+1
+	vkp::FramePipeline<FrameSnapshot> pipeline(this->maxFrameLatency);
+	std::thread renderThread([this, &pipeline, windowStates]() { this->RenderLoop(pipeline, windowStates); });
+
+	const auto start = std::chrono::high_resolution_clock::now();
+	auto previous = start;
+	uint64_t frame = 0;
 	SDL_Event e;
 	bool quit = false;
 	while (!quit) {
@@ -74,8 +149,17 @@ void App::MainLoop()
 					{
 						case SDL_WINDOWEVENT_SIZE_CHANGED:
 						case SDL_WINDOWEVENT_RESIZED:
-							log->info("Resizing window to {0}/{1}", e.window.data1, e.window.data2);
-							this->renderer->Resize(this->window, e.window.data1, e.window.data2);
+						{
+							const auto index = this->FindWindow(e.window.windowID);
+							if (index == windowStates.size())
+								break;
+							log->info("Resizing window {0} to {1}/{2}", index, e.window.data1, e.window.data2);
+							windowStates[index].width = static_cast<uint32_t>(e.window.data1);
+							windowStates[index].height = static_cast<uint32_t>(e.window.data2);
+							break;
+						}
+						case SDL_WINDOWEVENT_CLOSE:
+							quit = true;
 							break;
 						default:
 							log->debug("event: {0}, data1: {1}, data2: {2}", vkp::tools::sdlWindowEventToString(e.window.event), e.window.data1, e.window.data2);
@@ -89,27 +173,53 @@ void App::MainLoop()
 					break;
 			}
 		}
-		//Render the scene
-		const auto windowFlags = SDL_GetWindowFlags(this->window);
-		if((windowFlags & SDL_WINDOW_MINIMIZED) == 0)
-			this->renderer->Draw();
+		if (quit)
+			break;
+
+		// blocks while the render thread is maxFrameLatency frames behind
+		auto& snapshot = pipeline.BeginProduce();
+		if (pipeline.IsClosed())
+			break;
+
+		const auto now = std::chrono::high_resolution_clock::now();
+		snapshot.frame = frame;
+		snapshot.time = std::chrono::duration<double>(now - start).count();
+		snapshot.deltaTime = std::chrono::duration<float>(now - previous).count();
+		for (size_t i = 0; i < this->windows.size(); i++)
+			windowStates[i].minimized = (SDL_GetWindowFlags(this->windows[i]) & SDL_WINDOW_MINIMIZED) != 0;
+		snapshot.windows = windowStates;
+		this->Simulate(snapshot);
+		pipeline.EndProduce();
+
+		previous = now;
+		if (++frame == this->frameLimit)
+			quit = true;
 	}
+
+	pipeline.Close();
+	renderThread.join();
+
+	const auto stats = pipeline.GetStats();
+	const auto elapsed = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+	spdlog::get("vk-perf")->info("{0} frames in {1:.2f}s ({2:.1f} fps), simulation waited {3:.2f}s for the render thread, render thread waited {4:.2f}s for the simulation",
+		stats.frames, elapsed, stats.frames / elapsed, stats.producerWaitSeconds, stats.consumerWaitSeconds);
+
+	if (this->renderError)
+		std::rethrow_exception(this->renderError);
 	log->info("Shutting down");
 }
 
 void App::Cleanup()
 {
-	if (this->window)
-	{
-		SDL_DestroyWindow(this->window);
-		this->window = nullptr;
-	}
+	for (auto window : this->windows)
+		SDL_DestroyWindow(window);
+	this->windows.clear();
 }
 
 void App::Run()
 {
-	this->InitWindow();
-	this->renderer->Initialize(this->window);
+	this->InitWindows();
+	this->renderer->Initialize(this->windows);
 	this->MainLoop();
 	this->Cleanup();
 }
@@ -2,19 +2,31 @@
 #include <SDL.h>
 #include <vulkan/vulkan.hpp>
 #include "gfx/IRenderer.hpp"
+#include "utils/FramePipeline.hpp"
+#include <exception>
 #include <functional>
+#include <vector>
 
 class App
 {
-	SDL_Window* window;
+	std::vector<SDL_Window*> windows;
+	uint32_t windowCount;
 	std::unique_ptr<IRenderer> renderer;
+	uint32_t maxFrameLatency;
+	uint64_t frameLimit;
+	std::exception_ptr renderError;
 
-	void InitWindow();
+	void InitWindows();
+	size_t FindWindow(uint32_t windowId) const;
 	void MainLoop();
+	void RenderLoop(vkp::FramePipeline<FrameSnapshot>& pipeline, std::vector<WindowState> windowStates);
+	void Simulate(FrameSnapshot& snapshot);
 	void Cleanup();
 
 public:
-	App(std::function<std::unique_ptr<IRenderer>()> renderFactory);
+	// maxFrameLatency: frames the simulation may run ahead of the render thread, frameLimit: quit after that many frames (0 runs until closed),
+	// windowCount: windows rendered by the one renderer, closing any of them quits
+	App(std::function<std::unique_ptr<IRenderer>()> renderFactory, uint32_t maxFrameLatency = 1, uint64_t frameLimit = 0, uint32_t windowCount = 1);
 	~App();
 
 	void Run();
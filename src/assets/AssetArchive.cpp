@@ -0,0 +1,84 @@
+#include "AssetArchive.hpp"
+#include <algorithm>
+#include <exception>
+#include "../utils/Lz4.hpp"
+
+namespace vkp::assets
+{
+	AssetArchive::AssetArchive(const std::string& filename) : file(filename)
+	{
+		const auto data = this->file.GetData();
+		if (data.size < sizeof(ArchiveHeader))
+			throw std::exception(std::string("asset archive truncated: " + filename).c_str());
+
+		this->header = data.as<ArchiveHeader>();
+		if (this->header->magic != ArchiveMagic)
+			throw std::exception(std::string("not an asset archive: " + filename).c_str());
+		if (this->header->version != ArchiveVersion)
+			throw std::exception(std::string("unsupported asset archive version: " + filename).c_str());
+
+		// offsets and sizes are untrusted 64 bit values, ranges are checked by subtraction so their sums cannot wrap around
+		const auto indexSize = uint64_t(this->header->entryCount) * sizeof(ArchiveEntry);
+		if (this->header->indexOffset > data.size || indexSize > data.size - this->header->indexOffset || this->header->stringTableOffset > data.size)
+			throw std::exception(std::string("asset archive index out of bounds: " + filename).c_str());
+
+		this->entries = reinterpret_cast<const ArchiveEntry*>(data.data + this->header->indexOffset);
+		this->strings = reinterpret_cast<const char*>(data.data + this->header->stringTableOffset);
+
+		const auto stringTableSize = data.size - this->header->stringTableOffset;
+		for (uint32_t i = 0; i < this->header->entryCount; i++)
+		{
+			const auto& entry = this->entries[i];
+			if (entry.size > data.size || entry.offset > data.size - entry.size || uint64_t(entry.nameOffset) + entry.nameLength > stringTableSize)
+				throw std::exception(std::string("asset archive entry out of bounds: " + filename).c_str());
+		}
+
+		this->accessed = std::make_unique<std::atomic<bool>[]>(this->header->entryCount);
+		for (uint32_t i = 0; i < this->header->entryCount; i++)
+			this->accessed[i].store(false, std::memory_order_relaxed);
+	}
+
+	const ArchiveEntry* AssetArchive::Find(const std::string& name) const
+	{
+		const auto hash = HashAssetName(name);
+		const auto end = this->entries + this->header->entryCount;
+		auto it = std::lower_bound(this->entries, end, hash, [](const ArchiveEntry& e, uint64_t h) { return e.nameHash < h; });
+
+		// hash collisions are resolved by comparing the stored name
+		for (; it != end && it->nameHash == hash; ++it)
+		{
+			if (name.size() == it->nameLength && name.compare(0, name.size(), this->strings + it->nameOffset, it->nameLength) == 0)
+				return it;
+		}
+		return nullptr;
+	}
+
+	ByteSpan AssetArchive::Get(const std::string& name) const
+	{
+		const auto entry = this->Find(name);
+		if (entry == nullptr)
+			throw std::exception(std::string("asset not found: " + name).c_str());
+		return this->Get(*entry);
+	}
+
+	ByteSpan AssetArchive::Get(const ArchiveEntry& entry) const
+	{
+		const auto data = this->file.GetData();
+		const auto index = static_cast<size_t>(&entry - this->entries);
+		this->accessed[index].store(true, std::memory_order_relaxed);
+		if ((entry.flags & AssetFlagLz4) == 0)
+			return { data.data + entry.offset, entry.size };
+
+		std::lock_guard<std::mutex> lock(this->decompressedMutex);
+		auto& buffer = this->decompressed[index];
+		if (!buffer)
+		{
+			// new[] of a fundamental type is aligned for max_align_t which satisfies SPIR-V and vertex data
+			auto target = std::make_unique<uint8_t[]>(entry.uncompressedSize);
+			if (!lz4::Decompress(data.data + entry.offset, entry.size, target.get(), entry.uncompressedSize))
+				throw std::exception(std::string("corrupt asset: " + this->GetName(entry)).c_str());
+			buffer = std::move(target);
+		}
+		return { buffer.get(), entry.uncompressedSize };
+	}
+}
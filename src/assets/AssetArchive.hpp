@@ -0,0 +1,45 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "AssetArchiveFormat.hpp"
+#include "../utils/ByteSpan.hpp"
+#include "../utils/MappedFile.hpp"
+
+namespace vkp::assets
+{
+	// Memory mapped, read only view on a packed asset archive.
+	// Uncompressed entries are returned as spans into the mapping, LZ4 entries are decompressed once on first access.
+	// Spans remain valid for the lifetime of the archive.
+	class AssetArchive
+	{
+		MappedFile file;
+		const ArchiveHeader* header = nullptr;
+		const ArchiveEntry* entries = nullptr;
+		const char* strings = nullptr;
+
+		mutable std::mutex decompressedMutex;
+		mutable std::unordered_map<size_t, std::unique_ptr<uint8_t[]>> decompressed;
+		mutable std::unique_ptr<std::atomic<bool>[]> accessed;  // per entry, set by Get
+
+	public:
+		explicit AssetArchive(const std::string& filename);
+
+		const ArchiveEntry* Find(const std::string& name) const;
+		bool Contains(const std::string& name) const { return this->Find(name) != nullptr; }
+
+		ByteSpan Get(const std::string& name) const;
+		// entry has to be obtained from this archive
+		ByteSpan Get(const ArchiveEntry& entry) const;
+
+		uint32_t GetEntryCount() const { return this->header->entryCount; }
+		const ArchiveEntry& GetEntry(uint32_t index) const { return this->entries[index]; }
+		std::string GetName(const ArchiveEntry& entry) const { return std::string(this->strings + entry.nameOffset, entry.nameLength); }
+
+		// whether the entry was read since the archive was opened, frame captures embed exactly those
+		bool WasAccessed(uint32_t index) const { return this->accessed[index].load(std::memory_order_relaxed); }
+	};
+}
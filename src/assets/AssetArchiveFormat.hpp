@@ -0,0 +1,66 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+// On disk layout of a packed asset archive (*.vkpa)
+//
+// [ArchiveHeader][blob][blob]...[ArchiveEntry * entryCount][string table]
+//
+// Every blob starts on a 16 byte boundary so SPIR-V and vertex data can be consumed straight from the mapping.
+// The entry table is sorted by name hash to allow binary search lookups.
+namespace vkp::assets
+{
+	constexpr uint32_t ArchiveMagic = 0x41504B56; // "VKPA"
+	constexpr uint32_t ArchiveVersion = 1;
+	constexpr uint64_t ArchiveBlobAlignment = 16;
+
+	enum class AssetType : uint32_t
+	{
+		Raw = 0,
+		Shader = 1,
+		Mesh = 2,
+		Texture = 3
+	};
+
+	enum AssetFlags : uint32_t
+	{
+		AssetFlagNone = 0,
+		AssetFlagLz4 = 1 << 0
+	};
+
+	struct ArchiveHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t entryCount;
+		uint32_t reserved;
+		uint64_t indexOffset;
+		uint64_t stringTableOffset;
+	};
+	static_assert(sizeof(ArchiveHeader) == 32, "ArchiveHeader layout changed");
+
+	struct ArchiveEntry
+	{
+		uint64_t nameHash;
+		uint64_t offset;
+		uint64_t size;
+		uint64_t uncompressedSize;
+		uint32_t nameOffset;
+		uint32_t nameLength;
+		AssetType type;
+		uint32_t flags;
+	};
+	static_assert(sizeof(ArchiveEntry) == 48, "ArchiveEntry layout changed");
+
+	// FNV-1a, names are stored with forward slashes relative to the packed root directory
+	inline uint64_t HashAssetName(const std::string& name)
+	{
+		uint64_t hash = 14695981039346656037ull;
+		for (const auto c : name)
+		{
+			hash ^= static_cast<uint8_t>(c);
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+}
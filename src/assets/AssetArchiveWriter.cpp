@@ -0,0 +1,96 @@
+#include "AssetArchiveWriter.hpp"
+#include <algorithm>
+#include <exception>
+#include <fstream>
+#include "../utils/Lz4.hpp"
+
+namespace vkp::assets
+{
+	static bool endsWith(const std::string& value, const std::string& suffix)
+	{
+		return value.size() >= suffix.size() && value.compare(value.size() - suffix.size(), suffix.size(), suffix) == 0;
+	}
+
+	static uint64_t alignUp(uint64_t value, uint64_t alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	AssetType GuessAssetType(const std::string& filename)
+	{
+		if (endsWith(filename, ".spv"))
+			return AssetType::Shader;
+		if (endsWith(filename, ".vkmesh"))
+			return AssetType::Mesh;
+		if (endsWith(filename, ".ktx2"))
+			return AssetType::Texture;
+		return AssetType::Raw;
+	}
+
+	void AssetArchiveWriter::Add(const std::string& name, AssetType type, std::vector<uint8_t> data, bool compress)
+	{
+		this->pending.push_back({ name, type, compress, std::move(data) });
+	}
+
+	void AssetArchiveWriter::Write(const std::string& filename) const
+	{
+		std::vector<uint8_t> blob(sizeof(ArchiveHeader), 0);
+		std::vector<ArchiveEntry> entries;
+		std::string strings;
+
+		for (auto& p : this->pending)
+		{
+			ArchiveEntry entry = {};
+			entry.nameHash = HashAssetName(p.name);
+			entry.nameOffset = static_cast<uint32_t>(strings.size());
+			entry.nameLength = static_cast<uint32_t>(p.name.size());
+			entry.type = p.type;
+			entry.uncompressedSize = p.data.size();
+			strings += p.name;
+
+			const uint8_t* payload = p.data.data();
+			auto payloadSize = p.data.size();
+
+			std::vector<uint8_t> compressed;
+			if (p.compress && !p.data.empty())
+			{
+				compressed.resize(lz4::CompressBound(p.data.size()));
+				const auto compressedSize = lz4::Compress(p.data.data(), p.data.size(), compressed.data(), compressed.size());
+				if (compressedSize > 0 && compressedSize * 10 <= p.data.size() * 9)
+				{
+					entry.flags |= AssetFlagLz4;
+					payload = compressed.data();
+					payloadSize = compressedSize;
+				}
+			}
+
+			entry.offset = alignUp(blob.size(), ArchiveBlobAlignment);
+			entry.size = payloadSize;
+			blob.resize(entry.offset + payloadSize, 0);
+			std::copy(payload, payload + payloadSize, blob.begin() + entry.offset);
+			entries.push_back(entry);
+		}
+
+		std::sort(entries.begin(), entries.end(), [](const ArchiveEntry& a, const ArchiveEntry& b) { return a.nameHash < b.nameHash; });
+
+		ArchiveHeader header = {};
+		header.magic = ArchiveMagic;
+		header.version = ArchiveVersion;
+		header.entryCount = static_cast<uint32_t>(entries.size());
+		header.indexOffset = alignUp(blob.size(), ArchiveBlobAlignment);
+		header.stringTableOffset = header.indexOffset + entries.size() * sizeof(ArchiveEntry);
+
+		blob.resize(header.indexOffset, 0);
+		const auto entryBytes = reinterpret_cast<const uint8_t*>(entries.data());
+		blob.insert(blob.end(), entryBytes, entryBytes + entries.size() * sizeof(ArchiveEntry));
+		blob.insert(blob.end(), strings.begin(), strings.end());
+		std::copy_n(reinterpret_cast<const uint8_t*>(&header), sizeof(header), blob.begin());
+
+		std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+		if (file.fail())
+			throw std::exception(std::string("unable to open " + filename).c_str());
+		file.write(reinterpret_cast<const char*>(blob.data()), blob.size());
+		if (file.fail())
+			throw std::exception(std::string("unable to write " + filename).c_str());
+	}
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "AssetArchiveFormat.hpp"
+
+namespace vkp::assets
+{
+	// Builds a packed asset archive in memory and writes it to disk, used by the offline tools
+	class AssetArchiveWriter
+	{
+		struct PendingEntry
+		{
+			std::string name;
+			AssetType type;
+			bool compress;
+			std::vector<uint8_t> data;
+		};
+
+		std::vector<PendingEntry> pending;
+
+	public:
+		void Add(const std::string& name, AssetType type, std::vector<uint8_t> data, bool compress);
+
+		// LZ4 is only kept for entries where it saves at least 10%, everything else is stored as is
+		void Write(const std::string& filename) const;
+	};
+
+	AssetType GuessAssetType(const std::string& filename);
+}
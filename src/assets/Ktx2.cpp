@@ -0,0 +1,124 @@
+#include "Ktx2.hpp"
+#include <algorithm>
+#include <cstring>
+#include <exception>
+
+namespace vkp::assets
+{
+	namespace
+	{
+		const uint8_t Ktx2Identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+		struct Ktx2Header
+		{
+			uint8_t identifier[12];
+			uint32_t vkFormat;
+			uint32_t typeSize;
+			uint32_t pixelWidth;
+			uint32_t pixelHeight;
+			uint32_t pixelDepth;
+			uint32_t layerCount;
+			uint32_t faceCount;
+			uint32_t levelCount;
+			uint32_t supercompressionScheme;
+			uint32_t dfdByteOffset;
+			uint32_t dfdByteLength;
+			uint32_t kvdByteOffset;
+			uint32_t kvdByteLength;
+			uint64_t sgdByteOffset;
+			uint64_t sgdByteLength;
+		};
+		static_assert(sizeof(Ktx2Header) == 80, "Ktx2Header layout mismatch");
+
+		struct Ktx2LevelIndex
+		{
+			uint64_t byteOffset;
+			uint64_t byteLength;
+			uint64_t uncompressedByteLength;
+		};
+
+		struct FormatBlock
+		{
+			uint32_t vkFormat;
+			uint32_t blockSize;   // texels along both axes
+			uint32_t blockBytes;
+		};
+
+		// VkFormat values of the block compressed formats and the plain 8 bit RGBA/BGRA ones
+		const FormatBlock FormatBlocks[] =
+		{
+			{ 37, 1, 4 }, { 38, 1, 4 }, { 39, 1, 4 }, { 40, 1, 4 }, { 41, 1, 4 }, { 42, 1, 4 }, { 43, 1, 4 },  // R8G8B8A8
+			{ 44, 1, 4 }, { 45, 1, 4 }, { 46, 1, 4 }, { 47, 1, 4 }, { 48, 1, 4 }, { 49, 1, 4 }, { 50, 1, 4 },  // B8G8R8A8
+			{ 131, 4, 8 }, { 132, 4, 8 }, { 133, 4, 8 }, { 134, 4, 8 },    // BC1
+			{ 135, 4, 16 }, { 136, 4, 16 }, { 137, 4, 16 }, { 138, 4, 16 }, // BC2, BC3
+			{ 139, 4, 8 }, { 140, 4, 8 },                                    // BC4
+			{ 141, 4, 16 }, { 142, 4, 16 }, { 143, 4, 16 }, { 144, 4, 16 }, // BC5, BC6H
+			{ 145, 4, 16 }, { 146, 4, 16 }                                   // BC7
+		};
+
+		const FormatBlock* findFormatBlock(uint32_t vkFormat)
+		{
+			const auto found = std::find_if(std::begin(FormatBlocks), std::end(FormatBlocks), [vkFormat](const FormatBlock& block) { return block.vkFormat == vkFormat; });
+			return found != std::end(FormatBlocks) ? found : nullptr;
+		}
+	}
+
+	Ktx2Texture ParseKtx2(const ByteSpan& data, const std::string& name)
+	{
+		if (data.size < sizeof(Ktx2Header))
+			throw std::exception(std::string("ktx2 truncated: " + name).c_str());
+
+		Ktx2Header header;
+		std::memcpy(&header, data.data, sizeof(header));
+		if (std::memcmp(header.identifier, Ktx2Identifier, sizeof(Ktx2Identifier)) != 0)
+			throw std::exception(std::string("not a ktx2 file: " + name).c_str());
+		if (header.vkFormat == 0)
+			throw std::exception(std::string("ktx2 without vulkan format is not supported: " + name).c_str());
+		const auto block = findFormatBlock(header.vkFormat);
+		if (!block)
+			throw std::exception(std::string("ktx2 format " + std::to_string(header.vkFormat) + " is not supported: " + name).c_str());
+		if (header.supercompressionScheme != 0)
+			throw std::exception(std::string("supercompressed ktx2 is not supported: " + name).c_str());
+		if (header.pixelWidth == 0 || header.pixelHeight == 0 || header.pixelDepth > 1 || header.layerCount > 1 || header.faceCount != 1)
+			throw std::exception(std::string("only 2D ktx2 textures are supported: " + name).c_str());
+
+		// a level count of 0 asks the loader to generate mips, which streaming can not do
+		const auto levelCount = std::max(header.levelCount, 1u);
+		uint32_t maxLevelCount = 1;
+		while ((std::max(header.pixelWidth, header.pixelHeight) >> maxLevelCount) > 0)
+			maxLevelCount++;
+		if (levelCount > maxLevelCount)
+			throw std::exception(std::string("ktx2 has more levels than its size allows: " + name).c_str());
+		if (levelCount * sizeof(Ktx2LevelIndex) > data.size - sizeof(Ktx2Header))
+			throw std::exception(std::string("ktx2 level index truncated: " + name).c_str());
+
+		Ktx2Texture texture = {};
+		texture.vkFormat = header.vkFormat;
+		texture.width = header.pixelWidth;
+		texture.height = header.pixelHeight;
+
+		for (uint32_t i = 0; i < levelCount; i++)
+		{
+			Ktx2LevelIndex level;
+			std::memcpy(&level, data.data + sizeof(Ktx2Header) + i * sizeof(Ktx2LevelIndex), sizeof(level));
+			if (level.byteLength > data.size || level.byteOffset > data.size - level.byteLength)
+				throw std::exception(std::string("ktx2 level out of bounds: " + name).c_str());
+
+			// uploads copy whole levels, so a level has to hold exactly its blocks
+			const auto width = std::max(header.pixelWidth >> i, 1u);
+			const auto height = std::max(header.pixelHeight >> i, 1u);
+			const auto blocksX = (static_cast<uint64_t>(width) + block->blockSize - 1) / block->blockSize;
+			const auto blocksY = (static_cast<uint64_t>(height) + block->blockSize - 1) / block->blockSize;
+			if (level.byteLength != blocksX * blocksY * block->blockBytes)
+				throw std::exception(std::string("ktx2 level " + std::to_string(i) + " has an unexpected size: " + name).c_str());
+
+			texture.levels.push_back({
+				{ data.data + level.byteOffset, static_cast<size_t>(level.byteLength) },
+				width,
+				height
+			});
+		}
+
+		return texture;
+	}
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "../utils/ByteSpan.hpp"
+
+// Reader for KTX2 texture containers, only the subset needed for streaming is supported:
+// 2D textures with a single layer and face in BC1-BC7 or 8 bit RGBA/BGRA, no supercompression.
+namespace vkp::assets
+{
+	struct Ktx2Level
+	{
+		ByteSpan data;
+		uint32_t width;
+		uint32_t height;
+	};
+
+	struct Ktx2Texture
+	{
+		uint32_t vkFormat; // VkFormat, kept as integer so this header does not depend on vulkan
+		uint32_t width;
+		uint32_t height;
+		std::vector<Ktx2Level> levels; // levels[0] is the full resolution image
+	};
+
+	// data has to stay alive as long as the returned levels are used
+	Ktx2Texture ParseKtx2(const ByteSpan& data, const std::string& name);
+}
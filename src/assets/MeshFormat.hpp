@@ -0,0 +1,67 @@
+#pragma once
+#include <cstdint>
+
+// Binary mesh layout (*.vkmesh), produced offline by the MeshImporter tool
+//
+// [MeshHeader][PackedVertex * vertexCount][indices]
+//
+// Both streams start on a 16 byte boundary and are stored exactly as they are bound on the GPU,
+// so the file content can be copied into a staging buffer with a single memcpy. Meshes are never empty.
+// Indices are checked against vertexCount by the MeshImporter when writing. Loaders only validate the layout and trust the
+// indices, the asset archive is built from importer output and treated as trusted for them.
+namespace vkp::assets
+{
+	constexpr uint32_t MeshMagic = 0x48534D56; // "VMSH"
+	constexpr uint32_t MeshVersion = 1;
+
+	enum class MeshIndexType : uint32_t
+	{
+		UInt16 = 0,
+		UInt32 = 1
+	};
+
+	// position: R16G16B16A16_SNORM, dequantized with MeshHeader::positionScale/positionOffset, w is always 1
+	// normal:   R16G16_SNORM, octahedral encoding
+	// uv:       R16G16_UNORM, dequantized with MeshHeader::uvScale/uvOffset
+	struct PackedVertex
+	{
+		int16_t position[4];
+		int16_t normal[2];
+		uint16_t uv[2];
+	};
+	static_assert(sizeof(PackedVertex) == 16, "PackedVertex layout changed");
+
+	struct MeshHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t vertexCount;
+		uint32_t indexCount;
+		uint32_t vertexStride;
+		MeshIndexType indexType;
+		uint64_t vertexOffset;
+		uint64_t indexOffset;
+		uint64_t indexSize;
+		float positionScale[3];
+		float positionOffset[3];
+		float uvScale[2];
+		float uvOffset[2];
+		uint32_t reserved[2];
+	};
+	static_assert(sizeof(MeshHeader) == 96, "MeshHeader layout changed");
+
+	// true if the streams described by the header are non-empty, have the expected layout and lie within a file of fileSize bytes.
+	// Offsets and sizes are untrusted 64 bit values, so every range is checked by subtraction and cannot wrap around.
+	inline bool IsMeshLayoutValid(const MeshHeader& header, uint64_t fileSize)
+	{
+		if (header.vertexCount == 0 || header.indexCount == 0 || header.vertexStride != sizeof(PackedVertex) || (header.indexType != MeshIndexType::UInt16 && header.indexType != MeshIndexType::UInt32))
+			return false;
+
+		const uint64_t indexBytes = header.indexType == MeshIndexType::UInt16 ? 2 : 4;
+		const uint64_t vertexBytes = static_cast<uint64_t>(header.vertexCount) * header.vertexStride;
+		return header.indexSize == header.indexCount * indexBytes
+			&& header.vertexOffset >= sizeof(MeshHeader) && header.vertexOffset <= header.indexOffset
+			&& vertexBytes <= header.indexOffset - header.vertexOffset
+			&& header.indexSize <= fileSize && header.indexOffset <= fileSize - header.indexSize;
+	}
+}
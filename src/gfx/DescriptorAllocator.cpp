@@ -0,0 +1,309 @@
+#include "DescriptorAllocator.hpp"
+#include <algorithm>
+#include <cstring>
+#include "../utils/Hash.hpp"
+
+static_assert(sizeof(DescriptorResource) == 56, "DescriptorResource is hashed bytewise and must not contain padding");
+
+namespace
+{
+	// descriptors per set reserved in every pool, pools are shared by all layouts
+	const std::pair<vk::DescriptorType, float> POOL_RATIOS[] =
+	{
+		{ vk::DescriptorType::eSampler, 0.5f },
+		{ vk::DescriptorType::eCombinedImageSampler, 4.f },
+		{ vk::DescriptorType::eSampledImage, 4.f },
+		{ vk::DescriptorType::eStorageImage, 1.f },
+		{ vk::DescriptorType::eUniformBuffer, 2.f },
+		{ vk::DescriptorType::eStorageBuffer, 2.f },
+		{ vk::DescriptorType::eUniformBufferDynamic, 1.f },
+		{ vk::DescriptorType::eStorageBufferDynamic, 1.f },
+		{ vk::DescriptorType::eInputAttachment, 0.5f }
+	};
+
+	bool isImageDescriptor(vk::DescriptorType type)
+	{
+		return type == vk::DescriptorType::eSampler || type == vk::DescriptorType::eCombinedImageSampler || type == vk::DescriptorType::eSampledImage
+			|| type == vk::DescriptorType::eStorageImage || type == vk::DescriptorType::eInputAttachment;
+	}
+
+	bool isBufferDescriptor(vk::DescriptorType type)
+	{
+		return type == vk::DescriptorType::eUniformBuffer || type == vk::DescriptorType::eStorageBuffer
+			|| type == vk::DescriptorType::eUniformBufferDynamic || type == vk::DescriptorType::eStorageBufferDynamic;
+	}
+
+	uint64_t hashResources(vk::DescriptorSetLayout layout, const std::vector<DescriptorResource>& resources)
+	{
+		const auto hash = vkp::HashBytes(&layout, sizeof(layout));
+		return vkp::HashBytes(resources.data(), resources.size() * sizeof(DescriptorResource), hash);
+	}
+
+	bool sameResources(const std::vector<DescriptorResource>& a, const std::vector<DescriptorResource>& b)
+	{
+		return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(DescriptorResource)) == 0;
+	}
+}
+
+DescriptorResource DescriptorResource::Image(uint32_t binding, vk::DescriptorType type, vk::Sampler sampler, vk::ImageView view, vk::ImageLayout layout)
+{
+	DescriptorResource resource = {};
+	resource.binding = binding;
+	resource.type = type;
+	resource.imageLayout = layout;
+	resource.sampler = sampler;
+	resource.imageView = view;
+	return resource;
+}
+
+DescriptorResource DescriptorResource::Buffer(uint32_t binding, vk::DescriptorType type, vk::Buffer buffer, vk::DeviceSize offset, vk::DeviceSize range)
+{
+	DescriptorResource resource = {};
+	resource.binding = binding;
+	resource.type = type;
+	resource.buffer = buffer;
+	resource.offset = offset;
+	resource.range = range;
+	return resource;
+}
+
+size_t DescriptorLayoutCache::BindingsHash::operator()(const std::vector<vk::DescriptorSetLayoutBinding>& bindings) const
+{
+	const auto count = bindings.size();
+	auto hash = vkp::HashBytes(&count, sizeof(count));
+	for (const auto& binding : bindings)
+	{
+		const uint32_t fields[] = { binding.binding, static_cast<uint32_t>(binding.descriptorType), binding.descriptorCount, static_cast<uint32_t>(binding.stageFlags) };
+		hash = vkp::HashBytes(fields, sizeof(fields), hash);
+	}
+	return static_cast<size_t>(hash);
+}
+
+DescriptorLayoutCache::DescriptorLayoutCache(vk::Device device)
+	: device(device)
+{
+}
+
+DescriptorLayoutCache::~DescriptorLayoutCache()
+{
+	for (auto& layout : this->layouts)
+		this->device.destroyDescriptorSetLayout(layout.second);
+	this->layouts.clear();
+}
+
+vk::DescriptorSetLayout DescriptorLayoutCache::Get(std::vector<vk::DescriptorSetLayoutBinding> bindings)
+{
+	std::sort(bindings.begin(), bindings.end(), [](const vk::DescriptorSetLayoutBinding& a, const vk::DescriptorSetLayoutBinding& b) { return a.binding < b.binding; });
+	std::lock_guard<std::mutex> lock(this->mutex);
+	this->stats.requests++;
+
+	const auto found = this->layouts.find(bindings);
+	if (found != this->layouts.end())
+	{
+		this->stats.hits++;
+		return found->second;
+	}
+
+	const auto layout = this->device.createDescriptorSetLayout(vk::DescriptorSetLayoutCreateInfo({}, static_cast<uint32_t>(bindings.size()), bindings.data()));
+	this->layouts.emplace(std::move(bindings), layout);
+	this->stats.layouts++;
+	return layout;
+}
+
+DescriptorLayoutCacheStats DescriptorLayoutCache::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	return this->stats;
+}
+
+DescriptorAllocator::DescriptorAllocator(vk::Device device, uint32_t framesInFlight, uint32_t setsPerPool)
+	: device(device), setsPerPool(setsPerPool), frames(framesInFlight)
+{
+}
+
+DescriptorAllocator::~DescriptorAllocator()
+{
+	for (auto& frame : this->frames)
+	{
+		for (auto& pool : frame.pools)
+			this->device.destroyDescriptorPool(pool);
+	}
+	this->frames.clear();
+
+	for (auto& pool : this->freePools)
+		this->device.destroyDescriptorPool(pool);
+	this->freePools.clear();
+
+	// destroying the pools frees the cached sets
+	for (auto& pool : this->cachePools)
+		this->device.destroyDescriptorPool(pool);
+	this->cachePools.clear();
+	this->sets.clear();
+}
+
+vk::DescriptorPool DescriptorAllocator::CreatePool(vk::DescriptorPoolCreateFlags flags)
+{
+	std::vector<vk::DescriptorPoolSize> sizes;
+	for (const auto& ratio : POOL_RATIOS)
+		sizes.emplace_back(ratio.first, std::max(static_cast<uint32_t>(ratio.second * this->setsPerPool), 1u));
+
+	this->stats.pools++;
+	return this->device.createDescriptorPool(vk::DescriptorPoolCreateInfo(flags, this->setsPerPool, static_cast<uint32_t>(sizes.size()), sizes.data()));
+}
+
+vk::DescriptorPool DescriptorAllocator::AcquirePool()
+{
+	this->stats.poolsInUse++;
+	if (!this->freePools.empty())
+	{
+		const auto pool = this->freePools.back();
+		this->freePools.pop_back();
+		return pool;
+	}
+
+	return this->CreatePool({});
+}
+
+void DescriptorAllocator::BeginFrame(uint32_t frameIndex)
+{
+	this->currentFrame = frameIndex;
+	auto& frame = this->frames[frameIndex];
+	for (auto& pool : frame.pools)
+	{
+		this->device.resetDescriptorPool(pool, {});
+		this->freePools.push_back(pool);
+		this->stats.resets++;
+	}
+	this->stats.poolsInUse -= static_cast<uint32_t>(frame.pools.size());
+	frame.pools.clear();
+
+	// a set unused for as many frames as are in flight is no longer referenced by the GPU, and until then its resources are alive
+	this->frameNumber++;
+	const auto framesInFlight = static_cast<uint64_t>(this->frames.size());
+	for (auto it = this->sets.begin(); it != this->sets.end();)
+	{
+		if (it->second.lastUsed + framesInFlight > this->frameNumber)
+		{
+			++it;
+			continue;
+		}
+
+		this->device.freeDescriptorSets(it->second.pool, it->second.set);
+		it = this->sets.erase(it);
+		this->stats.evictions++;
+	}
+	this->stats.cachedSets = static_cast<uint32_t>(this->sets.size());
+}
+
+void DescriptorAllocator::Invalidate()
+{
+	for (auto& pool : this->cachePools)
+		this->device.resetDescriptorPool(pool, {});
+	this->stats.evictions += this->sets.size();
+	this->stats.cachedSets = 0;
+	this->sets.clear();
+}
+
+vk::DescriptorSet DescriptorAllocator::Allocate(vk::DescriptorSetLayout layout)
+{
+	auto& frame = this->frames[this->currentFrame];
+	if (frame.pools.empty())
+		frame.pools.push_back(this->AcquirePool());
+
+	vk::DescriptorSet set;
+	vk::DescriptorSetAllocateInfo allocateInfo(frame.pools.back(), 1, &layout);
+	auto result = this->device.allocateDescriptorSets(&allocateInfo, &set);
+
+	// the pool is exhausted, continue with the next one
+	if (result == vk::Result::eErrorOutOfPoolMemory || result == vk::Result::eErrorFragmentedPool)
+	{
+		frame.pools.push_back(this->AcquirePool());
+		allocateInfo.descriptorPool = frame.pools.back();
+		result = this->device.allocateDescriptorSets(&allocateInfo, &set);
+	}
+
+	if (result != vk::Result::eSuccess)
+		throw std::exception("Unable to allocate descriptor set");
+
+	this->stats.allocations++;
+	return set;
+}
+
+vk::DescriptorSet DescriptorAllocator::AllocateCached(vk::DescriptorSetLayout layout, vk::DescriptorPool& pool)
+{
+	// evicted sets leave holes in every cache pool, the newest pool is the most likely to have room
+	vk::DescriptorSet set;
+	for (auto it = this->cachePools.rbegin(); it != this->cachePools.rend(); ++it)
+	{
+		const vk::DescriptorSetAllocateInfo allocateInfo(*it, 1, &layout);
+		const auto result = this->device.allocateDescriptorSets(&allocateInfo, &set);
+		if (result == vk::Result::eSuccess)
+		{
+			pool = *it;
+			this->stats.allocations++;
+			return set;
+		}
+		if (result != vk::Result::eErrorOutOfPoolMemory && result != vk::Result::eErrorFragmentedPool)
+			throw std::exception("Unable to allocate descriptor set");
+	}
+
+	this->cachePools.push_back(this->CreatePool(vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet));
+	this->stats.cachePools++;
+	pool = this->cachePools.back();
+
+	const vk::DescriptorSetAllocateInfo allocateInfo(pool, 1, &layout);
+	if (this->device.allocateDescriptorSets(&allocateInfo, &set) != vk::Result::eSuccess)
+		throw std::exception("Unable to allocate descriptor set");
+
+	this->stats.allocations++;
+	return set;
+}
+
+vk::DescriptorSet DescriptorAllocator::GetSet(vk::DescriptorSetLayout layout, const std::vector<DescriptorResource>& resources)
+{
+	const auto hash = hashResources(layout, resources);
+	this->stats.requests++;
+
+	const auto range = this->sets.equal_range(hash);
+	for (auto it = range.first; it != range.second; ++it)
+	{
+		if (it->second.layout == layout && sameResources(it->second.resources, resources))
+		{
+			it->second.lastUsed = this->frameNumber;
+			this->stats.hits++;
+			return it->second.set;
+		}
+	}
+
+	vk::DescriptorPool pool;
+	const auto set = this->AllocateCached(layout, pool);
+
+	// the info arrays are sized up front, writes point into them
+	this->writes.clear();
+	this->imageInfos.clear();
+	this->bufferInfos.clear();
+	this->imageInfos.reserve(resources.size());
+	this->bufferInfos.reserve(resources.size());
+	for (const auto& resource : resources)
+	{
+		if (isImageDescriptor(resource.type))
+		{
+			this->imageInfos.emplace_back(resource.sampler, resource.imageView, resource.imageLayout);
+			this->writes.emplace_back(set, resource.binding, 0, 1, resource.type, &this->imageInfos.back(), nullptr, nullptr);
+		}
+		else if (isBufferDescriptor(resource.type))
+		{
+			this->bufferInfos.emplace_back(resource.buffer, resource.offset, resource.range);
+			this->writes.emplace_back(set, resource.binding, 0, 1, resource.type, nullptr, &this->bufferInfos.back(), nullptr);
+		}
+		else
+		{
+			throw std::exception("Unsupported descriptor type");
+		}
+	}
+	this->device.updateDescriptorSets(this->writes, nullptr);
+
+	this->sets.emplace(hash, CachedSet{ layout, resources, set, pool, this->frameNumber });
+	this->stats.cachedSets = static_cast<uint32_t>(this->sets.size());
+	return set;
+}
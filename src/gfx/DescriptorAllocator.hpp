@@ -0,0 +1,130 @@
+#pragma once
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+// A resource bound to one binding of a descriptor set. Hashed bytewise, so it is always fully zero initialized.
+struct DescriptorResource
+{
+	uint32_t binding;
+	vk::DescriptorType type;
+	vk::ImageLayout imageLayout;
+	uint32_t reserved;
+	vk::Sampler sampler;
+	vk::ImageView imageView;
+	vk::Buffer buffer;
+	vk::DeviceSize offset;
+	vk::DeviceSize range;
+
+	static DescriptorResource Image(uint32_t binding, vk::DescriptorType type, vk::Sampler sampler, vk::ImageView view, vk::ImageLayout layout);
+	static DescriptorResource Buffer(uint32_t binding, vk::DescriptorType type, vk::Buffer buffer, vk::DeviceSize offset, vk::DeviceSize range);
+};
+
+struct DescriptorLayoutCacheStats
+{
+	uint32_t layouts;
+	uint64_t requests;
+	uint64_t hits;
+};
+
+struct DescriptorAllocatorStats
+{
+	uint32_t pools;          // pools created so far
+	uint32_t poolsInUse;     // pools holding sets of frames in flight
+	uint64_t allocations;    // sets allocated and written
+	uint64_t requests;       // GetSet calls
+	uint64_t hits;           // GetSet calls answered from the set cache
+	uint64_t resets;         // pool resets
+	uint32_t cachePools;     // pools holding cached sets
+	uint32_t cachedSets;     // sets currently in the cache
+	uint64_t evictions;      // cached sets freed after going unused
+};
+
+// Creates every distinct descriptor set layout once, keyed by its bindings. Layouts live as long as the cache.
+// Get may be called from several threads.
+class DescriptorLayoutCache
+{
+	struct BindingsHash
+	{
+		size_t operator()(const std::vector<vk::DescriptorSetLayoutBinding>& bindings) const;
+	};
+
+	vk::Device device;
+	mutable std::mutex mutex;
+	std::unordered_map<std::vector<vk::DescriptorSetLayoutBinding>, vk::DescriptorSetLayout, BindingsHash> layouts;
+	DescriptorLayoutCacheStats stats = {};
+
+public:
+	explicit DescriptorLayoutCache(vk::Device device);
+	~DescriptorLayoutCache();
+
+	DescriptorLayoutCache(const DescriptorLayoutCache&) = delete;
+	DescriptorLayoutCache& operator=(const DescriptorLayoutCache&) = delete;
+
+	// the order of the bindings does not matter
+	vk::DescriptorSetLayout Get(std::vector<vk::DescriptorSetLayoutBinding> bindings);
+
+	DescriptorLayoutCacheStats GetStats() const;
+};
+
+// Allocates transient descriptor sets that are valid for one frame and caches written sets across frames.
+// Every frame in flight grows its own list of pools for Allocate, which are reset in bulk by BeginFrame once the fence of that
+// frame slot signaled and go back to a shared free list. GetSet caches sets by layout and bound resources in separate pools
+// and frees them once they went unused for as many frames as are in flight, so a set is written once for as long as its
+// resources do not change. Resources may therefore only be destroyed that many frames after their last use, as the deferred
+// frees of MemoryAllocator and TexturePool do, or after Invalidate.
+class DescriptorAllocator
+{
+	struct CachedSet
+	{
+		vk::DescriptorSetLayout layout;
+		std::vector<DescriptorResource> resources;
+		vk::DescriptorSet set;
+		vk::DescriptorPool pool;
+		uint64_t lastUsed;      // frame
+	};
+
+	struct Frame
+	{
+		std::vector<vk::DescriptorPool> pools;  // the last pool is the one allocated from
+	};
+
+	vk::Device device;
+	uint32_t setsPerPool;
+	std::vector<Frame> frames;
+	std::vector<vk::DescriptorPool> freePools;
+	std::vector<vk::DescriptorPool> cachePools;
+	std::unordered_multimap<uint64_t, CachedSet> sets;
+	std::vector<vk::WriteDescriptorSet> writes;
+	std::vector<vk::DescriptorImageInfo> imageInfos;
+	std::vector<vk::DescriptorBufferInfo> bufferInfos;
+	DescriptorAllocatorStats stats = {};
+	uint32_t currentFrame = 0;
+	uint64_t frameNumber = 0;
+
+	vk::DescriptorPool CreatePool(vk::DescriptorPoolCreateFlags flags);
+	vk::DescriptorPool AcquirePool();
+	vk::DescriptorSet AllocateCached(vk::DescriptorSetLayout layout, vk::DescriptorPool& pool);
+
+public:
+	DescriptorAllocator(vk::Device device, uint32_t framesInFlight, uint32_t setsPerPool = 256);
+	~DescriptorAllocator();
+
+	DescriptorAllocator(const DescriptorAllocator&) = delete;
+	DescriptorAllocator& operator=(const DescriptorAllocator&) = delete;
+
+	// the GPU has to be done with the sets of this frame slot, i.e. its fence signaled
+	void BeginFrame(uint32_t frameIndex);
+
+	// frees every cached set, the device has to be idle. Needed before resources are destroyed without deferral.
+	void Invalidate();
+
+	// uninitialized set from the pools of the current frame
+	vk::DescriptorSet Allocate(vk::DescriptorSetLayout layout);
+
+	// set with the given resources written, reused while the same layout and resources are requested in consecutive frames
+	vk::DescriptorSet GetSet(vk::DescriptorSetLayout layout, const std::vector<DescriptorResource>& resources);
+
+	const DescriptorAllocatorStats& GetStats() const { return this->stats; }
+};
@@ -0,0 +1,56 @@
+#include "DynamicResolution.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	// the scene gets 90% of the budget, the rest is left for the upscale and frame to frame noise
+	const float BUDGET_HEADROOM = 0.9f;
+	const uint32_t RECOVER_DELAY_FRAMES = 30;
+	const float MAX_RECOVER_STEP = 0.02f;
+	const float FILTER_WEIGHT = 0.25f;
+}
+
+DynamicResolution::DynamicResolution(float targetFrameTime, float minScale, float maxScale)
+	: targetFrameTime(targetFrameTime), minScale(minScale), maxScale(maxScale), scale(maxScale)
+{
+}
+
+void DynamicResolution::Update(float gpuFrameTime, float renderScale)
+{
+	if (gpuFrameTime <= 0.f || renderScale <= 0.f)
+		return;
+
+	this->frameTime = gpuFrameTime;
+
+	// spikes bypass the filter so the resolution drops in the frame right after the spike
+	const auto budget = this->targetFrameTime * BUDGET_HEADROOM;
+	const auto cost = gpuFrameTime / (renderScale * renderScale);
+	if (this->fullResolutionCost == 0.f || gpuFrameTime > budget)
+		this->fullResolutionCost = cost;
+	else
+		this->fullResolutionCost += (cost - this->fullResolutionCost) * FILTER_WEIGHT;
+
+	const auto desiredScale = std::clamp(std::sqrt(budget / this->fullResolutionCost), this->minScale, this->maxScale);
+	if (desiredScale <= this->scale)
+	{
+		this->scale = desiredScale;
+		this->underBudgetFrames = 0;
+		return;
+	}
+
+	// only grow once the frame time has been within budget for a while
+	if (++this->underBudgetFrames >= RECOVER_DELAY_FRAMES)
+		this->scale = std::min(desiredScale, this->scale + MAX_RECOVER_STEP);
+}
+
+void DynamicResolution::SetScale(float scale)
+{
+	this->scale = std::clamp(scale, this->minScale, this->maxScale);
+}
+
+void DynamicResolution::Apply(uint32_t width, uint32_t height, uint32_t& scaledWidth, uint32_t& scaledHeight) const
+{
+	scaledWidth = std::max(static_cast<uint32_t>(std::lround(width * this->scale)), 1u);
+	scaledHeight = std::max(static_cast<uint32_t>(std::lround(height * this->scale)), 1u);
+}
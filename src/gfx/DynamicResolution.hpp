@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+
+// Picks the render resolution scale from measured GPU frame times.
+// GPU time is assumed to scale with the number of shaded pixels, so every measurement is normalized to the cost of a
+// full resolution frame and the scale is the square root of the ratio between budget and that cost. Over budget the
+// scale drops right away to hold the frame rate, under budget it only recovers in small steps after a delay so it does
+// not oscillate around the budget.
+class DynamicResolution
+{
+	float targetFrameTime;
+	float minScale;
+	float maxScale;
+	float scale;
+	float fullResolutionCost = 0.f;
+	float frameTime = 0.f;
+	uint32_t underBudgetFrames = 0;
+
+public:
+	DynamicResolution(float targetFrameTime, float minScale = 0.5f, float maxScale = 1.f);
+
+	// gpuFrameTime in milliseconds for a frame that was rendered at renderScale, frames in flight lag behind GetScale
+	void Update(float gpuFrameTime, float renderScale);
+
+	float GetScale() const { return this->scale; }
+	// overrides the measured scale until the next Update, clamped to the scale range
+	void SetScale(float scale);
+	float GetFrameTime() const { return this->frameTime; }
+	float GetTargetFrameTime() const { return this->targetFrameTime; }
+	void SetTargetFrameTime(float targetFrameTime) { this->targetFrameTime = targetFrameTime; }
+
+	// scaled extent, never smaller than one pixel
+	void Apply(uint32_t width, uint32_t height, uint32_t& scaledWidth, uint32_t& scaledHeight) const;
+};
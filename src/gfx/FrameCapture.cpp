@@ -0,0 +1,124 @@
+#include "FrameCapture.hpp"
+#include <cstddef>
+#include <exception>
+#include <spdlog/spdlog.h>
+#include "../utils/Lz4.hpp"
+
+using namespace vkp::trace;
+
+FrameCapture::FrameCapture(const std::string& filename, const RenderSessionSettings& settings, uint64_t firstFrame, uint64_t maxFrames,
+	const std::vector<TraceWindow>& windows)
+	: filename(filename), file(filename, std::ios::binary | std::ios::trunc), start(Clock::now()), maxFrames(maxFrames)
+{
+	if (this->file.fail())
+		throw std::exception(std::string("unable to open " + filename).c_str());
+
+	// the frame count is patched in by Finish, a trace that was cut short still replays up to its last complete record
+	TraceHeader header = {};
+	header.magic = TraceMagic;
+	header.version = TraceVersion;
+	header.windowCount = static_cast<uint32_t>(windows.size());
+	header.firstFrame = firstFrame;
+	header.settings.dynamicResolution = settings.dynamicResolution;
+	header.settings.depthPrepass = settings.depthPrepass;
+	header.settings.sceneInstances = settings.sceneInstances;
+	header.settings.pipelineStatistics = settings.pipelineStatistics;
+	header.settings.lightCount = settings.lightCount;
+	header.settings.postProcess = settings.postProcess;
+
+	this->file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	this->file.write(reinterpret_cast<const char*>(windows.data()), windows.size() * sizeof(TraceWindow));
+}
+
+uint64_t FrameCapture::GetTimestamp() const
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - this->start).count();
+}
+
+void FrameCapture::WriteRecord(TraceRecordType type, const void* data, size_t size, const void* extra, size_t extraSize)
+{
+	const TraceRecord record = { type, static_cast<uint32_t>(size + extraSize) };
+	this->file.write(reinterpret_cast<const char*>(&record), sizeof(record));
+	this->file.write(static_cast<const char*>(data), size);
+	if (extraSize > 0)
+		this->file.write(static_cast<const char*>(extra), extraSize);
+}
+
+void FrameCapture::WriteFrame(const FrameSnapshot& snapshot, uint64_t timestamp, float drawMilliseconds, float gpuMilliseconds,
+	const std::vector<TraceWindowFrame>& windows)
+{
+	TraceFrame frame = {};
+	frame.frame = snapshot.frame;
+	frame.timestamp = timestamp;
+	frame.time = snapshot.time;
+	frame.deltaTime = snapshot.deltaTime;
+	frame.cameraPosition[0] = snapshot.cameraPosition.x;
+	frame.cameraPosition[1] = snapshot.cameraPosition.y;
+	frame.cameraPosition[2] = snapshot.cameraPosition.z;
+	frame.cameraTarget[0] = snapshot.cameraTarget.x;
+	frame.cameraTarget[1] = snapshot.cameraTarget.y;
+	frame.cameraTarget[2] = snapshot.cameraTarget.z;
+	frame.meshRotation = snapshot.meshRotation;
+	frame.drawMilliseconds = drawMilliseconds;
+	frame.gpuMilliseconds = gpuMilliseconds;
+	frame.windowCount = static_cast<uint32_t>(windows.size());
+
+	this->WriteRecord(TraceRecordType::Frame, &frame, sizeof(frame), windows.data(), windows.size() * sizeof(TraceWindowFrame));
+	this->frameCount++;
+}
+
+void FrameCapture::WriteResize(const TraceResize& resize)
+{
+	this->WriteRecord(TraceRecordType::Resize, &resize, sizeof(resize));
+}
+
+void FrameCapture::Finish(const vkp::assets::AssetArchive& assets)
+{
+	// entries that are already compressed in the archive are compressed again from their contents, the trace is self contained
+	uint32_t assetCount = 0;
+	uint64_t assetBytes = 0;
+	std::vector<uint8_t> compressed;
+	std::vector<char> payload;
+	for (uint32_t i = 0; i < assets.GetEntryCount(); i++)
+	{
+		if (!assets.WasAccessed(i))
+			continue;
+
+		const auto& entry = assets.GetEntry(i);
+		const auto name = assets.GetName(entry);
+		const auto data = assets.Get(entry);
+
+		TraceAsset asset = {};
+		asset.type = static_cast<uint32_t>(entry.type);
+		asset.nameLength = static_cast<uint32_t>(name.size());
+		asset.size = data.size;
+		asset.storedSize = data.size;
+		const uint8_t* stored = data.data;
+
+		compressed.resize(vkp::lz4::CompressBound(data.size));
+		const auto compressedSize = data.size > 0 ? vkp::lz4::Compress(data.data, data.size, compressed.data(), compressed.size()) : 0;
+		if (compressedSize > 0 && compressedSize < data.size)
+		{
+			asset.flags |= TraceAssetFlagLz4;
+			asset.storedSize = compressedSize;
+			stored = compressed.data();
+		}
+
+		payload.assign(name.begin(), name.end());
+		payload.insert(payload.end(), reinterpret_cast<const char*>(stored), reinterpret_cast<const char*>(stored) + asset.storedSize);
+		this->WriteRecord(TraceRecordType::Asset, &asset, sizeof(asset), payload.data(), payload.size());
+		assetCount++;
+		assetBytes += asset.storedSize;
+	}
+
+	const TraceRecord end = { TraceRecordType::End, 0 };
+	this->file.write(reinterpret_cast<const char*>(&end), sizeof(end));
+
+	this->file.seekp(offsetof(TraceHeader, frameCount));
+	this->file.write(reinterpret_cast<const char*>(&this->frameCount), sizeof(this->frameCount));
+	this->file.close();
+	if (this->file.fail())
+		throw std::exception(std::string("unable to write " + this->filename).c_str());
+
+	spdlog::get("logger")->info("Captured {0} frames to {1}, {2} assets ({3:.1f} MiB)", this->frameCount, this->filename, assetCount, assetBytes / (1024.0 * 1024.0));
+}
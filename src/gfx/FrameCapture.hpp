@@ -0,0 +1,54 @@
+#pragma once
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "../assets/AssetArchive.hpp"
+#include "FrameSnapshot.hpp"
+#include "FrameTraceFormat.hpp"
+#include "RenderSession.hpp"
+
+struct FrameCaptureSettings
+{
+	std::string filename = "trace.vkpt";
+	uint64_t firstFrame = 0;     // frame number of the first window to start at
+	uint64_t frameCount = 0;     // 0 disables the capture
+};
+
+// Writes the renderer level work of a window of frames into a trace (src/gfx/FrameTraceFormat.hpp): the snapshot every Draw
+// rendered with the resolution and the draws and binds it recorded, the swap chain changes of Resize and finally the assets the
+// device read. Sessions record their frames from exactly these inputs, so FrameReplay renders the same work headlessly.
+class FrameCapture
+{
+	using Clock = std::chrono::high_resolution_clock;
+
+	std::string filename;
+	std::ofstream file;
+	Clock::time_point start;
+	uint64_t maxFrames;
+	uint64_t frameCount = 0;
+
+	void WriteRecord(vkp::trace::TraceRecordType type, const void* data, size_t size, const void* extra = nullptr, size_t extraSize = 0);
+
+public:
+	// writes the header, windows holds the swap chain state of every window at firstFrame
+	FrameCapture(const std::string& filename, const RenderSessionSettings& settings, uint64_t firstFrame, uint64_t maxFrames,
+		const std::vector<vkp::trace::TraceWindow>& windows);
+
+	FrameCapture(const FrameCapture&) = delete;
+	FrameCapture& operator=(const FrameCapture&) = delete;
+
+	// nanoseconds since the capture started
+	uint64_t GetTimestamp() const;
+
+	void WriteFrame(const FrameSnapshot& snapshot, uint64_t timestamp, float drawMilliseconds, float gpuMilliseconds,
+		const std::vector<vkp::trace::TraceWindowFrame>& windows);
+	void WriteResize(const vkp::trace::TraceResize& resize);
+
+	// embeds every asset read so far, completes the header and closes the file
+	void Finish(const vkp::assets::AssetArchive& assets);
+
+	bool IsComplete() const { return this->frameCount >= this->maxFrames; }
+	uint64_t GetFrameCount() const { return this->frameCount; }
+	const std::string& GetFilename() const { return this->filename; }
+};
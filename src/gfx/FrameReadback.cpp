@@ -0,0 +1,126 @@
+#include "FrameReadback.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace
+{
+	bool isBgra(vk::Format format)
+	{
+		return format == vk::Format::eB8G8R8A8Unorm || format == vk::Format::eB8G8R8A8Srgb;
+	}
+
+	bool isRgba(vk::Format format)
+	{
+		return format == vk::Format::eR8G8B8A8Unorm || format == vk::Format::eR8G8B8A8Srgb;
+	}
+
+	void bgraToRgba(const uint8_t* source, uint8_t* destination, size_t pixelCount)
+	{
+		// swaps the red and blue byte of every little endian pixel word
+		for (size_t i = 0; i < pixelCount; i++)
+		{
+			uint32_t pixel;
+			std::memcpy(&pixel, source + i * 4, 4);
+			pixel = (pixel & 0xFF00FF00u) | ((pixel >> 16) & 0xFFu) | ((pixel & 0xFFu) << 16);
+			std::memcpy(destination + i * 4, &pixel, 4);
+		}
+	}
+}
+
+FrameReadback::FrameReadback(MemoryAllocator& allocator, uint32_t framesInFlight, vk::Format format, ReadbackCallback callback)
+	: allocator(allocator), callback(std::move(callback)), slots(framesInFlight)
+{
+	if (!isBgra(format) && !isRgba(format))
+		throw std::exception("Frame readback only supports 8 bit RGBA and BGRA formats");
+	this->swizzle = isBgra(format);
+
+	// cached memory makes the CPU reads fast, coherent memory is the fallback if the device has no cached type
+	const auto cached = vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCached;
+	this->memoryProperties = this->allocator.SupportsMemoryProperties(cached) ? cached : vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent;
+}
+
+FrameReadback::~FrameReadback()
+{
+	for (auto& slot : this->slots)
+	{
+		if (slot.buffer)
+			this->allocator.Destroy(slot.allocation);
+	}
+	this->slots.clear();
+}
+
+void FrameReadback::Record(vk::CommandBuffer commandBuffer, uint32_t frameIndex, uint64_t frame, vk::Image image, vk::Extent2D extent)
+{
+	auto& slot = this->slots[frameIndex];
+	const vk::DeviceSize size = static_cast<vk::DeviceSize>(extent.width) * extent.height * 4;
+
+	// the slot was delivered after its fence signaled, so the old buffer is idle and can be replaced right away
+	if (slot.size < size)
+	{
+		if (slot.buffer)
+			this->allocator.Destroy(slot.allocation);
+		slot.buffer = this->allocator.CreateBuffer(vk::BufferCreateInfo({}, size, vk::BufferUsageFlagBits::eTransferDst, vk::SharingMode::eExclusive),
+			this->memoryProperties, slot.allocation);
+		slot.size = size;
+	}
+
+	const vk::BufferImageCopy region(0, 0, 0, vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, 0, 0, 1), { 0, 0, 0 }, { extent.width, extent.height, 1 });
+	commandBuffer.copyImageToBuffer(image, vk::ImageLayout::eTransferSrcOptimal, slot.buffer, region);
+
+	const vk::BufferMemoryBarrier toHost(vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eHostRead,
+		VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, slot.buffer, 0, size);
+	commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eHost, {}, nullptr, toHost, nullptr);
+
+	slot.pending = true;
+	slot.frame = frame;
+	slot.width = extent.width;
+	slot.height = extent.height;
+}
+
+void FrameReadback::Deliver(uint32_t frameIndex)
+{
+	auto& slot = this->slots[frameIndex];
+	if (slot.pending)
+		this->DeliverSlot(slot);
+}
+
+void FrameReadback::DeliverAll()
+{
+	std::vector<Slot*> pending;
+	for (auto& slot : this->slots)
+	{
+		if (slot.pending)
+			pending.push_back(&slot);
+	}
+
+	std::sort(pending.begin(), pending.end(), [](const Slot* a, const Slot* b) { return a->frame < b->frame; });
+	for (auto slot : pending)
+		this->DeliverSlot(*slot);
+}
+
+void FrameReadback::DeliverSlot(Slot& slot)
+{
+	slot.pending = false;
+	this->allocator.InvalidateMappedData(slot.allocation);
+
+	const auto mapped = static_cast<const uint8_t*>(this->allocator.GetMappedData(slot.allocation));
+	const size_t pixelCount = static_cast<size_t>(slot.width) * slot.height;
+	const uint8_t* pixels = mapped;
+
+	if (this->swizzle)
+	{
+		const auto start = std::chrono::high_resolution_clock::now();
+		this->converted.resize(pixelCount * 4);
+		bgraToRgba(mapped, this->converted.data(), pixelCount);
+		pixels = this->converted.data();
+		this->stats.convertMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+
+	const auto start = std::chrono::high_resolution_clock::now();
+	this->callback({ slot.frame, slot.width, slot.height, pixels });
+	this->stats.callbackMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	this->stats.frames++;
+	this->stats.bytes += pixelCount * 4;
+}
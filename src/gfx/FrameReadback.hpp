@@ -0,0 +1,71 @@
+#pragma once
+#include <functional>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+#include "MemoryAllocator.hpp"
+
+struct ReadbackFrame
+{
+	uint64_t frame;
+	uint32_t width;
+	uint32_t height;
+	const uint8_t* pixels;  // tightly packed RGBA8 rows, only valid during the callback
+};
+
+using ReadbackCallback = std::function<void(const ReadbackFrame&)>;
+
+struct ReadbackStats
+{
+	uint64_t frames;
+	uint64_t bytes;
+	double convertMilliseconds;  // accumulated BGRA -> RGBA conversion
+	double callbackMilliseconds; // accumulated time spent in the consumer
+};
+
+// Copies finished frames into a ring of host cached staging buffers, one per frame in flight.
+// A frame is delivered to the callback once the fence of its frame slot signaled again, i.e. framesInFlight frames after
+// it was recorded, so capturing never stalls the GPU. The callback runs on the render thread and has to copy what it
+// keeps, long running consumers should hand the pixels to a worker.
+class FrameReadback
+{
+	struct Slot
+	{
+		vk::Buffer buffer;
+		AllocationHandle allocation;
+		vk::DeviceSize size;
+		bool pending;
+		uint64_t frame;
+		uint32_t width;
+		uint32_t height;
+	};
+
+	MemoryAllocator& allocator;
+	ReadbackCallback callback;
+	bool swizzle;
+	vk::MemoryPropertyFlags memoryProperties;
+	std::vector<Slot> slots;
+	std::vector<uint8_t> converted;
+	ReadbackStats stats = {};
+
+	void DeliverSlot(Slot& slot);
+
+public:
+	// format of the images that will be copied, has to be a 4 byte RGBA or BGRA format
+	FrameReadback(MemoryAllocator& allocator, uint32_t framesInFlight, vk::Format format, ReadbackCallback callback);
+	~FrameReadback();
+
+	FrameReadback(const FrameReadback&) = delete;
+	FrameReadback& operator=(const FrameReadback&) = delete;
+
+	// records the copy of the image, which has to be in eTransferSrcOptimal, into the staging buffer of the frame slot.
+	// Deliver has to be called for the slot before.
+	void Record(vk::CommandBuffer commandBuffer, uint32_t frameIndex, uint64_t frame, vk::Image image, vk::Extent2D extent);
+
+	// call once the fence of the frame slot signaled, hands the frame previously copied in this slot to the callback
+	void Deliver(uint32_t frameIndex);
+
+	// delivers every pending frame in order, the device has to be idle
+	void DeliverAll();
+
+	const ReadbackStats& GetStats() const { return this->stats; }
+};
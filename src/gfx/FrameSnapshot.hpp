@@ -0,0 +1,24 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "../utils/Math.hpp"
+
+struct WindowState
+{
+	uint32_t width;
+	uint32_t height;
+	bool minimized;
+};
+
+// Everything the renderer needs to know about a simulated frame.
+// Snapshots are written by the main thread and read by the render thread, so they must not point into simulation state.
+struct FrameSnapshot
+{
+	uint64_t frame;
+	double time;
+	float deltaTime;
+	std::vector<WindowState> windows;  // one per window, in the order they were passed to the renderer
+	vkp::math::Vec3 cameraPosition;
+	vkp::math::Vec3 cameraTarget;
+	float meshRotation;
+};
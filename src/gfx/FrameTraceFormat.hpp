@@ -0,0 +1,130 @@
+#pragma once
+#include <cstdint>
+
+// On disk layout of a frame capture (*.vkpt)
+//
+// [TraceHeader][TraceWindow * windowCount][record][record]...[TraceRecord End]
+//
+// Every record is a TraceRecord followed by `size` bytes of payload:
+//   Frame:  TraceFrame followed by TraceWindowFrame * windowCount
+//   Resize: TraceResize
+//   Asset:  TraceAsset followed by the name and `storedSize` bytes of data, LZ4 compressed if the flag is set
+// Asset records are written when the capture ends and contain every archive entry the device has read, so a replay needs
+// neither the application nor its asset archive. All values are little endian, structs are written as they are.
+namespace vkp::trace
+{
+	constexpr uint32_t TraceMagic = 0x54504B56; // "VKPT"
+	constexpr uint32_t TraceVersion = 1;
+
+	enum class TraceRecordType : uint32_t
+	{
+		End = 0,
+		Frame = 1,
+		Resize = 2,
+		Asset = 3
+	};
+
+	enum TraceAssetFlags : uint32_t
+	{
+		TraceAssetFlagNone = 0,
+		TraceAssetFlagLz4 = 1 << 0
+	};
+
+	// RenderSessionSettings of the captured renderer
+	struct TraceSettings
+	{
+		uint32_t dynamicResolution;
+		uint32_t depthPrepass;
+		uint32_t sceneInstances;
+		uint32_t pipelineStatistics;
+		uint32_t lightCount;
+		uint32_t postProcess;
+	};
+	static_assert(sizeof(TraceSettings) == 24, "TraceSettings layout changed");
+
+	struct TraceHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t windowCount;
+		uint32_t reserved;
+		uint64_t firstFrame;    // session frame number of the first window when the capture started
+		uint64_t frameCount;    // frame records, written when the capture ends
+		TraceSettings settings;
+	};
+	static_assert(sizeof(TraceHeader) == 56, "TraceHeader layout changed");
+
+	// state of a window when the capture started
+	struct TraceWindow
+	{
+		uint32_t format;        // vk::Format of the swap chain and the session targets
+		uint32_t presentMode;   // vk::PresentModeKHR
+		uint32_t width;         // swap chain extent, the session renders at the same size
+		uint32_t height;
+	};
+	static_assert(sizeof(TraceWindow) == 16, "TraceWindow layout changed");
+
+	struct TraceRecord
+	{
+		TraceRecordType type;
+		uint32_t size;
+	};
+	static_assert(sizeof(TraceRecord) == 8, "TraceRecord layout changed");
+
+	// one IRenderer::Draw call, the FrameSnapshot it rendered plus what it cost
+	struct TraceFrame
+	{
+		uint64_t frame;
+		uint64_t timestamp;          // nanoseconds since the capture started, at the start of Draw
+		double time;
+		float deltaTime;
+		float cameraPosition[3];
+		float cameraTarget[3];
+		float meshRotation;
+		float drawMilliseconds;      // CPU time of Draw
+		float gpuMilliseconds;       // GPU time of the last timed frame of the first window, lags a few frames behind
+		uint32_t windowCount;
+		uint32_t reserved;
+	};
+	static_assert(sizeof(TraceFrame) == 72, "TraceFrame layout changed");
+
+	// the work a window recorded in the frame, draws and binds count the depth pre-pass and the color pass together.
+	// Replays compare their own against it.
+	struct TraceWindowFrame
+	{
+		uint32_t width;
+		uint32_t height;
+		uint32_t minimized;
+		float renderScale;
+		uint32_t draws;
+		uint32_t pipelineBinds;
+		uint32_t descriptorBinds;
+		uint32_t bufferBinds;        // vertex and index buffers
+		uint64_t uploadedBytes;      // texture mip levels
+	};
+	static_assert(sizeof(TraceWindowFrame) == 40, "TraceWindowFrame layout changed");
+
+	// swap chain recreated by IRenderer::Resize
+	struct TraceResize
+	{
+		uint64_t timestamp;
+		uint32_t window;
+		uint32_t width;              // requested by the window
+		uint32_t height;
+		uint32_t swapChainWidth;     // extent the swap chain ended up with
+		uint32_t swapChainHeight;
+		uint32_t reserved;
+	};
+	static_assert(sizeof(TraceResize) == 32, "TraceResize layout changed");
+
+	struct TraceAsset
+	{
+		uint32_t type;               // vkp::assets::AssetType
+		uint32_t flags;              // TraceAssetFlags
+		uint32_t nameLength;
+		uint32_t reserved;
+		uint64_t size;               // uncompressed
+		uint64_t storedSize;
+	};
+	static_assert(sizeof(TraceAsset) == 32, "TraceAsset layout changed");
+}
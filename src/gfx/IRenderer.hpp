@@ -1,5 +1,19 @@
 #pragma once
+#include <vector>
 #include <SDL.h>
+#include "FrameSnapshot.hpp"
+
+// counters of the renderer since Initialize, read between Draw calls
+struct RendererStats
+{
+	uint64_t frames;                 // Draw calls that rendered
+	uint64_t timedFrames;            // frames of the first window with GPU timestamps, they arrive a few frames late
+	double lastGpuMilliseconds;      // of the last timed frame
+	uint64_t memoryAllocations;      // buffers and images created
+	uint64_t deviceMemoryAllocations;
+	uint64_t deviceMemoryBytes;      // currently held
+	uint64_t peakDeviceMemoryBytes;  // sum of the per session peaks
+};
 
 class IRenderer
 {
@@ -7,8 +21,11 @@ public:
 	IRenderer() {}
 	virtual ~IRenderer() { };
 
-	virtual void Initialize(SDL_Window* window) = 0;
-	virtual void Resize(SDL_Window* window, uint32_t width, uint32_t height) = 0;
-	virtual void Draw() = 0;
+	// renders to every window, FrameSnapshot::windows follows the same order
+	virtual void Initialize(const std::vector<SDL_Window*>& windows) = 0;
+	// called from the render thread, which owns the renderer after Initialize
+	virtual void Resize(size_t window, uint32_t width, uint32_t height) = 0;
+	virtual void Draw(const FrameSnapshot& snapshot) = 0;
+	virtual RendererStats GetStats() const = 0;
 };
 
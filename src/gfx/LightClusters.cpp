@@ -0,0 +1,156 @@
+#include "LightClusters.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+
+static_assert(sizeof(PointLight) == 32, "PointLight must match the std430 layout of the shaders");
+static_assert(sizeof(LightClusterParams) == 64, "LightClusterParams must match the std140 layout of the shaders");
+
+namespace
+{
+	const uint32_t CLUSTER_GRID_X = 16;
+	const uint32_t CLUSTER_GRID_Y = 9;
+	const uint32_t CLUSTER_GRID_Z = 24;
+	const uint32_t CULLING_GROUP_SIZE = 64;     // local_size_x of cluster_lights.comp
+	const uint32_t AVERAGE_LIGHTS_PER_CLUSTER = 32;
+	const float LIGHT_VOLUME = 4.f;             // half extent of the cube around the scene the lights are spread over
+	const float LIGHT_RADIUS = 3.f;             // radius at 16 lights, shrinks with more so a point is lit by a similar number of lights
+	const float LIGHT_INTENSITY = 0.6f;
+	const uint32_t LIGHT_SEED = 1234;
+}
+
+LightClusters::LightClusters(RenderDevice& renderDevice, MemoryAllocator& allocator, uint32_t framesInFlight, uint32_t lightCount)
+	: renderDevice(renderDevice), allocator(allocator)
+{
+	std::mt19937 random(LIGHT_SEED);
+	std::uniform_real_distribution<float> positionDistribution(-LIGHT_VOLUME, LIGHT_VOLUME);
+	std::uniform_real_distribution<float> colorDistribution(0.2f, 1.f);
+	std::uniform_real_distribution<float> speedDistribution(-1.f, 1.f);
+
+	const auto radius = LIGHT_RADIUS * std::cbrt(16.f / std::max(lightCount, 16u));
+	this->lights.resize(lightCount);
+	this->orbitSpeeds.resize(lightCount);
+	for (uint32_t i = 0; i < lightCount; i++)
+	{
+		auto& light = this->lights[i];
+		light.positionRadius[0] = positionDistribution(random);
+		light.positionRadius[1] = positionDistribution(random);
+		light.positionRadius[2] = positionDistribution(random);
+		light.positionRadius[3] = radius;
+		light.colorIntensity[0] = colorDistribution(random);
+		light.colorIntensity[1] = colorDistribution(random);
+		light.colorIntensity[2] = colorDistribution(random);
+		light.colorIntensity[3] = LIGHT_INTENSITY;
+		this->orbitSpeeds[i] = speedDistribution(random);
+	}
+
+	// the list holds a fixed number of indices per cluster on average, crowded clusters take the space of empty ones
+	this->indexCapacity = static_cast<vk::DeviceSize>(this->GetClusterCount()) * AVERAGE_LIGHTS_PER_CLUSTER;
+	const auto hostMemory = vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent;
+
+	this->frames.resize(framesInFlight);
+	for (auto& frame : this->frames)
+	{
+		frame.paramsBuffer = this->allocator.CreateBuffer(vk::BufferCreateInfo({}, sizeof(LightClusterParams), vk::BufferUsageFlagBits::eUniformBuffer, vk::SharingMode::eExclusive),
+			hostMemory, frame.paramsAllocation);
+		frame.lightBuffer = this->allocator.CreateBuffer(vk::BufferCreateInfo({}, sizeof(PointLight) * std::max(lightCount, 1u), vk::BufferUsageFlagBits::eStorageBuffer, vk::SharingMode::eExclusive),
+			hostMemory, frame.lightAllocation);
+		frame.clusterBuffer = this->allocator.CreateBuffer(vk::BufferCreateInfo({}, sizeof(uint32_t) * 2 * this->GetClusterCount(), vk::BufferUsageFlagBits::eStorageBuffer, vk::SharingMode::eExclusive),
+			vk::MemoryPropertyFlagBits::eDeviceLocal, frame.clusterAllocation);
+		frame.indexBuffer = this->allocator.CreateBuffer(vk::BufferCreateInfo({}, sizeof(uint32_t) * (1 + this->indexCapacity),
+			vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst, vk::SharingMode::eExclusive), vk::MemoryPropertyFlagBits::eDeviceLocal, frame.indexAllocation);
+	}
+}
+
+LightClusters::~LightClusters()
+{
+	for (auto& frame : this->frames)
+	{
+		this->allocator.Destroy(frame.paramsAllocation);
+		this->allocator.Destroy(frame.lightAllocation);
+		this->allocator.Destroy(frame.clusterAllocation);
+		this->allocator.Destroy(frame.indexAllocation);
+	}
+	this->frames.clear();
+}
+
+uint32_t LightClusters::GetClusterCount() const
+{
+	return CLUSTER_GRID_X * CLUSTER_GRID_Y * CLUSTER_GRID_Z;
+}
+
+void LightClusters::Update(uint32_t frameIndex, double time, const vkp::math::Mat4& projection, float zNear, float zFar, vk::Extent2D renderExtent)
+{
+	const auto& frame = this->frames[frameIndex];
+
+	// every light circles the y axis at its own speed
+	auto mapped = static_cast<PointLight*>(this->allocator.GetMappedData(frame.lightAllocation));
+	for (size_t i = 0; i < this->lights.size(); i++)
+	{
+		const auto& light = this->lights[i];
+		const auto angle = static_cast<float>(time * this->orbitSpeeds[i]);
+		const auto c = std::cos(angle);
+		const auto s = std::sin(angle);
+
+		PointLight moved = light;
+		moved.positionRadius[0] = c * light.positionRadius[0] + s * light.positionRadius[2];
+		moved.positionRadius[2] = -s * light.positionRadius[0] + c * light.positionRadius[2];
+		mapped[i] = moved;
+	}
+
+	// tiles cover the rendered area only, under dynamic resolution they shrink with it
+	const auto sliceRange = std::log(zFar / zNear);
+	LightClusterParams params = {};
+	params.grid[0] = CLUSTER_GRID_X;
+	params.grid[1] = CLUSTER_GRID_Y;
+	params.grid[2] = CLUSTER_GRID_Z;
+	params.grid[3] = this->GetLightCount();
+	params.tile[0] = static_cast<float>((renderExtent.width + CLUSTER_GRID_X - 1) / CLUSTER_GRID_X);
+	params.tile[1] = static_cast<float>((renderExtent.height + CLUSTER_GRID_Y - 1) / CLUSTER_GRID_Y);
+	params.tile[2] = static_cast<float>(renderExtent.width);
+	params.tile[3] = static_cast<float>(renderExtent.height);
+	params.slices[0] = zNear;
+	params.slices[1] = zFar;
+	params.slices[2] = CLUSTER_GRID_Z / sliceRange;
+	params.slices[3] = CLUSTER_GRID_Z * std::log(zNear) / sliceRange;
+	params.projection[0] = projection(0, 0);
+	params.projection[1] = projection(1, 1);
+	params.projection[2] = projection(2, 2);
+	params.projection[3] = projection(2, 3);
+	std::memcpy(this->allocator.GetMappedData(frame.paramsAllocation), &params, sizeof(params));
+}
+
+void LightClusters::Record(vk::CommandBuffer commandBuffer, uint32_t frameIndex, const vkp::math::Mat4& view, vk::DescriptorSet lightSet)
+{
+	// without lights the fragment shader does not look at the clusters at all
+	if (this->lights.empty())
+		return;
+
+	const auto& frame = this->frames[frameIndex];
+	commandBuffer.fillBuffer(frame.indexBuffer, 0, sizeof(uint32_t), 0);
+	const vk::MemoryBarrier clearBarrier(vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite);
+	commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eComputeShader, {}, clearBarrier, nullptr, nullptr);
+
+	const auto layout = this->renderDevice.GetLightCullingLayout();
+	LightCullingPushConstants pushConstants = { view };
+	commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, this->renderDevice.GetLightCullingPipeline());
+	commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, layout, 0, lightSet, nullptr);
+	commandBuffer.pushConstants(layout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(pushConstants), &pushConstants);
+	commandBuffer.dispatch((this->GetClusterCount() + CULLING_GROUP_SIZE - 1) / CULLING_GROUP_SIZE, 1, 1);
+
+	const vk::MemoryBarrier cullingBarrier(vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
+	commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eFragmentShader, {}, cullingBarrier, nullptr, nullptr);
+}
+
+std::vector<DescriptorResource> LightClusters::GetResources(uint32_t frameIndex) const
+{
+	const auto& frame = this->frames[frameIndex];
+	return
+	{
+		DescriptorResource::Buffer(0, vk::DescriptorType::eUniformBuffer, frame.paramsBuffer, 0, sizeof(LightClusterParams)),
+		DescriptorResource::Buffer(1, vk::DescriptorType::eStorageBuffer, frame.lightBuffer, 0, VK_WHOLE_SIZE),
+		DescriptorResource::Buffer(2, vk::DescriptorType::eStorageBuffer, frame.clusterBuffer, 0, VK_WHOLE_SIZE),
+		DescriptorResource::Buffer(3, vk::DescriptorType::eStorageBuffer, frame.indexBuffer, 0, VK_WHOLE_SIZE)
+	};
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <vector>
+#include <vulkan/vulkan.hpp>
+#include "../utils/Math.hpp"
+#include "DescriptorAllocator.hpp"
+#include "MemoryAllocator.hpp"
+#include "RenderDevice.hpp"
+
+// std430 layout of shader/cluster_lights.comp and shader/mesh.frag
+struct PointLight
+{
+	float positionRadius[4];   // world space position, radius of influence
+	float colorIntensity[4];
+};
+
+// std140 layout of the cluster parameters uniform
+struct LightClusterParams
+{
+	uint32_t grid[4];        // clusters in x, y and z, light count
+	float tile[4];           // tile size in pixels, rendered extent
+	float slices[4];         // near, far, slice scale and bias mapping log view depth to the slice
+	float projection[4];     // projection(0, 0), projection(1, 1) and the a, b of view depth = b / (depth + a)
+};
+
+// Clustered forward lighting: the view frustum is divided into a grid of screen tiles times exponentially spaced depth slices and
+// a compute pass assigns every light to the clusters its sphere touches. Per cluster an offset and count into one compact light
+// index list are written, so the mesh fragment shader only iterates the lights of its own cluster.
+// Lights orbit the scene and are uploaded every frame. All buffers exist once per frame in flight.
+class LightClusters
+{
+	struct Frame
+	{
+		vk::Buffer paramsBuffer;
+		AllocationHandle paramsAllocation;
+		vk::Buffer lightBuffer;
+		AllocationHandle lightAllocation;
+		vk::Buffer clusterBuffer;
+		AllocationHandle clusterAllocation;
+		vk::Buffer indexBuffer;
+		AllocationHandle indexAllocation;
+	};
+
+	RenderDevice& renderDevice;
+	MemoryAllocator& allocator;
+	std::vector<PointLight> lights;      // at time 0
+	std::vector<float> orbitSpeeds;      // radians per second about the y axis
+	std::vector<Frame> frames;
+	vk::DeviceSize indexCapacity;
+
+public:
+	// lightCount may be 0, the buffers are created anyway so the light set of the mesh pipelines is always valid
+	LightClusters(RenderDevice& renderDevice, MemoryAllocator& allocator, uint32_t framesInFlight, uint32_t lightCount);
+	~LightClusters();
+
+	LightClusters(const LightClusters&) = delete;
+	LightClusters& operator=(const LightClusters&) = delete;
+
+	// writes the lights at the given time and the grid for the projection and rendered extent of the frame,
+	// the GPU has to be done with the frame slot
+	void Update(uint32_t frameIndex, double time, const vkp::math::Mat4& projection, float zNear, float zFar, vk::Extent2D renderExtent);
+
+	// records the culling dispatch with barriers before and after it, outside of a render pass
+	void Record(vk::CommandBuffer commandBuffer, uint32_t frameIndex, const vkp::math::Mat4& view, vk::DescriptorSet lightSet);
+
+	// resources of the GetLightSetLayout set of the frame slot
+	std::vector<DescriptorResource> GetResources(uint32_t frameIndex) const;
+
+	uint32_t GetLightCount() const { return static_cast<uint32_t>(this->lights.size()); }
+	uint32_t GetClusterCount() const;
+};
@@ -0,0 +1,593 @@
+#include "MemoryAllocator.hpp"
+#include <algorithm>
+#include <array>
+#include <spdlog/spdlog.h>
+
+namespace
+{
+	// blocks that are less than half full are emptied by the defragmenter
+	const float DEFRAG_OCCUPANCY_THRESHOLD = 0.5f;
+
+	vk::DeviceSize alignUp(vk::DeviceSize value, vk::DeviceSize alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	vk::DeviceSize alignDown(vk::DeviceSize value, vk::DeviceSize alignment)
+	{
+		return value / alignment * alignment;
+	}
+
+	double toMiB(vk::DeviceSize bytes)
+	{
+		return bytes / (1024.0 * 1024.0);
+	}
+
+	vk::ImageSubresourceRange fullRange(const vk::ImageCreateInfo& info)
+	{
+		return vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, info.mipLevels, 0, info.arrayLayers);
+	}
+}
+
+MemoryAllocator::MemoryAllocator(vk::PhysicalDevice physicalDevice, vk::Device device, uint32_t framesInFlight, bool memoryBudgetSupported, vk::DeviceSize blockSize)
+	: physicalDevice(physicalDevice), device(device), framesInFlight(framesInFlight), memoryBudgetSupported(memoryBudgetSupported), blockSize(blockSize)
+{
+	this->memoryProperties = this->physicalDevice.getMemoryProperties();
+	this->nonCoherentAtomSize = this->physicalDevice.getProperties().limits.nonCoherentAtomSize;
+}
+
+MemoryAllocator::~MemoryAllocator()
+{
+	for (auto& pending : this->pendingFrees)
+	{
+		if (pending.buffer)
+			this->device.destroyBuffer(pending.buffer);
+		if (pending.image)
+			this->device.destroyImage(pending.image);
+	}
+	this->pendingFrees.clear();
+
+	auto log = spdlog::get("vk-perf");
+	for (auto& allocation : this->allocations)
+	{
+		if (!allocation.alive)
+			continue;
+
+		log->warn("Leaked {0} byte {1} allocation", allocation.size, allocation.image ? "image" : "buffer");
+		if (allocation.buffer)
+			this->device.destroyBuffer(allocation.buffer);
+		if (allocation.image)
+			this->device.destroyImage(allocation.image);
+	}
+	this->allocations.clear();
+
+	for (auto& block : this->blocks)
+	{
+		if (block.memory)
+			this->device.freeMemory(block.memory);
+	}
+	this->blocks.clear();
+}
+
+uint32_t MemoryAllocator::CreateBlock(uint32_t memoryType, vk::DeviceSize size, bool image, bool dedicated)
+{
+	Block block = {};
+	block.memory = this->device.allocateMemory(vk::MemoryAllocateInfo(size, memoryType));
+	block.size = size;
+	block.memoryType = memoryType;
+	block.image = image;
+	block.dedicated = dedicated;
+	block.freeRanges.push_back({ 0, size });
+
+	this->allocatorStats.blockAllocations++;
+	this->allocatorStats.blockBytes += size;
+	this->allocatorStats.peakBlockBytes = std::max(this->allocatorStats.peakBlockBytes, this->allocatorStats.blockBytes);
+
+	const auto flags = this->memoryProperties.memoryTypes[memoryType].propertyFlags;
+	if (flags & vk::MemoryPropertyFlagBits::eHostVisible)
+		block.mapped = static_cast<uint8_t*>(this->device.mapMemory(block.memory, 0, size));
+
+	// reuse slots of freed blocks so block indices stay small
+	for (uint32_t i = 0; i < this->blocks.size(); i++)
+	{
+		if (!this->blocks[i].memory)
+		{
+			this->blocks[i] = std::move(block);
+			return i;
+		}
+	}
+
+	this->blocks.push_back(std::move(block));
+	return static_cast<uint32_t>(this->blocks.size() - 1);
+}
+
+bool MemoryAllocator::AllocateFromBlock(uint32_t blockIndex, vk::DeviceSize size, vk::DeviceSize alignment, vk::DeviceSize& offset)
+{
+	auto& block = this->blocks[blockIndex];
+	for (auto it = block.freeRanges.begin(); it != block.freeRanges.end(); ++it)
+	{
+		const auto alignedOffset = alignUp(it->offset, alignment);
+		const auto end = it->offset + it->size;
+		if (alignedOffset + size > end)
+			continue;
+
+		// split the free range, the alignment padding stays free
+		const Range before = { it->offset, alignedOffset - it->offset };
+		const Range after = { alignedOffset + size, end - alignedOffset - size };
+		it = block.freeRanges.erase(it);
+		if (after.size > 0)
+			it = block.freeRanges.insert(it, after);
+		if (before.size > 0)
+			block.freeRanges.insert(it, before);
+
+		block.usedBytes += size;
+		block.rangeCount++;
+		offset = alignedOffset;
+		return true;
+	}
+	return false;
+}
+
+void MemoryAllocator::FreeRange(uint32_t blockIndex, const Range& range)
+{
+	auto& block = this->blocks[blockIndex];
+	auto it = std::lower_bound(block.freeRanges.begin(), block.freeRanges.end(), range.offset, [](const Range& r, vk::DeviceSize offset) { return r.offset < offset; });
+	it = block.freeRanges.insert(it, range);
+
+	// merge with the following and preceding free ranges
+	if (it + 1 != block.freeRanges.end() && it->offset + it->size == (it + 1)->offset)
+	{
+		it->size += (it + 1)->size;
+		block.freeRanges.erase(it + 1);
+	}
+	if (it != block.freeRanges.begin() && (it - 1)->offset + (it - 1)->size == it->offset)
+	{
+		(it - 1)->size += it->size;
+		block.freeRanges.erase(it);
+	}
+
+	block.usedBytes -= range.size;
+	block.rangeCount--;
+	if (block.rangeCount > 0)
+		return;
+
+	// keep one empty block per memory type around so allocations do not thrash device memory
+	const auto hasSibling = std::any_of(this->blocks.begin(), this->blocks.end(), [&block](const Block& other)
+	{
+		return &other != &block && other.memory && !other.dedicated && other.memoryType == block.memoryType && other.image == block.image;
+	});
+	if (block.dedicated || hasSibling)
+	{
+		if (block.mapped)
+			this->device.unmapMemory(block.memory);
+		this->device.freeMemory(block.memory);
+		this->defragStats.freedBlocks++;
+		this->defragStats.freedBytes += block.size;
+		this->allocatorStats.blockBytes -= block.size;
+		block = {};
+	}
+}
+
+uint32_t MemoryAllocator::AllocateMemory(const vk::MemoryRequirements& requirements, vk::MemoryPropertyFlags properties, bool image, vk::DeviceSize& offset)
+{
+	uint32_t memoryType = this->memoryProperties.memoryTypeCount;
+	for (uint32_t i = 0; i < this->memoryProperties.memoryTypeCount; i++)
+	{
+		if ((requirements.memoryTypeBits & (1 << i)) && (this->memoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
+		{
+			memoryType = i;
+			break;
+		}
+	}
+	if (memoryType == this->memoryProperties.memoryTypeCount)
+		throw std::exception("No suitable memory type found");
+	this->allocatorStats.allocations++;
+
+	// large resources get their own block, they would only waste space in shared blocks
+	if (requirements.size > this->blockSize / 2)
+	{
+		offset = 0;
+		const auto blockIndex = this->CreateBlock(memoryType, requirements.size, image, true);
+		this->AllocateFromBlock(blockIndex, requirements.size, requirements.alignment, offset);
+		return blockIndex;
+	}
+
+	for (uint32_t i = 0; i < this->blocks.size(); i++)
+	{
+		const auto& block = this->blocks[i];
+		if (!block.memory || block.dedicated || block.memoryType != memoryType || block.image != image)
+			continue;
+		if (this->AllocateFromBlock(i, requirements.size, requirements.alignment, offset))
+			return i;
+	}
+
+	const auto blockIndex = this->CreateBlock(memoryType, this->blockSize, image, false);
+	if (!this->AllocateFromBlock(blockIndex, requirements.size, requirements.alignment, offset))
+		throw std::exception("Allocation does not fit into a new memory block");
+	return blockIndex;
+}
+
+AllocationHandle MemoryAllocator::CreateHandle()
+{
+	if (!this->freeHandles.empty())
+	{
+		const auto handle = this->freeHandles.back();
+		this->freeHandles.pop_back();
+		return handle;
+	}
+
+	this->allocations.emplace_back();
+	return static_cast<AllocationHandle>(this->allocations.size() - 1);
+}
+
+vk::Buffer MemoryAllocator::CreateBuffer(const vk::BufferCreateInfo& createInfo, vk::MemoryPropertyFlags properties, AllocationHandle& allocation)
+{
+	const auto buffer = this->device.createBuffer(createInfo);
+	const auto requirements = this->device.getBufferMemoryRequirements(buffer);
+
+	vk::DeviceSize offset;
+	const auto blockIndex = this->AllocateMemory(requirements, properties, false, offset);
+	this->device.bindBufferMemory(buffer, this->blocks[blockIndex].memory, offset);
+
+	allocation = this->CreateHandle();
+	auto& record = this->allocations[allocation];
+	record = {};
+	record.alive = true;
+	record.block = blockIndex;
+	record.offset = offset;
+	record.size = requirements.size;
+	record.alignment = requirements.alignment;
+	record.buffer = buffer;
+	record.bufferInfo = createInfo;
+	record.bufferInfo.pNext = nullptr;
+	record.bufferInfo.queueFamilyIndexCount = 0;
+	record.bufferInfo.pQueueFamilyIndices = nullptr;
+	return buffer;
+}
+
+vk::Image MemoryAllocator::CreateImage(const vk::ImageCreateInfo& createInfo, vk::MemoryPropertyFlags properties, AllocationHandle& allocation)
+{
+	return this->CreateImage(createInfo, properties, properties, allocation);
+}
+
+vk::Image MemoryAllocator::CreateImage(const vk::ImageCreateInfo& createInfo, vk::MemoryPropertyFlags properties, vk::MemoryPropertyFlags fallbackProperties, AllocationHandle& allocation)
+{
+	// memory types depend on format, usage and tiling, e.g. lazily allocated memory is often limited to some attachment formats
+	const auto image = this->device.createImage(createInfo);
+	const auto requirements = this->device.getImageMemoryRequirements(image);
+	if (!this->HasMemoryType(requirements.memoryTypeBits, properties))
+		properties = fallbackProperties;
+
+	vk::DeviceSize offset;
+	const auto blockIndex = this->AllocateMemory(requirements, properties, true, offset);
+	this->device.bindImageMemory(image, this->blocks[blockIndex].memory, offset);
+
+	allocation = this->CreateHandle();
+	auto& record = this->allocations[allocation];
+	record = {};
+	record.alive = true;
+	record.block = blockIndex;
+	record.offset = offset;
+	record.size = requirements.size;
+	record.alignment = requirements.alignment;
+	record.image = image;
+	record.imageInfo = createInfo;
+	record.imageInfo.pNext = nullptr;
+	record.imageInfo.queueFamilyIndexCount = 0;
+	record.imageInfo.pQueueFamilyIndices = nullptr;
+	return image;
+}
+
+void MemoryAllocator::Destroy(AllocationHandle allocation)
+{
+	auto& record = this->allocations[allocation];
+	if (record.buffer)
+		this->device.destroyBuffer(record.buffer);
+	if (record.image)
+		this->device.destroyImage(record.image);
+
+	this->FreeRange(record.block, { record.offset, record.size });
+	record = {};
+	this->freeHandles.push_back(allocation);
+}
+
+void MemoryAllocator::SetMovable(AllocationHandle allocation, vk::ImageLayout layout, std::function<void(AllocationHandle)> onMoved)
+{
+	auto& record = this->allocations[allocation];
+	record.movable = true;
+	record.layout = layout;
+	record.onMoved = std::move(onMoved);
+}
+
+void MemoryAllocator::ClearMovable(AllocationHandle allocation)
+{
+	auto& record = this->allocations[allocation];
+	record.movable = false;
+	record.onMoved = nullptr;
+}
+
+void* MemoryAllocator::GetMappedData(AllocationHandle allocation) const
+{
+	const auto& record = this->allocations[allocation];
+	const auto& block = this->blocks[record.block];
+	return block.mapped ? block.mapped + record.offset : nullptr;
+}
+
+void MemoryAllocator::InvalidateMappedData(AllocationHandle allocation) const
+{
+	const auto& record = this->allocations[allocation];
+	const auto& block = this->blocks[record.block];
+	if (this->memoryProperties.memoryTypes[block.memoryType].propertyFlags & vk::MemoryPropertyFlagBits::eHostCoherent)
+		return;
+
+	// the range has to be aligned to the atom size but must not reach past the end of the block
+	const auto begin = alignDown(record.offset, this->nonCoherentAtomSize);
+	const auto end = std::min(alignUp(record.offset + record.size, this->nonCoherentAtomSize), block.size);
+	this->device.invalidateMappedMemoryRanges(vk::MappedMemoryRange(block.memory, begin, end - begin));
+}
+
+vk::MemoryPropertyFlags MemoryAllocator::GetMemoryProperties(AllocationHandle allocation) const
+{
+	const auto& block = this->blocks[this->allocations[allocation].block];
+	return this->memoryProperties.memoryTypes[block.memoryType].propertyFlags;
+}
+
+bool MemoryAllocator::HasMemoryType(uint32_t memoryTypeBits, vk::MemoryPropertyFlags properties) const
+{
+	for (uint32_t i = 0; i < this->memoryProperties.memoryTypeCount; i++)
+	{
+		if ((memoryTypeBits & (1 << i)) && (this->memoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
+			return true;
+	}
+	return false;
+}
+
+bool MemoryAllocator::SupportsMemoryProperties(vk::MemoryPropertyFlags properties) const
+{
+	return this->HasMemoryType(~0u, properties);
+}
+
+void MemoryAllocator::BeginFrame(uint64_t frame)
+{
+	this->currentFrame = frame;
+
+	const auto framesInFlight = this->framesInFlight;
+	const auto expired = std::partition(this->pendingFrees.begin(), this->pendingFrees.end(), [frame, framesInFlight](const PendingFree& p) { return p.frame + framesInFlight > frame; });
+	std::vector<PendingFree> released(expired, this->pendingFrees.end());
+	this->pendingFrees.erase(expired, this->pendingFrees.end());
+
+	for (auto& pending : released)
+	{
+		if (pending.buffer)
+			this->device.destroyBuffer(pending.buffer);
+		if (pending.image)
+			this->device.destroyImage(pending.image);
+		this->FreeRange(pending.block, pending.range);
+	}
+}
+
+uint32_t MemoryAllocator::FindDefragmentationSource() const
+{
+	uint32_t source = static_cast<uint32_t>(this->blocks.size());
+	float lowestOccupancy = DEFRAG_OCCUPANCY_THRESHOLD;
+
+	for (uint32_t i = 0; i < this->blocks.size(); i++)
+	{
+		const auto& block = this->blocks[i];
+		if (!block.memory || block.dedicated || block.usedBytes == 0)
+			continue;
+
+		const auto occupancy = static_cast<float>(block.usedBytes) / block.size;
+		if (occupancy >= lowestOccupancy)
+			continue;
+
+		// only worth it if there is another block of the same kind to move into
+		const auto hasTarget = std::any_of(this->blocks.begin(), this->blocks.end(), [&block](const Block& other)
+		{
+			return &other != &block && other.memory && !other.dedicated && other.memoryType == block.memoryType && other.image == block.image;
+		});
+		if (!hasTarget)
+			continue;
+
+		// every live allocation has to be movable, otherwise the block can never be released
+		auto movable = true;
+		for (const auto& allocation : this->allocations)
+		{
+			if (allocation.alive && allocation.block == i && !allocation.movable)
+			{
+				movable = false;
+				break;
+			}
+		}
+		if (!movable)
+			continue;
+
+		source = i;
+		lowestOccupancy = occupancy;
+	}
+	return source;
+}
+
+bool MemoryAllocator::MoveAllocation(AllocationHandle handle, vk::CommandBuffer commandBuffer, std::vector<vk::ImageMemoryBarrier>& postBarriers)
+{
+	auto& record = this->allocations[handle];
+	const auto& source = this->blocks[record.block];
+
+	// the target has to be another existing block, creating one would defeat the purpose
+	uint32_t target = static_cast<uint32_t>(this->blocks.size());
+	vk::DeviceSize offset = 0;
+	for (uint32_t i = 0; i < this->blocks.size(); i++)
+	{
+		const auto& block = this->blocks[i];
+		if (i == record.block || !block.memory || block.dedicated || block.memoryType != source.memoryType || block.image != source.image)
+			continue;
+
+		// only fill up blocks that are denser than the source so allocations never move back and forth
+		if (block.usedBytes < source.usedBytes)
+			continue;
+		if (this->AllocateFromBlock(i, record.size, record.alignment, offset))
+		{
+			target = i;
+			break;
+		}
+	}
+	if (target == this->blocks.size())
+		return false;
+
+	PendingFree pending = {};
+	pending.block = record.block;
+	pending.range = { record.offset, record.size };
+	pending.frame = this->currentFrame;
+
+	if (record.buffer)
+	{
+		const auto buffer = this->device.createBuffer(record.bufferInfo);
+		this->device.bindBufferMemory(buffer, this->blocks[target].memory, offset);
+		const vk::BufferCopy region(0, 0, record.bufferInfo.size);
+		commandBuffer.copyBuffer(record.buffer, buffer, 1, &region);
+
+		pending.buffer = record.buffer;
+		record.buffer = buffer;
+	}
+	else
+	{
+		const auto image = this->device.createImage(record.imageInfo);
+		this->device.bindImageMemory(image, this->blocks[target].memory, offset);
+
+		const auto& info = record.imageInfo;
+		const vk::ImageMemoryBarrier toTransferSrc(vk::AccessFlagBits::eMemoryRead | vk::AccessFlagBits::eMemoryWrite, vk::AccessFlagBits::eTransferRead,
+			record.layout, vk::ImageLayout::eTransferSrcOptimal, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, record.image, fullRange(info));
+		const vk::ImageMemoryBarrier toTransferDst({}, vk::AccessFlagBits::eTransferWrite,
+			vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, image, fullRange(info));
+		const std::array<vk::ImageMemoryBarrier, 2> barriers = { toTransferSrc, toTransferDst };
+		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eAllCommands, vk::PipelineStageFlagBits::eTransfer, {}, nullptr, nullptr, barriers);
+
+		std::vector<vk::ImageCopy> regions;
+		for (uint32_t mip = 0; mip < info.mipLevels; mip++)
+		{
+			const vk::ImageSubresourceLayers layers(vk::ImageAspectFlagBits::eColor, mip, 0, info.arrayLayers);
+			const vk::Extent3D extent(std::max(info.extent.width >> mip, 1u), std::max(info.extent.height >> mip, 1u), std::max(info.extent.depth >> mip, 1u));
+			regions.emplace_back(layers, vk::Offset3D(0, 0, 0), layers, vk::Offset3D(0, 0, 0), extent);
+		}
+		commandBuffer.copyImage(record.image, vk::ImageLayout::eTransferSrcOptimal, image, vk::ImageLayout::eTransferDstOptimal, regions);
+
+		postBarriers.emplace_back(vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eMemoryRead,
+			vk::ImageLayout::eTransferDstOptimal, record.layout, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, image, fullRange(info));
+
+		pending.image = record.image;
+		record.image = image;
+	}
+
+	this->pendingFrees.push_back(pending);
+	record.block = target;
+	record.offset = offset;
+
+	this->defragStats.movedAllocations++;
+	this->defragStats.movedBytes += record.size;
+	return true;
+}
+
+void MemoryAllocator::Defragment(vk::CommandBuffer commandBuffer, vk::DeviceSize maxBytes)
+{
+	const auto source = this->FindDefragmentationSource();
+	if (source == this->blocks.size())
+		return;
+
+	std::vector<vk::ImageMemoryBarrier> postBarriers;
+	std::vector<AllocationHandle> moved;
+	vk::DeviceSize movedBytes = 0;
+
+	for (AllocationHandle handle = 0; handle < this->allocations.size(); handle++)
+	{
+		const auto& record = this->allocations[handle];
+		if (!record.alive || record.block != source)
+			continue;
+		if (!moved.empty() && movedBytes + record.size > maxBytes)
+			break;
+		if (!this->MoveAllocation(handle, commandBuffer, postBarriers))
+			break;
+
+		moved.push_back(handle);
+		movedBytes += this->allocations[handle].size;
+	}
+
+	if (moved.empty())
+		return;
+
+	// make the copies visible to everything that follows in this frame
+	const vk::MemoryBarrier memoryBarrier(vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eMemoryRead);
+	commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eAllCommands, {}, memoryBarrier, nullptr, postBarriers);
+
+	spdlog::get("vk-perf")->debug("Defragmentation moved {0} allocations ({1:.2f} MiB) out of block {2}", moved.size(), toMiB(movedBytes), source);
+
+	for (const auto handle : moved)
+	{
+		const auto& record = this->allocations[handle];
+		if (record.onMoved)
+			record.onMoved(handle);
+	}
+}
+
+MemoryHeapStats MemoryAllocator::GetHeapStats(uint32_t heap) const
+{
+	MemoryHeapStats stats = {};
+	stats.heapSize = this->memoryProperties.memoryHeaps[heap].size;
+	stats.deviceLocal = static_cast<bool>(this->memoryProperties.memoryHeaps[heap].flags & vk::MemoryHeapFlagBits::eDeviceLocal);
+
+	for (uint32_t i = 0; i < this->blocks.size(); i++)
+	{
+		const auto& block = this->blocks[i];
+		if (!block.memory || this->memoryProperties.memoryTypes[block.memoryType].heapIndex != heap)
+			continue;
+
+		stats.blockCount++;
+		stats.blockBytes += block.size;
+		for (const auto& range : block.freeRanges)
+			stats.largestFreeRange = std::max(stats.largestFreeRange, range.size);
+	}
+
+	for (const auto& allocation : this->allocations)
+	{
+		if (!allocation.alive || this->memoryProperties.memoryTypes[this->blocks[allocation.block].memoryType].heapIndex != heap)
+			continue;
+
+		stats.allocationCount++;
+		stats.allocatedBytes += allocation.size;
+	}
+
+	if (this->memoryBudgetSupported)
+	{
+		// the budget also accounts for allocations of other processes and memory not allocated through this allocator
+		const auto properties = this->physicalDevice.getMemoryProperties2<vk::PhysicalDeviceMemoryProperties2, vk::PhysicalDeviceMemoryBudgetPropertiesEXT>();
+		const auto& budget = properties.get<vk::PhysicalDeviceMemoryBudgetPropertiesEXT>();
+		stats.budget = budget.heapBudget[heap];
+		stats.usage = budget.heapUsage[heap];
+	}
+	else
+	{
+		stats.budget = stats.heapSize / 10 * 8;
+		stats.usage = stats.blockBytes;
+	}
+	return stats;
+}
+
+void MemoryAllocator::LogStats() const
+{
+	auto log = spdlog::get("vk-perf");
+	for (uint32_t heap = 0; heap < this->memoryProperties.memoryHeapCount; heap++)
+	{
+		const auto stats = this->GetHeapStats(heap);
+		if (stats.blockCount == 0)
+			continue;
+
+		const auto freeBytes = stats.blockBytes - stats.allocatedBytes;
+		const auto fragmentation = freeBytes > 0 ? 100.0 * (1.0 - static_cast<double>(stats.largestFreeRange) / freeBytes) : 0.0;
+		log->info("Heap {0}{1}: usage {2:.1f}/{3:.1f} MiB, {4} blocks {5:.1f} MiB, {6} allocations {7:.1f} MiB, fragmentation {8:.1f}%",
+			heap, stats.deviceLocal ? " (device local)" : "", toMiB(stats.usage), toMiB(stats.budget),
+			stats.blockCount, toMiB(stats.blockBytes), stats.allocationCount, toMiB(stats.allocatedBytes), fragmentation);
+	}
+
+	const auto& defrag = this->defragStats;
+	log->info("Defragmentation: {0} allocations moved ({1:.1f} MiB), {2} blocks released ({3:.1f} MiB)",
+		defrag.movedAllocations, toMiB(defrag.movedBytes), defrag.freedBlocks, toMiB(defrag.freedBytes));
+}
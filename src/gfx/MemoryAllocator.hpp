@@ -0,0 +1,159 @@
+#pragma once
+#include <functional>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+using AllocationHandle = uint32_t;
+
+struct MemoryHeapStats
+{
+	vk::DeviceSize heapSize;
+	vk::DeviceSize budget;          // VK_EXT_memory_budget, 80% of the heap size without the extension
+	vk::DeviceSize usage;           // process wide usage reported by the driver, blockBytes without the extension
+	vk::DeviceSize blockBytes;      // device memory allocated by the allocator
+	vk::DeviceSize allocatedBytes;  // bytes handed out to live allocations
+	vk::DeviceSize largestFreeRange;
+	uint32_t blockCount;
+	uint32_t allocationCount;
+	bool deviceLocal;
+};
+
+struct DefragmentationStats
+{
+	uint64_t movedAllocations;
+	vk::DeviceSize movedBytes;
+	uint64_t freedBlocks;
+	vk::DeviceSize freedBytes;
+};
+
+// totals over the lifetime of the allocator
+struct MemoryAllocatorStats
+{
+	uint64_t allocations;           // buffers and images created
+	uint64_t blockAllocations;      // vkAllocateMemory calls
+	vk::DeviceSize blockBytes;      // device memory currently held
+	vk::DeviceSize peakBlockBytes;
+};
+
+// Sub-allocates buffers and images from large device memory blocks and keeps per heap statistics.
+// Buffers and images live in separate blocks so bufferImageGranularity never has to be considered.
+// Allocations that are marked as movable can be relocated by Defragment, which empties sparsely used blocks a few
+// allocations per frame using GPU copies. The owner is notified through the move callback and has to pick up the new
+// resource handle (and recreate views/descriptors) before it is used again.
+class MemoryAllocator
+{
+	struct Range
+	{
+		vk::DeviceSize offset;
+		vk::DeviceSize size;
+	};
+
+	struct Block
+	{
+		vk::DeviceMemory memory;
+		vk::DeviceSize size;
+		uint32_t memoryType;
+		bool image;
+		bool dedicated;
+		uint8_t* mapped;
+		std::vector<Range> freeRanges;  // sorted by offset
+		vk::DeviceSize usedBytes;
+		uint32_t rangeCount;           // live and pending ranges
+	};
+
+	struct Allocation
+	{
+		bool alive;
+		uint32_t block;
+		vk::DeviceSize offset;
+		vk::DeviceSize size;
+		vk::DeviceSize alignment;
+		vk::Buffer buffer;
+		vk::Image image;
+		vk::BufferCreateInfo bufferInfo;
+		vk::ImageCreateInfo imageInfo;
+		bool movable;
+		vk::ImageLayout layout;
+		std::function<void(AllocationHandle)> onMoved;
+	};
+
+	// resources and ranges that may still be read by frames in flight
+	struct PendingFree
+	{
+		uint32_t block;
+		Range range;
+		vk::Buffer buffer;
+		vk::Image image;
+		uint64_t frame;
+	};
+
+	vk::PhysicalDevice physicalDevice;
+	vk::Device device;
+	vk::PhysicalDeviceMemoryProperties memoryProperties;
+	uint32_t framesInFlight;
+	bool memoryBudgetSupported;
+	vk::DeviceSize blockSize;
+	vk::DeviceSize nonCoherentAtomSize;
+
+	std::vector<Block> blocks;
+	std::vector<Allocation> allocations;
+	std::vector<AllocationHandle> freeHandles;
+	std::vector<PendingFree> pendingFrees;
+	DefragmentationStats defragStats = {};
+	MemoryAllocatorStats allocatorStats = {};
+	uint64_t currentFrame = 0;
+
+	uint32_t AllocateMemory(const vk::MemoryRequirements& requirements, vk::MemoryPropertyFlags properties, bool image, vk::DeviceSize& offset);
+	bool AllocateFromBlock(uint32_t blockIndex, vk::DeviceSize size, vk::DeviceSize alignment, vk::DeviceSize& offset);
+	uint32_t CreateBlock(uint32_t memoryType, vk::DeviceSize size, bool image, bool dedicated);
+	void FreeRange(uint32_t blockIndex, const Range& range);
+	AllocationHandle CreateHandle();
+	bool MoveAllocation(AllocationHandle handle, vk::CommandBuffer commandBuffer, std::vector<vk::ImageMemoryBarrier>& postBarriers);
+	uint32_t FindDefragmentationSource() const;
+	bool HasMemoryType(uint32_t memoryTypeBits, vk::MemoryPropertyFlags properties) const;
+
+public:
+	MemoryAllocator(vk::PhysicalDevice physicalDevice, vk::Device device, uint32_t framesInFlight, bool memoryBudgetSupported, vk::DeviceSize blockSize = 64 * 1024 * 1024);
+	~MemoryAllocator();
+
+	MemoryAllocator(const MemoryAllocator&) = delete;
+	MemoryAllocator& operator=(const MemoryAllocator&) = delete;
+
+	// host visible allocations are persistently mapped
+	vk::Buffer CreateBuffer(const vk::BufferCreateInfo& createInfo, vk::MemoryPropertyFlags properties, AllocationHandle& allocation);
+	vk::Image CreateImage(const vk::ImageCreateInfo& createInfo, vk::MemoryPropertyFlags properties, AllocationHandle& allocation);
+	// uses properties if one of the memory types the image supports has them, otherwise fallbackProperties
+	vk::Image CreateImage(const vk::ImageCreateInfo& createInfo, vk::MemoryPropertyFlags properties, vk::MemoryPropertyFlags fallbackProperties, AllocationHandle& allocation);
+
+	// destroys the resource immediately, the caller has to make sure the GPU is done with it
+	void Destroy(AllocationHandle allocation);
+
+	// allows Defragment to relocate the allocation. Images have to be in the given layout whenever a frame starts recording.
+	// Movable resources need eTransferSrc and eTransferDst usage.
+	void SetMovable(AllocationHandle allocation, vk::ImageLayout layout, std::function<void(AllocationHandle)> onMoved);
+	// pins the allocation again, e.g. once an image leaves the layout given to SetMovable
+	void ClearMovable(AllocationHandle allocation);
+
+	vk::Buffer GetBuffer(AllocationHandle allocation) const { return this->allocations[allocation].buffer; }
+	vk::Image GetImage(AllocationHandle allocation) const { return this->allocations[allocation].image; }
+	vk::DeviceSize GetSize(AllocationHandle allocation) const { return this->allocations[allocation].size; }
+	vk::MemoryPropertyFlags GetMemoryProperties(AllocationHandle allocation) const;
+	void* GetMappedData(AllocationHandle allocation) const;
+
+	// makes GPU writes visible to the mapping, only does work for memory that is not host coherent
+	void InvalidateMappedData(AllocationHandle allocation) const;
+	bool SupportsMemoryProperties(vk::MemoryPropertyFlags properties) const;
+
+	// releases resources that were moved away from at least framesInFlight frames ago
+	void BeginFrame(uint64_t frame);
+
+	// records copies for up to maxBytes of movable allocations out of the least occupied block
+	void Defragment(vk::CommandBuffer commandBuffer, vk::DeviceSize maxBytes);
+
+	bool HasMemoryBudget() const { return this->memoryBudgetSupported; }
+	uint32_t GetHeapCount() const { return this->memoryProperties.memoryHeapCount; }
+	MemoryHeapStats GetHeapStats(uint32_t heap) const;
+	const DefragmentationStats& GetDefragmentationStats() const { return this->defragStats; }
+	const MemoryAllocatorStats& GetAllocatorStats() const { return this->allocatorStats; }
+	void LogStats() const;
+};
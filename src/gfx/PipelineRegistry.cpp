@@ -0,0 +1,222 @@
+#include "PipelineRegistry.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <spdlog/spdlog.h>
+#include "../assets/MeshFormat.hpp"
+#include "../utils/Hash.hpp"
+
+static_assert(sizeof(PipelineState) == 20, "PipelineState is hashed bytewise and must not contain padding");
+
+namespace
+{
+	template<typename T>
+	uint16_t registerUnique(std::vector<T>& values, T value)
+	{
+		const auto found = std::find(values.begin(), values.end(), value);
+		if (found != values.end())
+			return static_cast<uint16_t>(found - values.begin());
+
+		values.push_back(value);
+		return static_cast<uint16_t>(values.size() - 1);
+	}
+
+	vk::PipelineColorBlendAttachmentState getBlendState(BlendMode mode, vk::ColorComponentFlags writeMask)
+	{
+		switch (mode)
+		{
+		case BlendMode::AlphaBlend:
+			return vk::PipelineColorBlendAttachmentState(VK_TRUE, vk::BlendFactor::eSrcAlpha, vk::BlendFactor::eOneMinusSrcAlpha, vk::BlendOp::eAdd,
+				vk::BlendFactor::eOne, vk::BlendFactor::eZero, vk::BlendOp::eAdd, writeMask);
+		case BlendMode::Additive:
+			return vk::PipelineColorBlendAttachmentState(VK_TRUE, vk::BlendFactor::eOne, vk::BlendFactor::eOne, vk::BlendOp::eAdd,
+				vk::BlendFactor::eOne, vk::BlendFactor::eOne, vk::BlendOp::eAdd, writeMask);
+		default:
+			return vk::PipelineColorBlendAttachmentState(VK_FALSE, vk::BlendFactor::eOne, vk::BlendFactor::eZero, vk::BlendOp::eAdd,
+				vk::BlendFactor::eOne, vk::BlendFactor::eZero, vk::BlendOp::eAdd, writeMask);
+		}
+	}
+}
+
+bool PipelineState::operator==(const PipelineState& other) const
+{
+	return std::memcmp(this, &other, sizeof(PipelineState)) == 0;
+}
+
+size_t PipelineStateHash::operator()(const PipelineState& state) const
+{
+	return static_cast<size_t>(vkp::HashBytes(&state, sizeof(PipelineState)));
+}
+
+PipelineRegistry::PipelineRegistry(vk::Device device, const vkp::assets::AssetArchive& assets)
+	: device(device), assets(assets)
+{
+	this->pipelineCache = this->device.createPipelineCache(vk::PipelineCacheCreateInfo());
+}
+
+PipelineRegistry::~PipelineRegistry()
+{
+	spdlog::get("vk-perf")->info("Pipeline registry: {0} states, {1} pipelines created in {2:.2f} ms, {3} of {4} registrations deduplicated",
+		this->stats.states, this->stats.pipelines, this->stats.createMilliseconds, this->stats.duplicates, this->stats.registrations);
+
+	for (auto& entry : this->entries)
+	{
+		if (entry.pipeline)
+			this->device.destroyPipeline(entry.pipeline);
+	}
+	this->entries.clear();
+
+	for (auto& compute : this->computePipelines)
+		this->device.destroyPipeline(compute.second);
+	this->computePipelines.clear();
+
+	for (auto& shader : this->shaders)
+		this->device.destroyShaderModule(shader);
+	this->shaders.clear();
+
+	this->device.destroyPipelineCache(this->pipelineCache);
+}
+
+ShaderHandle PipelineRegistry::LoadShader(const std::string& name)
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	const auto found = this->shaderNames.find(name);
+	if (found != this->shaderNames.end())
+		return found->second;
+
+	// archive blobs are 16 byte aligned, so the SPIR-V words can be handed to the driver without a copy
+	const auto code = this->assets.Get(name);
+	this->shaders.push_back(this->device.createShaderModule(vk::ShaderModuleCreateInfo({}, code.size, code.as<uint32_t>())));
+
+	const auto handle = static_cast<ShaderHandle>(this->shaders.size() - 1);
+	this->shaderNames.emplace(name, handle);
+	return handle;
+}
+
+uint16_t PipelineRegistry::RegisterLayout(vk::PipelineLayout layout)
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	return registerUnique(this->layouts, layout);
+}
+
+uint16_t PipelineRegistry::RegisterRenderPass(vk::RenderPass renderPass)
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	return registerUnique(this->renderPasses, renderPass);
+}
+
+PipelineHandle PipelineRegistry::Register(const PipelineState& state)
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	this->stats.registrations++;
+
+	const auto found = this->lookup.find(state);
+	if (found != this->lookup.end())
+	{
+		this->stats.duplicates++;
+		return found->second;
+	}
+
+	const auto handle = static_cast<PipelineHandle>(this->entries.size());
+	this->entries.push_back({ state, nullptr });
+	this->lookup.emplace(state, handle);
+	this->stats.states++;
+	return handle;
+}
+
+vk::Pipeline PipelineRegistry::Get(PipelineHandle handle)
+{
+	// creation happens under the lock, sessions requesting the same pipeline wait for the first one to create it
+	std::lock_guard<std::mutex> lock(this->mutex);
+	auto& entry = this->entries[handle];
+	if (!entry.pipeline)
+	{
+		const auto start = std::chrono::high_resolution_clock::now();
+		entry.pipeline = this->CreatePipeline(entry.state);
+		this->stats.createMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		this->stats.pipelines++;
+	}
+	return entry.pipeline;
+}
+
+vk::PipelineLayout PipelineRegistry::GetLayout(PipelineHandle handle) const
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	return this->layouts[this->entries[handle].state.layout];
+}
+
+PipelineState PipelineRegistry::GetState(PipelineHandle handle) const
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	return this->entries[handle].state;
+}
+
+vk::Pipeline PipelineRegistry::GetComputePipeline(ShaderHandle shader, uint16_t layout)
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	const auto key = static_cast<uint32_t>(shader) << 16 | layout;
+	const auto found = this->computePipelines.find(key);
+	if (found != this->computePipelines.end())
+		return found->second;
+
+	const auto start = std::chrono::high_resolution_clock::now();
+	const vk::PipelineShaderStageCreateInfo stage({}, vk::ShaderStageFlagBits::eCompute, this->shaders[shader], "main");
+	const vk::ComputePipelineCreateInfo createInfo({}, stage, this->layouts[layout]);
+	const auto pipeline = this->device.createComputePipelines(this->pipelineCache, createInfo)[0];
+	this->stats.createMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	this->stats.pipelines++;
+
+	this->computePipelines.emplace(key, pipeline);
+	return pipeline;
+}
+
+PipelineRegistryStats PipelineRegistry::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	return this->stats;
+}
+
+vk::Pipeline PipelineRegistry::CreatePipeline(const PipelineState& state)
+{
+	// depth only pipelines run without a fragment shader
+	const auto hasFragmentShader = state.fragmentShader != NoShader;
+	const vk::PipelineShaderStageCreateInfo shaderStages[] =
+	{
+		vk::PipelineShaderStageCreateInfo({}, vk::ShaderStageFlagBits::eVertex, this->shaders[state.vertexShader], "main"),
+		vk::PipelineShaderStageCreateInfo({}, vk::ShaderStageFlagBits::eFragment, hasFragmentShader ? this->shaders[state.fragmentShader] : vk::ShaderModule(), "main")
+	};
+
+	// matches vkp::assets::PackedVertex, the attributes are dequantized by the fixed function vertex fetch
+	const vk::VertexInputBindingDescription packedVertexBinding(0, sizeof(vkp::assets::PackedVertex), vk::VertexInputRate::eVertex);
+	const vk::VertexInputAttributeDescription packedVertexAttributes[] =
+	{
+		vk::VertexInputAttributeDescription(0, 0, vk::Format::eR16G16B16A16Snorm, offsetof(vkp::assets::PackedVertex, position)),
+		vk::VertexInputAttributeDescription(1, 0, vk::Format::eR16G16Snorm, offsetof(vkp::assets::PackedVertex, normal)),
+		vk::VertexInputAttributeDescription(2, 0, vk::Format::eR16G16Unorm, offsetof(vkp::assets::PackedVertex, uv))
+	};
+	vk::PipelineVertexInputStateCreateInfo vertexInputInfo;
+	if (state.vertexLayout == VertexLayout::PackedVertex)
+		vertexInputInfo = vk::PipelineVertexInputStateCreateInfo({}, 1, &packedVertexBinding, 3, packedVertexAttributes);
+
+	const vk::PipelineInputAssemblyStateCreateInfo inputAssembly({}, static_cast<vk::PrimitiveTopology>(state.topology), VK_FALSE);
+	const vk::PipelineViewportStateCreateInfo viewportState({}, 1, nullptr, 1, nullptr);
+	const vk::DynamicState dynamicStates[] = { vk::DynamicState::eViewport, vk::DynamicState::eScissor };
+	const vk::PipelineDynamicStateCreateInfo dynamicState({}, 2, dynamicStates);
+
+	const vk::PipelineRasterizationStateCreateInfo rasterizerState({}, VK_FALSE, VK_FALSE, static_cast<vk::PolygonMode>(state.polygonMode),
+		vk::CullModeFlags(state.cullMode), static_cast<vk::FrontFace>(state.frontFace), VK_FALSE, 0, 0, 0, 1.f);
+	// enabling multisampling requires a GPU logical device feature to be enabled during creation
+	const vk::PipelineMultisampleStateCreateInfo multisampleState({}, vk::SampleCountFlagBits::e1, VK_FALSE, 1.f, nullptr, VK_FALSE, VK_FALSE);
+	// ignored for subpasses without a depth attachment
+	const vk::PipelineDepthStencilStateCreateInfo depthStencilState({}, state.depthTest, state.depthWrite, static_cast<vk::CompareOp>(state.depthCompare));
+
+	const auto blendAttachment = getBlendState(state.blendMode, vk::ColorComponentFlags(state.colorWriteMask));
+	const std::vector<vk::PipelineColorBlendAttachmentState> blendAttachments(state.colorAttachments, blendAttachment);
+	const vk::PipelineColorBlendStateCreateInfo colorBlending({}, VK_FALSE, vk::LogicOp::eCopy, state.colorAttachments, blendAttachments.data());
+
+	const vk::GraphicsPipelineCreateInfo createInfo({}, hasFragmentShader ? 2 : 1, shaderStages, &vertexInputInfo, &inputAssembly, nullptr, &viewportState,
+		&rasterizerState, &multisampleState, &depthStencilState, &colorBlending, &dynamicState,
+		this->layouts[state.layout], this->renderPasses[state.renderPass], state.subpass, nullptr, -1);
+	return this->device.createGraphicsPipelines(this->pipelineCache, createInfo)[0];
+}
@@ -0,0 +1,119 @@
+#pragma once
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+#include "../assets/AssetArchive.hpp"
+
+using PipelineHandle = uint32_t;
+using ShaderHandle = uint16_t;
+
+// fragment shader of depth only pipelines
+const ShaderHandle NoShader = 0xFFFF;
+
+enum class VertexLayout : uint8_t
+{
+	None,          // vertices are generated in the shader
+	PackedVertex   // vkp::assets::PackedVertex
+};
+
+enum class BlendMode : uint8_t
+{
+	Opaque,
+	AlphaBlend,
+	Additive
+};
+
+// Everything that goes into a graphics pipeline, 20 bytes without padding so it can be hashed and compared bytewise.
+// Shaders, layouts and render passes are referenced by the small indices handed out by the registry, Vulkan enums are
+// stored as their 8 bit values. Viewport and scissor are always dynamic.
+struct PipelineState
+{
+	ShaderHandle vertexShader = 0;
+	ShaderHandle fragmentShader = 0;
+	uint16_t layout = 0;      // RegisterLayout
+	uint16_t renderPass = 0;  // RegisterRenderPass, the pipeline is usable with every compatible render pass
+	uint8_t subpass = 0;
+	VertexLayout vertexLayout = VertexLayout::PackedVertex;
+	uint8_t topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+	uint8_t polygonMode = VK_POLYGON_MODE_FILL;
+	uint8_t cullMode = VK_CULL_MODE_BACK_BIT;
+	uint8_t frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+	BlendMode blendMode = BlendMode::Opaque;
+	uint8_t colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+	uint8_t depthTest = VK_FALSE;
+	uint8_t depthWrite = VK_FALSE;
+	uint8_t depthCompare = VK_COMPARE_OP_LESS_OR_EQUAL;
+	uint8_t colorAttachments = 1;  // color attachments of the subpass, 0 for depth only subpasses
+
+	bool operator==(const PipelineState& other) const;
+	bool operator!=(const PipelineState& other) const { return !(*this == other); }
+};
+
+struct PipelineStateHash
+{
+	size_t operator()(const PipelineState& state) const;
+};
+
+struct PipelineRegistryStats
+{
+	uint32_t states;        // distinct states registered
+	uint32_t pipelines;     // pipelines created so far
+	uint64_t registrations; // Register calls, including duplicates
+	uint64_t duplicates;    // Register calls that returned an existing handle
+	double createMilliseconds;
+};
+
+// Deduplicates pipeline states and creates the pipelines lazily the first time they are requested.
+// Handles are indices that stay valid for the lifetime of the registry, so materials can store them and share pipelines.
+// Shader modules are loaded from the asset archive once per name and owned by the registry, layouts and render passes
+// are owned by the caller and have to outlive the registry. All methods may be called from several threads.
+class PipelineRegistry
+{
+	struct Entry
+	{
+		PipelineState state;
+		vk::Pipeline pipeline;
+	};
+
+	vk::Device device;
+	const vkp::assets::AssetArchive& assets;
+	vk::PipelineCache pipelineCache;
+	mutable std::mutex mutex;
+
+	std::unordered_map<std::string, ShaderHandle> shaderNames;
+	std::vector<vk::ShaderModule> shaders;
+	std::vector<vk::PipelineLayout> layouts;
+	std::vector<vk::RenderPass> renderPasses;
+	std::vector<Entry> entries;
+	std::unordered_map<PipelineState, PipelineHandle, PipelineStateHash> lookup;
+	std::unordered_map<uint32_t, vk::Pipeline> computePipelines;  // keyed by shader and layout
+	PipelineRegistryStats stats = {};
+
+	vk::Pipeline CreatePipeline(const PipelineState& state);
+
+public:
+	PipelineRegistry(vk::Device device, const vkp::assets::AssetArchive& assets);
+	~PipelineRegistry();
+
+	PipelineRegistry(const PipelineRegistry&) = delete;
+	PipelineRegistry& operator=(const PipelineRegistry&) = delete;
+
+	ShaderHandle LoadShader(const std::string& name);
+	uint16_t RegisterLayout(vk::PipelineLayout layout);
+	uint16_t RegisterRenderPass(vk::RenderPass renderPass);
+
+	// returns the existing handle if an identical state was registered before, nothing is created yet
+	PipelineHandle Register(const PipelineState& state);
+
+	// creates the pipeline on first use
+	vk::Pipeline Get(PipelineHandle handle);
+	vk::PipelineLayout GetLayout(PipelineHandle handle) const;
+	PipelineState GetState(PipelineHandle handle) const;
+
+	// compute pipelines have no state besides shader and layout, they are created on first request and cached by both
+	vk::Pipeline GetComputePipeline(ShaderHandle shader, uint16_t layout);
+
+	PipelineRegistryStats GetStats() const;
+};
@@ -0,0 +1,620 @@
+#include "RenderDevice.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <limits>
+#include <SDL_vulkan.h>
+#include <spdlog/spdlog.h>
+#include "../utils/Rating.hpp"
+
+static_assert(sizeof(MeshPushConstants) <= 128, "MeshPushConstants exceed the push constant size every device supports");
+
+namespace
+{
+	uint64_t scenePassKey(vk::Format format, bool depthPrepass, bool postProcess)
+	{
+		return static_cast<uint64_t>(format) << 2 | (postProcess ? 2 : 0) | (depthPrepass ? 1 : 0);
+	}
+
+	std::vector<const char*> getExtensions(SDL_Window* window)
+	{
+		std::vector<const char*> extensions;
+
+		// headless devices only render offscreen and need no surface extensions
+		if (window)
+		{
+			uint32_t extCount = 0;
+			if (!SDL_Vulkan_GetInstanceExtensions(window, &extCount, nullptr))
+				throw std::exception(SDL_GetError());
+
+			extensions.resize(extCount);
+			if (!SDL_Vulkan_GetInstanceExtensions(window, &extCount, extensions.data()))
+				throw std::exception(SDL_GetError());
+		}
+
+#if _DEBUG
+		extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+#endif
+
+		return extensions;
+	}
+
+	std::vector<const char*> getLayers()
+	{
+		std::vector<const char*> layers =
+		{
+#if _DEBUG
+			"VK_LAYER_LUNARG_standard_validation"
+#endif
+		};
+		return layers;
+	}
+
+	VKAPI_ATTR vk::Bool32 VKAPI_CALL debugCallback(
+		VkDebugUtilsMessageSeverityFlagBitsEXT severity,
+		VkDebugUtilsMessageTypeFlagsEXT type,
+		const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData,
+		void* pUserData)
+	{
+		if (type == VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT && severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT)
+			return VK_FALSE;
+
+		const char* loggerName;
+		if (type == VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT)
+			loggerName = "vk-perf";
+		else if (type == VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT)
+			loggerName = "vk-val";
+		else
+			loggerName = "vk-general";
+
+		if (severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT)
+			spdlog::get(loggerName)->error(pCallbackData->pMessage);
+		else if (severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT)
+			spdlog::get(loggerName)->warn(pCallbackData->pMessage);
+		else if (severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT)
+			spdlog::get(loggerName)->info(pCallbackData->pMessage);
+		else if (severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT)
+			spdlog::get(loggerName)->trace(pCallbackData->pMessage);
+
+		return VK_FALSE;
+	}
+
+	bool hasExtension(const std::vector<vk::ExtensionProperties>& extensions, const char* name)
+	{
+		return std::find_if(extensions.begin(), extensions.end(), [name](const vk::ExtensionProperties& ext) { return strcmp(ext.extensionName, name) == 0; }) != extensions.end();
+	}
+
+	float ratePhysicalDevice(const vk::PhysicalDevice& physicalDevice, bool requireSwapchain)
+	{
+		if (requireSwapchain && !hasExtension(physicalDevice.enumerateDeviceExtensionProperties(), VK_KHR_SWAPCHAIN_EXTENSION_NAME))
+			return -1;
+
+		const auto props = physicalDevice.getProperties();
+		if (props.deviceType == vk::PhysicalDeviceType::eDiscreteGpu)
+			return 100;
+		if (props.deviceType == vk::PhysicalDeviceType::eIntegratedGpu)
+			return 50;
+		if (props.deviceType == vk::PhysicalDeviceType::eCpu)
+			return 10;
+		if (props.deviceType == vk::PhysicalDeviceType::eVirtualGpu)
+			return 1;
+
+		return -1;
+	}
+}
+
+RenderDevice::RenderDevice(SDL_Window* window, const std::string& assetArchive, uint32_t maxGraphicsQueues)
+{
+	this->assets = std::make_unique<vkp::assets::AssetArchive>(assetArchive);
+	this->presentSupported = window != nullptr;
+
+	this->CreateInstance(window);
+	this->PickPhysicalDevice();
+
+	// the present queue is picked for a throwaway surface of the window, later surfaces of the same kind are compatible
+	vk::SurfaceKHR surface;
+	if (window)
+		surface = this->CreateSurface(window);
+	this->CreateDevice(surface, std::max(maxGraphicsQueues, 1u));
+	if (surface)
+		this->instance.destroySurfaceKHR(surface);
+	this->PickDepthFormat();
+	this->PickSceneColorFormat();
+
+	this->pipelineRegistry = std::make_unique<PipelineRegistry>(this->device, *this->assets);
+	this->descriptorLayouts = std::make_unique<DescriptorLayoutCache>(this->device);
+	this->CreateSceneLayouts();
+}
+
+RenderDevice::~RenderDevice()
+{
+	if (this->device)
+		this->device.waitIdle();
+
+	this->pipelineRegistry.reset();
+	this->descriptorLayouts.reset();
+
+	if (this->meshPipelineLayout)
+	{
+		this->device.destroyPipelineLayout(this->meshPipelineLayout);
+		this->meshPipelineLayout = nullptr;
+	}
+
+	if (this->lightCullingLayout)
+	{
+		this->device.destroyPipelineLayout(this->lightCullingLayout);
+		this->lightCullingLayout = nullptr;
+	}
+
+	if (this->postPipelineLayout)
+	{
+		this->device.destroyPipelineLayout(this->postPipelineLayout);
+		this->postPipelineLayout = nullptr;
+	}
+
+	for (auto& renderPass : this->renderPasses)
+		this->device.destroyRenderPass(renderPass.second);
+	this->renderPasses.clear();
+
+	if (this->device)
+	{
+		this->device.destroy();
+		this->device = nullptr;
+	}
+
+	this->DestroyDebugCallback();
+
+	if (this->instance)
+	{
+		this->instance.destroy();
+		this->instance = nullptr;
+	}
+}
+
+void RenderDevice::RegisterDebugCallback()
+{
+	vk::DebugUtilsMessengerCreateInfoEXT createInfo(
+		vk::DebugUtilsMessengerCreateFlagsEXT(),
+		vk::DebugUtilsMessageSeverityFlagBitsEXT::eVerbose | vk::DebugUtilsMessageSeverityFlagBitsEXT::eInfo | vk::DebugUtilsMessageSeverityFlagBitsEXT::eWarning | vk::DebugUtilsMessageSeverityFlagBitsEXT::eError,
+		vk::DebugUtilsMessageTypeFlagBitsEXT::eGeneral | vk::DebugUtilsMessageTypeFlagBitsEXT::ePerformance | vk::DebugUtilsMessageTypeFlagBitsEXT::eValidation,
+		debugCallback,
+		nullptr);
+
+	const auto func = reinterpret_cast<PFN_vkCreateDebugUtilsMessengerEXT>(vkGetInstanceProcAddr(static_cast<VkInstance>(this->instance), "vkCreateDebugUtilsMessengerEXT"));
+	func(static_cast<VkInstance>(this->instance), reinterpret_cast<const struct VkDebugUtilsMessengerCreateInfoEXT*>(&createInfo), nullptr, &this->callback);
+}
+
+void RenderDevice::DestroyDebugCallback()
+{
+	if (this->callback)
+	{
+		const auto func = reinterpret_cast<PFN_vkDestroyDebugUtilsMessengerEXT>(vkGetInstanceProcAddr(
+			static_cast<VkInstance>(this->instance), "vkDestroyDebugUtilsMessengerEXT"));
+		func(static_cast<VkInstance>(this->instance), this->callback, nullptr);
+		this->callback = VK_NULL_HANDLE;
+	}
+}
+
+void RenderDevice::CreateInstance(SDL_Window* window)
+{
+	auto log = spdlog::get("logger");
+	log->info("Initializing vulkan instance");
+
+	vk::ApplicationInfo appInfo("VkPlayground", VK_MAKE_VERSION(0, 1, 0), "unnamed", VK_MAKE_VERSION(0, 1, 0), VK_API_VERSION_1_1);
+
+	auto extensions = getExtensions(window);
+	auto layers = getLayers();
+
+	for (auto& extension : extensions)
+		log->info("Requesting extension {0}", extension);
+
+	this->instance = vk::createInstance(vk::InstanceCreateInfo({}, &appInfo, static_cast<uint32_t>(layers.size()), layers.data(), static_cast<uint32_t>(extensions.size()), extensions.data()));
+	assert(instance);
+
+	if (std::find(extensions.begin(), extensions.end(), VK_EXT_DEBUG_UTILS_EXTENSION_NAME) != extensions.end())
+		this->RegisterDebugCallback();
+}
+
+vk::SurfaceKHR RenderDevice::CreateSurface(SDL_Window* window) const
+{
+	vk::SurfaceKHR surface;
+	if (!SDL_Vulkan_CreateSurface(window, static_cast<VkInstance>(this->instance), reinterpret_cast<VkSurfaceKHR*>(&surface)))
+		throw std::exception(SDL_GetError());
+	return surface;
+}
+
+void RenderDevice::PickPhysicalDevice()
+{
+	auto log = spdlog::get("logger");
+
+	auto i = 0;
+	auto deviceList = this->instance.enumeratePhysicalDevices();
+	for (auto& device : deviceList)
+	{
+		auto props = device.getProperties();
+		log->info("[{0}] Name: {1}, Driver: {2}, Api: {3}", i++, props.deviceName, props.driverVersion, props.apiVersion);
+	}
+
+	const auto requireSwapchain = this->presentSupported;
+	const auto r = GetBestRatedElement<vk::PhysicalDevice>(deviceList, [requireSwapchain](const vk::PhysicalDevice& device) { return ratePhysicalDevice(device, requireSwapchain); });
+	if (r.score <= 0)
+		throw std::exception("No suitable physical device found");
+
+	this->physicalDevice = r.element;
+	auto props = this->physicalDevice.getProperties();
+	log->info("Using GPU {0}", props.deviceName);
+}
+
+void RenderDevice::CreateDevice(vk::SurfaceKHR presentSurface, uint32_t maxGraphicsQueues)
+{
+	const auto families = this->physicalDevice.getQueueFamilyProperties();
+	auto graphicsQueue = GetBestRatedElement<vk::QueueFamilyProperties>(families, [](const auto& p)
+	{
+		float score = -100;
+		if (p.queueFlags & vk::QueueFlagBits::eGraphics)
+			score += 200.0f;
+		if (p.queueFlags & vk::QueueFlagBits::eTransfer)
+			score += 10.0f;
+		return score;
+	});
+
+	if (graphicsQueue.score <= 0)
+		throw std::exception("Unable to find device queue with graphics support");
+
+	auto physicalDevice = this->physicalDevice;
+	auto graphicsIndex = graphicsQueue.index;
+	auto presentIndex = graphicsQueue.index;
+	if (presentSurface)
+	{
+		// presenting from the graphics family avoids a second queue
+		auto presentQueue = GetBestRatedElement<vk::QueueFamilyProperties>(families, [physicalDevice, presentSurface, graphicsIndex](const auto& p, int index)
+		{
+			float score = -100;
+			if (physicalDevice.getSurfaceSupportKHR(index, presentSurface))
+				score += index == graphicsIndex ? 210 : 200;
+
+			return score;
+		});
+
+		if (presentQueue.score <= 0)
+			throw std::exception("Unable to find device queue with present support");
+		presentIndex = presentQueue.index;
+	}
+
+	// several graphics queues let independent sessions submit without contending for one queue
+	const auto graphicsQueueCount = std::min(maxGraphicsQueues, families[graphicsIndex].queueCount);
+	const std::vector<float> graphicsPriorities(graphicsQueueCount, 1.f);
+	const auto presentPriority = 1.f;
+
+	std::vector<vk::DeviceQueueCreateInfo> queueCreateInfos;
+	queueCreateInfos.emplace_back(vk::DeviceQueueCreateInfo({}, graphicsIndex, graphicsQueueCount, graphicsPriorities.data()));
+	if (presentIndex != graphicsIndex)
+		queueCreateInfos.emplace_back(vk::DeviceQueueCreateInfo({}, presentIndex, 1, &presentPriority));
+
+	std::vector<const char*> deviceExtensions;
+	if (presentSurface)
+		deviceExtensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+
+	this->memoryBudgetSupported = hasExtension(this->physicalDevice.enumerateDeviceExtensionProperties(), VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+	if (this->memoryBudgetSupported)
+		deviceExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+
+	// fragment invocation counts of the scene are only available with pipeline statistics queries
+	vk::PhysicalDeviceFeatures features;
+	features.pipelineStatisticsQuery = this->physicalDevice.getFeatures().pipelineStatisticsQuery;
+	this->pipelineStatisticsSupported = features.pipelineStatisticsQuery == VK_TRUE;
+
+	// tilers back transient attachments with lazily allocated memory that is only committed if an attachment leaves tile memory,
+	// sessions check per attachment whether its format and usage can use it
+	const auto memoryProperties = this->physicalDevice.getMemoryProperties();
+	for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+	{
+		if (memoryProperties.memoryTypes[i].propertyFlags & vk::MemoryPropertyFlagBits::eLazilyAllocated)
+			this->lazilyAllocatedSupported = true;
+	}
+	spdlog::get("vk-perf")->info("Lazily allocated memory {0}", this->lazilyAllocatedSupported ? "available" : "unavailable");
+
+	const vk::DeviceCreateInfo createInfo({}, static_cast<uint32_t>(queueCreateInfos.size()), queueCreateInfos.data(), 0, nullptr, static_cast<uint32_t>(deviceExtensions.size()), deviceExtensions.data(), &features);
+	this->device = this->physicalDevice.createDevice(createInfo);
+
+	this->queueInfo.graphicsQueueFamilyIndex = graphicsIndex;
+	this->queueInfo.presentQueueFamilyIndex = presentIndex;
+	for (uint32_t i = 0; i < graphicsQueueCount; i++)
+	{
+		this->queueInfo.graphicsQueues.push_back(this->device.getQueue(graphicsIndex, i));
+		this->queueMutexes.push_back(std::make_unique<std::mutex>());
+	}
+	if (presentSurface)
+		this->queueInfo.presentQueue = this->device.getQueue(presentIndex, 0);
+
+	spdlog::get("logger")->info("Using {0} graphics queue(s) of family {1}", graphicsQueueCount, graphicsIndex);
+}
+
+void RenderDevice::PickDepthFormat()
+{
+	const vk::Format candidates[] = { vk::Format::eD32Sfloat, vk::Format::eX8D24UnormPack32, vk::Format::eD24UnormS8Uint, vk::Format::eD32SfloatS8Uint, vk::Format::eD16Unorm };
+	for (const auto format : candidates)
+	{
+		if (this->physicalDevice.getFormatProperties(format).optimalTilingFeatures & vk::FormatFeatureFlagBits::eDepthStencilAttachment)
+		{
+			this->depthFormat = format;
+			return;
+		}
+	}
+	throw std::exception("No supported depth attachment format found");
+}
+
+void RenderDevice::PickSceneColorFormat()
+{
+	// the mesh pipeline blends, so the format needs blending as color attachment besides the range for tonemapping
+	const auto features = vk::FormatFeatureFlagBits::eColorAttachment | vk::FormatFeatureFlagBits::eColorAttachmentBlend;
+	const vk::Format candidates[] = { vk::Format::eR16G16B16A16Sfloat, vk::Format::eB10G11R11UfloatPack32 };
+	for (const auto format : candidates)
+	{
+		if ((this->physicalDevice.getFormatProperties(format).optimalTilingFeatures & features) == features)
+		{
+			this->sceneColorFormat = format;
+			return;
+		}
+	}
+
+	// every device can blend into 8 bit targets, tonemapping then only compresses the range the scene had anyway
+	spdlog::get("vk-perf")->warn("No blendable floating point color format, scene color is stored in 8 bit");
+	this->sceneColorFormat = vk::Format::eR8G8B8A8Unorm;
+}
+
+void RenderDevice::CreateSceneLayouts()
+{
+	this->meshSetLayout = this->descriptorLayouts->Get({ vk::DescriptorSetLayoutBinding(0, vk::DescriptorType::eCombinedImageSampler, 1, vk::ShaderStageFlagBits::eFragment, nullptr) });
+
+	// the culling pass writes the grid and index list that the mesh fragment shader reads, both see the same set
+	const auto lightStages = vk::ShaderStageFlagBits::eCompute | vk::ShaderStageFlagBits::eFragment;
+	this->lightSetLayout = this->descriptorLayouts->Get(
+	{
+		vk::DescriptorSetLayoutBinding(0, vk::DescriptorType::eUniformBuffer, 1, lightStages, nullptr),
+		vk::DescriptorSetLayoutBinding(1, vk::DescriptorType::eStorageBuffer, 1, lightStages, nullptr),
+		vk::DescriptorSetLayoutBinding(2, vk::DescriptorType::eStorageBuffer, 1, lightStages, nullptr),
+		vk::DescriptorSetLayoutBinding(3, vk::DescriptorType::eStorageBuffer, 1, lightStages, nullptr)
+	});
+
+	const vk::DescriptorSetLayout meshSetLayouts[] = { this->meshSetLayout, this->lightSetLayout };
+	vk::PushConstantRange pushConstantRange(vk::ShaderStageFlagBits::eVertex, 0, sizeof(MeshPushConstants));
+	vk::PipelineLayoutCreateInfo pipelineLayoutCreateInfo({}, 2, meshSetLayouts, 1, &pushConstantRange);
+	this->meshPipelineLayout = this->device.createPipelineLayout(pipelineLayoutCreateInfo);
+
+	vk::PushConstantRange cullingPushConstantRange(vk::ShaderStageFlagBits::eCompute, 0, sizeof(LightCullingPushConstants));
+	vk::PipelineLayoutCreateInfo cullingLayoutCreateInfo({}, 1, &this->lightSetLayout, 1, &cullingPushConstantRange);
+	this->lightCullingLayout = this->device.createPipelineLayout(cullingLayoutCreateInfo);
+
+	this->postSetLayout = this->descriptorLayouts->Get({ vk::DescriptorSetLayoutBinding(0, vk::DescriptorType::eInputAttachment, 1, vk::ShaderStageFlagBits::eFragment, nullptr) });
+	vk::PushConstantRange postPushConstantRange(vk::ShaderStageFlagBits::eFragment, 0, sizeof(PostProcessPushConstants));
+	vk::PipelineLayoutCreateInfo postLayoutCreateInfo({}, 1, &this->postSetLayout, 1, &postPushConstantRange);
+	this->postPipelineLayout = this->device.createPipelineLayout(postLayoutCreateInfo);
+}
+
+vk::Pipeline RenderDevice::GetLightCullingPipeline()
+{
+	auto& registry = *this->pipelineRegistry;
+	return registry.GetComputePipeline(registry.LoadShader("shader/cluster_lights.comp.spv"), registry.RegisterLayout(this->lightCullingLayout));
+}
+
+std::mutex& RenderDevice::GetQueueMutex(vk::Queue queue)
+{
+	// the present queue is graphics queue 0 when both share a family
+	for (size_t i = 0; i < this->queueInfo.graphicsQueues.size(); i++)
+	{
+		if (this->queueInfo.graphicsQueues[i] == queue)
+			return *this->queueMutexes[i];
+	}
+	return this->presentMutex;
+}
+
+uint32_t RenderDevice::AcquireQueue()
+{
+	return this->nextQueue.fetch_add(1) % static_cast<uint32_t>(this->queueInfo.graphicsQueues.size());
+}
+
+vk::Result RenderDevice::Submit(uint32_t queue, uint32_t submitCount, const vk::SubmitInfo* submits, vk::Fence fence)
+{
+	std::lock_guard<std::mutex> lock(*this->queueMutexes[queue]);
+	return this->queueInfo.graphicsQueues[queue].submit(submitCount, submits, fence);
+}
+
+vk::Result RenderDevice::Present(const vk::PresentInfoKHR& presentInfo)
+{
+	std::lock_guard<std::mutex> lock(this->GetQueueMutex(this->queueInfo.presentQueue));
+	return this->queueInfo.presentQueue.presentKHR(&presentInfo);
+}
+
+void RenderDevice::SubmitImmediate(uint32_t queue, vk::CommandPool commandPool, const std::function<void(vk::CommandBuffer)>& record)
+{
+	const vk::CommandBufferAllocateInfo allocateInfo(commandPool, vk::CommandBufferLevel::ePrimary, 1);
+	auto commandBuffer = this->device.allocateCommandBuffers(allocateInfo)[0];
+
+	commandBuffer.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit, nullptr));
+	record(commandBuffer);
+	commandBuffer.end();
+
+	// waits on a fence instead of the queue so other sessions keep submitting meanwhile
+	const auto fence = this->device.createFence({});
+	const vk::SubmitInfo submitInfo(0, nullptr, nullptr, 1, &commandBuffer, 0, nullptr);
+	if (this->Submit(queue, 1, &submitInfo, fence) != vk::Result::eSuccess)
+		throw std::exception("error while submitting command buffer to graphics queue");
+	this->device.waitForFences(1, &fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+
+	this->device.destroyFence(fence);
+	this->device.freeCommandBuffers(commandPool, commandBuffer);
+}
+
+vk::RenderPass RenderDevice::GetRenderPass(vk::Format format, bool depthPrepass, bool postProcess)
+{
+	std::lock_guard<std::mutex> lock(this->renderPassMutex);
+	const auto key = scenePassKey(format, depthPrepass, postProcess);
+	const auto found = this->renderPasses.find(key);
+	if (found != this->renderPasses.end())
+		return found->second;
+
+	// with post-processing the target is completely overwritten by the composite subpass and needs no clear
+	std::vector<vk::AttachmentDescription> attachments =
+	{
+		vk::AttachmentDescription({}, format,
+			vk::SampleCountFlagBits::e1, postProcess ? vk::AttachmentLoadOp::eDontCare : vk::AttachmentLoadOp::eClear, vk::AttachmentStoreOp::eStore,
+			vk::AttachmentLoadOp::eDontCare, vk::AttachmentStoreOp::eDontCare,
+			vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferSrcOptimal),
+		// depth is only needed within the pass
+		vk::AttachmentDescription({}, this->depthFormat,
+			vk::SampleCountFlagBits::e1, vk::AttachmentLoadOp::eClear, vk::AttachmentStoreOp::eDontCare,
+			vk::AttachmentLoadOp::eDontCare, vk::AttachmentStoreOp::eDontCare,
+			vk::ImageLayout::eUndefined, vk::ImageLayout::eDepthStencilAttachmentOptimal)
+	};
+
+	// the intermediates are consumed by the next subpass and never stored, tilers keep them in tile memory
+	if (postProcess)
+	{
+		attachments.push_back(vk::AttachmentDescription({}, this->sceneColorFormat,
+			vk::SampleCountFlagBits::e1, vk::AttachmentLoadOp::eClear, vk::AttachmentStoreOp::eDontCare,
+			vk::AttachmentLoadOp::eDontCare, vk::AttachmentStoreOp::eDontCare,
+			vk::ImageLayout::eUndefined, vk::ImageLayout::eShaderReadOnlyOptimal));
+		attachments.push_back(vk::AttachmentDescription({}, format,
+			vk::SampleCountFlagBits::e1, vk::AttachmentLoadOp::eDontCare, vk::AttachmentStoreOp::eDontCare,
+			vk::AttachmentLoadOp::eDontCare, vk::AttachmentStoreOp::eDontCare,
+			vk::ImageLayout::eUndefined, vk::ImageLayout::eShaderReadOnlyOptimal));
+	}
+
+	const vk::AttachmentReference colorAttachmentRef(postProcess ? 2 : 0, vk::ImageLayout::eColorAttachmentOptimal);
+	const vk::AttachmentReference depthAttachmentRef(1, vk::ImageLayout::eDepthStencilAttachmentOptimal);
+	const vk::AttachmentReference depthReadOnlyRef(1, vk::ImageLayout::eDepthStencilReadOnlyOptimal);
+	const vk::AttachmentReference sceneColorInputRef(2, vk::ImageLayout::eShaderReadOnlyOptimal);
+	const vk::AttachmentReference tonemappedRef(3, vk::ImageLayout::eColorAttachmentOptimal);
+	const vk::AttachmentReference tonemappedInputRef(3, vk::ImageLayout::eShaderReadOnlyOptimal);
+	const vk::AttachmentReference targetRef(0, vk::ImageLayout::eColorAttachmentOptimal);
+
+	// with the pre-pass, subpass 0 only lays down depth and the color subpass tests against it without writing
+	std::vector<vk::SubpassDescription> subpasses;
+	if (depthPrepass)
+	{
+		subpasses.push_back(vk::SubpassDescription({}, vk::PipelineBindPoint::eGraphics, 0, nullptr, 0, nullptr, nullptr, &depthAttachmentRef));
+		subpasses.push_back(vk::SubpassDescription({}, vk::PipelineBindPoint::eGraphics, 0, nullptr, 1, &colorAttachmentRef, nullptr, &depthReadOnlyRef));
+	}
+	else
+		subpasses.push_back(vk::SubpassDescription({}, vk::PipelineBindPoint::eGraphics, 0, nullptr, 1, &colorAttachmentRef, nullptr, &depthAttachmentRef));
+	const auto colorSubpass = static_cast<uint32_t>(subpasses.size() - 1);
+
+	// full screen effects only read the pixel they write, so they chain as subpasses instead of render passes
+	if (postProcess)
+	{
+		subpasses.push_back(vk::SubpassDescription({}, vk::PipelineBindPoint::eGraphics, 1, &sceneColorInputRef, 1, &tonemappedRef, nullptr, nullptr));
+		subpasses.push_back(vk::SubpassDescription({}, vk::PipelineBindPoint::eGraphics, 1, &tonemappedInputRef, 1, &targetRef, nullptr, nullptr));
+	}
+	const auto lastSubpass = static_cast<uint32_t>(subpasses.size() - 1);
+
+	// the render target is blitted or copied after the pass and read again by the transfer of the previous use,
+	// depth is cleared again so only the tests of the previous use of the depth image have to be done
+	const auto depthStages = vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests;
+	std::vector<vk::SubpassDependency> subpassDependencies =
+	{
+		vk::SubpassDependency(
+			VK_SUBPASS_EXTERNAL, 0,
+			vk::PipelineStageFlagBits::eTransfer | vk::PipelineStageFlagBits::eColorAttachmentOutput | depthStages,
+			vk::PipelineStageFlagBits::eColorAttachmentOutput | depthStages,
+			{}, vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentRead | vk::AccessFlagBits::eDepthStencilAttachmentWrite),
+		vk::SubpassDependency(
+			lastSubpass, VK_SUBPASS_EXTERNAL,
+			vk::PipelineStageFlagBits::eColorAttachmentOutput,
+			vk::PipelineStageFlagBits::eTransfer,
+			vk::AccessFlagBits::eColorAttachmentWrite, vk::AccessFlagBits::eTransferRead)
+	};
+	if (depthPrepass)
+	{
+		subpassDependencies.push_back(vk::SubpassDependency(
+			0, 1,
+			depthStages, depthStages,
+			vk::AccessFlagBits::eDepthStencilAttachmentWrite, vk::AccessFlagBits::eDepthStencilAttachmentRead,
+			vk::DependencyFlagBits::eByRegion));
+	}
+	if (postProcess)
+	{
+		// the target is first written by the composite subpass, its layout transition has to wait for the previous transfer
+		subpassDependencies.push_back(vk::SubpassDependency(
+			VK_SUBPASS_EXTERNAL, lastSubpass,
+			vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eColorAttachmentOutput,
+			{}, vk::AccessFlagBits::eColorAttachmentWrite));
+
+		for (auto subpass = colorSubpass; subpass < lastSubpass; subpass++)
+		{
+			subpassDependencies.push_back(vk::SubpassDependency(
+				subpass, subpass + 1,
+				vk::PipelineStageFlagBits::eColorAttachmentOutput, vk::PipelineStageFlagBits::eFragmentShader,
+				vk::AccessFlagBits::eColorAttachmentWrite, vk::AccessFlagBits::eInputAttachmentRead,
+				vk::DependencyFlagBits::eByRegion));
+		}
+	}
+
+	const vk::RenderPassCreateInfo createInfo({}, static_cast<uint32_t>(attachments.size()), attachments.data(), static_cast<uint32_t>(subpasses.size()), subpasses.data(),
+		static_cast<uint32_t>(subpassDependencies.size()), subpassDependencies.data());
+	const auto renderPass = this->device.createRenderPass(createInfo);
+	this->renderPasses.emplace(key, renderPass);
+	return renderPass;
+}
+
+ScenePipelines RenderDevice::GetScenePipelines(vk::Format format, bool depthPrepass, bool postProcess)
+{
+	ScenePipelines pipelines = {};
+	pipelines.renderPass = this->GetRenderPass(format, depthPrepass, postProcess);
+
+	std::lock_guard<std::mutex> lock(this->renderPassMutex);
+	const auto key = scenePassKey(format, depthPrepass, postProcess);
+	const auto found = this->scenePipelines.find(key);
+	if (found != this->scenePipelines.end())
+		return found->second;
+
+	auto& registry = *this->pipelineRegistry;
+	PipelineState state;
+	state.vertexShader = registry.LoadShader("shader/mesh.vert.spv");
+	state.fragmentShader = registry.LoadShader("shader/mesh.frag.spv");
+	state.layout = registry.RegisterLayout(this->meshPipelineLayout);
+	state.renderPass = registry.RegisterRenderPass(pipelines.renderPass);
+	state.vertexLayout = VertexLayout::PackedVertex;
+	state.blendMode = BlendMode::AlphaBlend;
+	state.depthTest = VK_TRUE;
+	state.depthWrite = VK_TRUE;
+	state.depthCompare = VK_COMPARE_OP_LESS_OR_EQUAL;
+
+	if (depthPrepass)
+	{
+		// same vertex shader as the color pass, so both produce bit identical depth and eEqual passes exactly the front most fragments
+		auto depthState = state;
+		depthState.fragmentShader = NoShader;
+		depthState.blendMode = BlendMode::Opaque;
+		depthState.colorWriteMask = 0;
+		depthState.colorAttachments = 0;
+		pipelines.depth = registry.Register(depthState);
+
+		state.subpass = 1;
+		state.depthWrite = VK_FALSE;
+		state.depthCompare = VK_COMPARE_OP_EQUAL;
+	}
+	pipelines.mesh = registry.Register(state);
+
+	if (postProcess)
+	{
+		// one full screen triangle per subpass, the fragment shaders read the previous subpass at their own pixel
+		PipelineState postState;
+		postState.vertexShader = registry.LoadShader("shader/fullscreen.vert.spv");
+		postState.layout = registry.RegisterLayout(this->postPipelineLayout);
+		postState.renderPass = state.renderPass;
+		postState.vertexLayout = VertexLayout::None;
+		postState.cullMode = VK_CULL_MODE_NONE;
+
+		postState.subpass = static_cast<uint8_t>(state.subpass + 1);
+		postState.fragmentShader = registry.LoadShader("shader/tonemap.frag.spv");
+		pipelines.tonemap = registry.Register(postState);
+
+		postState.subpass = static_cast<uint8_t>(state.subpass + 2);
+		postState.fragmentShader = registry.LoadShader("shader/composite.frag.spv");
+		pipelines.composite = registry.Register(postState);
+	}
+
+	this->scenePipelines.emplace(key, pipelines);
+	return pipelines;
+}
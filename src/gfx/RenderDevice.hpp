@@ -0,0 +1,155 @@
+#pragma once
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <SDL.h>
+#include <vulkan/vulkan.hpp>
+#include "../assets/AssetArchive.hpp"
+#include "../utils/Math.hpp"
+#include "DescriptorAllocator.hpp"
+#include "PipelineRegistry.hpp"
+
+struct QueueInfo
+{
+	uint32_t graphicsQueueFamilyIndex;
+	std::vector<vk::Queue> graphicsQueues;
+	uint32_t presentQueueFamilyIndex;
+	vk::Queue presentQueue;
+};
+
+// push constants of the mesh pipeline
+struct MeshPushConstants
+{
+	vkp::math::Mat4 mvp;
+	float positionScale[4];
+	float positionOffset[4];
+	float uvScaleOffset[4];
+	float modelTransform[4];  // translation xyz and rotation about y of the model matrix, for world space lighting
+};
+
+// push constants of the light culling compute pipeline
+struct LightCullingPushConstants
+{
+	vkp::math::Mat4 view;
+};
+
+// push constants of the post-processing pipelines, shared by all of them
+struct PostProcessPushConstants
+{
+	float exposure;
+	float vignette;
+	float extent[2];  // rendered area in pixels
+};
+
+// render pass of the scene and the pipelines recorded into it
+struct ScenePipelines
+{
+	vk::RenderPass renderPass;
+	PipelineHandle depth;      // depth only pipeline of the pre-pass subpass, only set with a depth pre-pass
+	PipelineHandle mesh;       // mesh pipeline of the color subpass
+	PipelineHandle tonemap;    // post-processing subpasses, only set with post-processing
+	PipelineHandle composite;
+};
+
+// Device level state shared by every render session: instance, device, queues, assets and the pipeline/layout caches.
+// Sessions may run on different threads. Queue access is serialized per queue, sessions are spread over the graphics
+// queues of the device round robin. Everything else handed out here is either immutable or internally synchronized.
+class RenderDevice
+{
+	vk::Instance instance;
+	VkDebugUtilsMessengerEXT callback = VK_NULL_HANDLE;
+	vk::PhysicalDevice physicalDevice;
+	vk::Device device;
+	QueueInfo queueInfo = {};
+	std::vector<std::unique_ptr<std::mutex>> queueMutexes;
+	std::mutex presentMutex;
+	bool memoryBudgetSupported = false;
+	bool presentSupported = false;
+	bool pipelineStatisticsSupported = false;
+	bool lazilyAllocatedSupported = false;
+	vk::Format depthFormat = vk::Format::eUndefined;
+	vk::Format sceneColorFormat = vk::Format::eUndefined;
+	std::atomic<uint32_t> nextQueue{ 0 };
+
+	std::unique_ptr<vkp::assets::AssetArchive> assets;
+	std::unique_ptr<PipelineRegistry> pipelineRegistry;
+	std::unique_ptr<DescriptorLayoutCache> descriptorLayouts;
+	vk::DescriptorSetLayout meshSetLayout;
+	vk::DescriptorSetLayout lightSetLayout;
+	vk::DescriptorSetLayout postSetLayout;
+	vk::PipelineLayout meshPipelineLayout;
+	vk::PipelineLayout lightCullingLayout;
+	vk::PipelineLayout postPipelineLayout;
+
+	std::mutex renderPassMutex;
+	std::unordered_map<uint64_t, vk::RenderPass> renderPasses;  // keyed by color format, pre-pass and post-processing
+	std::unordered_map<uint64_t, ScenePipelines> scenePipelines;
+
+	void RegisterDebugCallback();
+	void DestroyDebugCallback();
+	void CreateInstance(SDL_Window* window);
+	void PickPhysicalDevice();
+	void CreateDevice(vk::SurfaceKHR presentSurface, uint32_t maxGraphicsQueues);
+	void PickDepthFormat();
+	void PickSceneColorFormat();
+	void CreateSceneLayouts();
+
+	std::mutex& GetQueueMutex(vk::Queue queue);
+
+public:
+	// window: picks a device and present queue that can present to windows like it, nullptr creates a headless device.
+	// maxGraphicsQueues: upper bound for the graphics queues sessions are distributed over
+	RenderDevice(SDL_Window* window, const std::string& assetArchive, uint32_t maxGraphicsQueues = 1);
+	~RenderDevice();
+
+	RenderDevice(const RenderDevice&) = delete;
+	RenderDevice& operator=(const RenderDevice&) = delete;
+
+	vk::Instance GetInstance() const { return this->instance; }
+	vk::PhysicalDevice GetPhysicalDevice() const { return this->physicalDevice; }
+	vk::Device GetDevice() const { return this->device; }
+	const QueueInfo& GetQueueInfo() const { return this->queueInfo; }
+	bool HasMemoryBudget() const { return this->memoryBudgetSupported; }
+	bool CanPresent() const { return this->presentSupported; }
+	bool HasPipelineStatistics() const { return this->pipelineStatisticsSupported; }
+	bool HasLazilyAllocatedMemory() const { return this->lazilyAllocatedSupported; }
+	vk::Format GetDepthFormat() const { return this->depthFormat; }
+	vk::Format GetSceneColorFormat() const { return this->sceneColorFormat; }
+	const vkp::assets::AssetArchive& GetAssets() const { return *this->assets; }
+	PipelineRegistry& GetPipelineRegistry() { return *this->pipelineRegistry; }
+	DescriptorLayoutCache& GetDescriptorLayouts() { return *this->descriptorLayouts; }
+
+	// the surface has to be destroyed by the caller through the instance
+	vk::SurfaceKHR CreateSurface(SDL_Window* window) const;
+
+	// graphics queue index for a new session
+	uint32_t AcquireQueue();
+	vk::Result Submit(uint32_t queue, uint32_t submitCount, const vk::SubmitInfo* submits, vk::Fence fence);
+	vk::Result Present(const vk::PresentInfoKHR& presentInfo);
+
+	// records and submits a one time command buffer from the given pool and waits for it to finish
+	void SubmitImmediate(uint32_t queue, vk::CommandPool commandPool, const std::function<void(vk::CommandBuffer)>& record);
+
+	// scene render pass for color targets of the given format plus a GetDepthFormat attachment, created once per variant.
+	// depthPrepass: subpass 0 writes depth only, subpass 1 shades color with depth tests against it and writes disabled.
+	// postProcess: the scene is shaded into a GetSceneColorFormat attachment (2) instead, followed by a tonemap subpass into an
+	// attachment of the target format (3) and a composite subpass into the target, each reading the previous one as input attachment
+	vk::RenderPass GetRenderPass(vk::Format format, bool depthPrepass, bool postProcess);
+
+	// pipelines for the render pass of the variant, sessions with the same format, pre-pass and post-processing setting share them
+	ScenePipelines GetScenePipelines(vk::Format format, bool depthPrepass, bool postProcess);
+	vk::DescriptorSetLayout GetMeshSetLayout() const { return this->meshSetLayout; }
+
+	// set 1 of the mesh pipelines and set 0 of the light culling pipeline: cluster parameters, lights, cluster grid and light indices
+	vk::DescriptorSetLayout GetLightSetLayout() const { return this->lightSetLayout; }
+	vk::PipelineLayout GetLightCullingLayout() const { return this->lightCullingLayout; }
+
+	// set 0 of the post-processing pipelines: the input attachment read by the subpass
+	vk::DescriptorSetLayout GetPostSetLayout() const { return this->postSetLayout; }
+
+	// compute pipeline assigning the lights to the clusters of the view frustum, created on first use
+	vk::Pipeline GetLightCullingPipeline();
+};
@@ -0,0 +1,101 @@
+#include "RenderQueue.hpp"
+#include <algorithm>
+
+namespace
+{
+	const uint32_t PASS_BITS = 4;
+	const uint32_t PIPELINE_BITS = 12;
+	const uint32_t MATERIAL_BITS = 16;
+	const uint32_t MESH_BITS = 12;
+	const uint32_t DEPTH_BITS = 20;
+
+	const uint32_t RADIX_BITS = 8;
+	const uint32_t RADIX_SIZE = 1 << RADIX_BITS;
+	const uint32_t RADIX_DIGITS = 64 / RADIX_BITS;
+
+	uint64_t field(uint32_t value, uint32_t bits)
+	{
+		return static_cast<uint64_t>(value) & ((1ull << bits) - 1);
+	}
+}
+
+uint64_t RenderQueue::MakeKey(uint32_t pass, uint32_t pipeline, uint32_t material, uint32_t mesh, float depth)
+{
+	const auto quantizedDepth = static_cast<uint32_t>(std::clamp(depth, 0.f, 1.f) * ((1 << DEPTH_BITS) - 1));
+
+	uint64_t key = field(pass, PASS_BITS);
+	key = (key << PIPELINE_BITS) | field(pipeline, PIPELINE_BITS);
+	key = (key << MATERIAL_BITS) | field(material, MATERIAL_BITS);
+	key = (key << MESH_BITS) | field(mesh, MESH_BITS);
+	key = (key << DEPTH_BITS) | field(quantizedDepth, DEPTH_BITS);
+	return key;
+}
+
+void RenderQueue::Clear()
+{
+	this->items.clear();
+	this->keys.clear();
+	this->order.clear();
+	this->stats = {};
+}
+
+void RenderQueue::Add(uint64_t key, const DrawItem& item)
+{
+	this->order.push_back(static_cast<uint32_t>(this->items.size()));
+	this->keys.push_back(key);
+	this->items.push_back(item);
+}
+
+void RenderQueue::Sort()
+{
+	const auto start = std::chrono::high_resolution_clock::now();
+	const auto count = this->keys.size();
+
+	this->order.resize(count);
+	for (uint32_t i = 0; i < count; i++)
+		this->order[i] = i;
+
+	// sort a copy of the keys alongside the indices so every pass reads keys sequentially
+	auto& sortKeys = this->sortKeys;
+	sortKeys.assign(this->keys.begin(), this->keys.end());
+	this->scratchKeys.resize(count);
+	this->scratchOrder.resize(count);
+
+	// histograms of all digits in a single pass over the keys
+	std::vector<uint32_t> histograms(RADIX_DIGITS * RADIX_SIZE, 0);
+	for (const auto key : sortKeys)
+	{
+		for (uint32_t digit = 0; digit < RADIX_DIGITS; digit++)
+			histograms[digit * RADIX_SIZE + ((key >> (digit * RADIX_BITS)) & (RADIX_SIZE - 1))]++;
+	}
+
+	for (uint32_t digit = 0; digit < RADIX_DIGITS; digit++)
+	{
+		auto histogram = &histograms[digit * RADIX_SIZE];
+
+		// keys share this digit (i.e. a single pass or pipeline), the scatter would not change the order
+		if (count == 0 || histogram[(sortKeys[0] >> (digit * RADIX_BITS)) & (RADIX_SIZE - 1)] == count)
+			continue;
+
+		uint32_t offset = 0;
+		for (uint32_t bucket = 0; bucket < RADIX_SIZE; bucket++)
+		{
+			const auto size = histogram[bucket];
+			histogram[bucket] = offset;
+			offset += size;
+		}
+
+		const auto shift = digit * RADIX_BITS;
+		for (size_t i = 0; i < count; i++)
+		{
+			const auto destination = histogram[(sortKeys[i] >> shift) & (RADIX_SIZE - 1)]++;
+			this->scratchKeys[destination] = sortKeys[i];
+			this->scratchOrder[destination] = this->order[i];
+		}
+
+		std::swap(sortKeys, this->scratchKeys);
+		std::swap(this->order, this->scratchOrder);
+	}
+
+	this->stats.sortMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
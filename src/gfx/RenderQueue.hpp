@@ -0,0 +1,136 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+struct DrawItem
+{
+	uint32_t pipeline;  // index into the pipelines passed to Record
+	uint32_t material;  // index into the materials passed to Record
+	uint32_t mesh;      // index into the meshes passed to Record
+	uint32_t instance;  // handed to the push constant callback
+};
+
+struct RenderPipeline
+{
+	vk::Pipeline pipeline;
+	vk::PipelineLayout layout;
+};
+
+struct RenderMaterial
+{
+	vk::DescriptorSet descriptorSet;
+};
+
+struct RenderMesh
+{
+	vk::Buffer vertexBuffer;
+	vk::Buffer indexBuffer;
+	vk::IndexType indexType;
+	uint32_t indexCount;
+};
+
+struct RenderQueueStats
+{
+	uint32_t draws;
+	uint32_t pipelineBinds;
+	uint32_t descriptorBinds;
+	uint32_t vertexBufferBinds;
+	uint32_t indexBufferBinds;
+	double sortMilliseconds;
+	double recordMilliseconds;
+};
+
+// Collects the draws of a frame, sorts them by key and records them while skipping state that is already bound.
+// Sort key layout, most significant first: pass (4 bits) | pipeline (12 bits) | material (16 bits) | mesh (12 bits) | depth (20 bits).
+// Within a pass draws are grouped by the most expensive state first, depth only orders draws that share all state (front to back).
+class RenderQueue
+{
+	std::vector<DrawItem> items;
+	std::vector<uint64_t> keys;
+	std::vector<uint32_t> order;
+	std::vector<uint64_t> sortKeys;
+	std::vector<uint64_t> scratchKeys;
+	std::vector<uint32_t> scratchOrder;
+	RenderQueueStats stats = {};
+
+public:
+	// ids are truncated to their bit width, depth is clamped to [0, 1]
+	static uint64_t MakeKey(uint32_t pass, uint32_t pipeline, uint32_t material, uint32_t mesh, float depth);
+
+	void Clear();
+	void Add(uint64_t key, const DrawItem& item);
+
+	// LSD radix sort over 8 bit digits, digits that are equal for all keys are skipped.
+	// Without sorting draws are recorded in submission order.
+	void Sort();
+
+	size_t GetSize() const { return this->items.size(); }
+	const std::vector<uint32_t>& GetOrder() const { return this->order; }
+	const DrawItem& GetItem(uint32_t index) const { return this->items[index]; }
+	// draws, binds and record time of the last Record call, sort time of the last Sort
+	const RenderQueueStats& GetStats() const { return this->stats; }
+
+	// CommandTarget is vk::CommandBuffer or anything with the same bind/draw methods.
+	// pushInstance(target, layout, instance) records the per draw push constants.
+	template<typename CommandTarget, typename PushInstance>
+	void Record(CommandTarget& target, const std::vector<RenderPipeline>& pipelines, const std::vector<RenderMaterial>& materials,
+		const std::vector<RenderMesh>& meshes, const PushInstance& pushInstance, bool skipRedundantState = true)
+	{
+		const auto start = std::chrono::high_resolution_clock::now();
+		const auto sortMilliseconds = this->stats.sortMilliseconds;
+		this->stats = {};
+		this->stats.sortMilliseconds = sortMilliseconds;
+
+		const uint32_t None = ~0u;
+		auto boundPipeline = None;
+		auto boundMaterial = None;
+		auto boundMesh = None;
+		vk::PipelineLayout boundLayout;
+
+		for (const auto index : this->order)
+		{
+			const auto& item = this->items[index];
+			const auto& pipeline = pipelines[item.pipeline];
+
+			if (!skipRedundantState || item.pipeline != boundPipeline)
+			{
+				target.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline.pipeline);
+				this->stats.pipelineBinds++;
+				boundPipeline = item.pipeline;
+
+				// sets bound with a different layout are disturbed by the pipeline change
+				if (pipeline.layout != boundLayout)
+				{
+					boundLayout = pipeline.layout;
+					boundMaterial = None;
+				}
+			}
+
+			if (!skipRedundantState || item.material != boundMaterial)
+			{
+				target.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipeline.layout, 0, materials[item.material].descriptorSet, nullptr);
+				this->stats.descriptorBinds++;
+				boundMaterial = item.material;
+			}
+
+			const auto& mesh = meshes[item.mesh];
+			if (!skipRedundantState || item.mesh != boundMesh)
+			{
+				const vk::DeviceSize offset = 0;
+				target.bindVertexBuffers(0, 1, &mesh.vertexBuffer, &offset);
+				target.bindIndexBuffer(mesh.indexBuffer, 0, mesh.indexType);
+				this->stats.vertexBufferBinds++;
+				this->stats.indexBufferBinds++;
+				boundMesh = item.mesh;
+			}
+
+			pushInstance(target, pipeline.layout, item.instance);
+			target.drawIndexed(mesh.indexCount, 1, 0, 0, 0);
+			this->stats.draws++;
+		}
+
+		this->stats.recordMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+};
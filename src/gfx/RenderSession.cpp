@@ -0,0 +1,574 @@
+#include "RenderSession.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <utility>
+#include <spdlog/spdlog.h>
+#include "../assets/MeshFormat.hpp"
+
+namespace
+{
+	const uint32_t MAX_FRAMES_IN_FLIGHT = 2;
+	const char* SCENE_MESH = "mesh/cube.vkmesh";
+	const char* SCENE_TEXTURE = "textures/checker.ktx2";
+	const vk::DeviceSize TEXTURE_UPLOAD_BUDGET = 8 * 1024 * 1024;
+	const vk::DeviceSize DEFRAG_BYTES_PER_FRAME = 4 * 1024 * 1024;
+	const uint32_t DESCRIPTOR_SETS_PER_POOL = 64;
+	const float TARGET_FRAME_TIME = 1000.f / 60.f;
+	const float MIN_RENDER_SCALE = 0.5f;
+	const float POST_EXPOSURE = 1.2f;
+	const float POST_VIGNETTE = 0.4f;
+	const float CAMERA_FOV = 1.0472f;
+	const float CAMERA_NEAR = 0.1f;
+	const float CAMERA_FAR = 100.f;
+	const uint32_t TIMESTAMPS_PER_FRAME = 4;  // frame start after uploads, light culling start and end, frame end
+}
+
+RenderSession::RenderSession(RenderDevice& renderDevice, vk::Format format, vk::Extent2D extent, const RenderSessionSettings& settings)
+	: renderDevice(renderDevice), device(renderDevice.GetDevice()), queue(renderDevice.AcquireQueue()), format(format), settings(settings), extent(extent), renderExtent(extent)
+{
+	const auto physicalDevice = this->renderDevice.GetPhysicalDevice();
+
+	// command buffers are re-recorded every frame
+	const vk::CommandPoolCreateInfo poolCreateInfo(vk::CommandPoolCreateFlagBits::eResetCommandBuffer, this->renderDevice.GetQueueInfo().graphicsQueueFamilyIndex);
+	this->commandPool = this->device.createCommandPool(poolCreateInfo);
+	this->commandBuffers = this->device.allocateCommandBuffers(vk::CommandBufferAllocateInfo(this->commandPool, vk::CommandBufferLevel::ePrimary, MAX_FRAMES_IN_FLIGHT));
+	for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+		this->inFlightFences.emplace_back(this->device.createFence(vk::FenceCreateInfo(vk::FenceCreateFlagBits::eSignaled)));
+
+	this->allocator = std::make_unique<MemoryAllocator>(physicalDevice, this->device, MAX_FRAMES_IN_FLIGHT, this->renderDevice.HasMemoryBudget());
+
+	this->mesh = this->LoadMesh(SCENE_MESH);
+	this->allocator->SetMovable(this->mesh.vertexAllocation, {}, [this](AllocationHandle allocation) { this->mesh.vertexBuffer = this->allocator->GetBuffer(allocation); });
+	this->allocator->SetMovable(this->mesh.indexAllocation, {}, [this](AllocationHandle allocation) { this->mesh.indexBuffer = this->allocator->GetBuffer(allocation); });
+
+	this->texturePool = std::make_unique<TexturePool>(physicalDevice, this->device, *this->allocator, this->renderDevice.GetAssets(), MAX_FRAMES_IN_FLIGHT, TEXTURE_UPLOAD_BUDGET);
+	this->sceneTexture = this->texturePool->Load(SCENE_TEXTURE);
+
+	// sets are transient, the texture view changes whenever the pool streams in or evicts a level
+	this->descriptorAllocator = std::make_unique<DescriptorAllocator>(this->device, MAX_FRAMES_IN_FLIGHT, DESCRIPTOR_SETS_PER_POOL);
+	this->lightClusters = std::make_unique<LightClusters>(this->renderDevice, *this->allocator, MAX_FRAMES_IN_FLIGHT, this->settings.lightCount);
+
+	// render passes and pipelines are shared with every other session rendering to the same format
+	this->settings.sceneInstances = std::max(this->settings.sceneInstances, 1u);
+	this->scenePipelines = this->renderDevice.GetScenePipelines(this->format, this->settings.depthPrepass, this->settings.postProcess);
+
+	this->CreateRenderTargets();
+	this->CreateTimestampQueries();
+	this->CreateStatisticsQueries();
+}
+
+RenderSession::~RenderSession()
+{
+	this->WaitIdle();
+
+	this->DestroyRenderTargets();
+	this->texturePool.reset();
+	this->DestroyMesh(this->mesh);
+	this->lightClusters.reset();
+	this->descriptorAllocator.reset();
+	this->allocator.reset();
+
+	for (auto& fence : this->inFlightFences)
+		this->device.destroyFence(fence);
+	this->inFlightFences.clear();
+
+	if (this->timestampQueryPool)
+	{
+		this->device.destroyQueryPool(this->timestampQueryPool);
+		this->timestampQueryPool = nullptr;
+	}
+
+	if (this->statisticsQueryPool)
+	{
+		this->device.destroyQueryPool(this->statisticsQueryPool);
+		this->statisticsQueryPool = nullptr;
+	}
+
+	if (this->commandPool)
+	{
+		this->device.destroyCommandPool(this->commandPool);
+		this->commandPool = nullptr;
+	}
+}
+
+void RenderSession::WaitIdle()
+{
+	if (!this->inFlightFences.empty())
+		this->device.waitForFences(this->inFlightFences, VK_TRUE, std::numeric_limits<uint64_t>::max());
+}
+
+void RenderSession::Resize(vk::Extent2D extent)
+{
+	this->WaitIdle();
+
+	// the post-processing input sets reference the target views, which are destroyed right away
+	this->descriptorAllocator->Invalidate();
+	this->DestroyRenderTargets();
+	this->extent = extent;
+	this->renderExtent = extent;
+	this->CreateRenderTargets();
+}
+
+void RenderSession::CreateRenderTargets()
+{
+	// allocated at the full extent, dynamic resolution only changes the rendered area
+	const vk::ImageCreateInfo imageCreateInfo({}, vk::ImageType::e2D, this->format, vk::Extent3D(this->extent.width, this->extent.height, 1),
+		1, 1, vk::SampleCountFlagBits::e1, vk::ImageTiling::eOptimal,
+		vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferSrc,
+		vk::SharingMode::eExclusive, 0, nullptr, vk::ImageLayout::eUndefined);
+
+	// one target per frame in flight so the scene never waits for the transfer of the previous frame
+	this->renderTargets.resize(MAX_FRAMES_IN_FLIGHT);
+	this->statistics.transientAttachments = 0;
+	this->statistics.lazilyAllocatedAttachments = 0;
+	for (auto& target : this->renderTargets)
+	{
+		target.image = this->allocator->CreateImage(imageCreateInfo, vk::MemoryPropertyFlagBits::eDeviceLocal, target.allocation);
+		const vk::ImageViewCreateInfo viewCreateInfo({}, target.image, vk::ImageViewType::e2D, this->format, {}, vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1));
+		target.view = this->device.createImageView(viewCreateInfo);
+
+		target.depthView = this->CreateTransientAttachment(this->renderDevice.GetDepthFormat(), vk::ImageUsageFlagBits::eDepthStencilAttachment, vk::ImageAspectFlagBits::eDepth,
+			target.depthImage, target.depthAllocation);
+
+		std::vector<vk::ImageView> attachments = { target.view, target.depthView };
+		if (this->settings.postProcess)
+		{
+			const auto inputUsage = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eInputAttachment;
+			target.sceneColorView = this->CreateTransientAttachment(this->renderDevice.GetSceneColorFormat(), inputUsage, vk::ImageAspectFlagBits::eColor,
+				target.sceneColorImage, target.sceneColorAllocation);
+			target.tonemappedView = this->CreateTransientAttachment(this->format, inputUsage, vk::ImageAspectFlagBits::eColor,
+				target.tonemappedImage, target.tonemappedAllocation);
+			attachments.push_back(target.sceneColorView);
+			attachments.push_back(target.tonemappedView);
+		}
+
+		const vk::FramebufferCreateInfo framebufferCreateInfo({}, this->scenePipelines.renderPass, static_cast<uint32_t>(attachments.size()), attachments.data(),
+			this->extent.width, this->extent.height, 1);
+		target.frameBuffer = this->device.createFramebuffer(framebufferCreateInfo);
+	}
+}
+
+vk::ImageView RenderSession::CreateTransientAttachment(vk::Format format, vk::ImageUsageFlags usage, vk::ImageAspectFlags aspect, vk::Image& image, AllocationHandle& allocation)
+{
+	const vk::ImageCreateInfo imageCreateInfo({}, vk::ImageType::e2D, format, vk::Extent3D(this->extent.width, this->extent.height, 1),
+		1, 1, vk::SampleCountFlagBits::e1, vk::ImageTiling::eOptimal, usage | vk::ImageUsageFlagBits::eTransientAttachment,
+		vk::SharingMode::eExclusive, 0, nullptr, vk::ImageLayout::eUndefined);
+
+	// attachments that are never loaded or stored need no memory at all on tilers. Whether lazily allocated memory can back an
+	// image depends on its format and usage, so every attachment falls back to ordinary device memory on its own.
+	image = this->allocator->CreateImage(imageCreateInfo, vk::MemoryPropertyFlagBits::eLazilyAllocated, vk::MemoryPropertyFlagBits::eDeviceLocal, allocation);
+	if (this->allocator->GetMemoryProperties(allocation) & vk::MemoryPropertyFlagBits::eLazilyAllocated)
+		this->statistics.lazilyAllocatedAttachments++;
+	this->statistics.transientAttachments++;
+
+	const vk::ImageViewCreateInfo viewCreateInfo({}, image, vk::ImageViewType::e2D, format, {}, vk::ImageSubresourceRange(aspect, 0, 1, 0, 1));
+	return this->device.createImageView(viewCreateInfo);
+}
+
+void RenderSession::DestroyRenderTargets()
+{
+	for (auto& target : this->renderTargets)
+	{
+		this->device.destroyFramebuffer(target.frameBuffer);
+		this->device.destroyImageView(target.view);
+		this->device.destroyImageView(target.depthView);
+		this->allocator->Destroy(target.allocation);
+		this->allocator->Destroy(target.depthAllocation);
+
+		if (target.sceneColorImage)
+		{
+			this->device.destroyImageView(target.sceneColorView);
+			this->device.destroyImageView(target.tonemappedView);
+			this->allocator->Destroy(target.sceneColorAllocation);
+			this->allocator->Destroy(target.tonemappedAllocation);
+		}
+	}
+	this->renderTargets.clear();
+}
+
+void RenderSession::CreateTimestampQueries()
+{
+	const auto physicalDevice = this->renderDevice.GetPhysicalDevice();
+	const auto families = physicalDevice.getQueueFamilyProperties();
+	const auto validBits = families[this->renderDevice.GetQueueInfo().graphicsQueueFamilyIndex].timestampValidBits;
+	this->frameRenderScale.assign(MAX_FRAMES_IN_FLIGHT, 0.f);
+	this->dynamicResolution = std::make_unique<DynamicResolution>(TARGET_FRAME_TIME, this->settings.dynamicResolution ? MIN_RENDER_SCALE : 1.f);
+
+	// without timestamps there is nothing to drive the resolution, it stays at 100%
+	if (validBits == 0)
+	{
+		spdlog::get("vk-perf")->warn("Graphics queue does not support timestamps, dynamic resolution disabled");
+		return;
+	}
+
+	this->timestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+	this->timestampPeriod = physicalDevice.getProperties().limits.timestampPeriod;
+	this->timestampQueryPool = this->device.createQueryPool(vk::QueryPoolCreateInfo({}, vk::QueryType::eTimestamp, MAX_FRAMES_IN_FLIGHT * TIMESTAMPS_PER_FRAME, {}));
+}
+
+void RenderSession::CreateStatisticsQueries()
+{
+	this->statisticsPending.assign(MAX_FRAMES_IN_FLIGHT, false);
+	if (!this->settings.pipelineStatistics)
+		return;
+
+	if (!this->renderDevice.HasPipelineStatistics())
+	{
+		spdlog::get("vk-perf")->warn("Device does not support pipeline statistics queries, fragment invocations are not counted");
+		return;
+	}
+
+	this->statisticsQueryPool = this->device.createQueryPool(vk::QueryPoolCreateInfo({}, vk::QueryType::ePipelineStatistics, MAX_FRAMES_IN_FLIGHT,
+		vk::QueryPipelineStatisticFlagBits::eFragmentShaderInvocations));
+}
+
+void RenderSession::ReadFrameTimings()
+{
+	// called after the fence of the frame slot signaled, so its timestamps are available
+	const auto renderScale = this->frameRenderScale[this->currentFrame];
+	if (!this->timestampQueryPool || renderScale == 0.f)
+		return;
+
+	uint64_t timestamps[TIMESTAMPS_PER_FRAME];
+	const auto result = this->device.getQueryPoolResults(this->timestampQueryPool, this->currentFrame * TIMESTAMPS_PER_FRAME, TIMESTAMPS_PER_FRAME,
+		sizeof(timestamps), timestamps, sizeof(uint64_t), vk::QueryResultFlagBits::e64);
+	if (result != vk::Result::eSuccess)
+		return;
+
+	const auto toMilliseconds = [this](uint64_t begin, uint64_t end) { return ((end - begin) & this->timestampMask) * this->timestampPeriod / 1000000.0; };
+	const auto frameTime = toMilliseconds(timestamps[0], timestamps[3]);
+	this->dynamicResolution->Update(static_cast<float>(frameTime), renderScale);
+
+	auto& statistics = this->statistics;
+	statistics.timedFrames++;
+	statistics.lastGpuMilliseconds = frameTime;
+	statistics.averageGpuMilliseconds += (frameTime - statistics.averageGpuMilliseconds) / statistics.timedFrames;
+	statistics.averageCullingMilliseconds += (toMilliseconds(timestamps[1], timestamps[2]) - statistics.averageCullingMilliseconds) / statistics.timedFrames;
+}
+
+void RenderSession::ReadFrameStatistics()
+{
+	// like the timestamps the results of this slot are available once its fence signaled
+	if (!this->statisticsQueryPool || !this->statisticsPending[this->currentFrame])
+		return;
+	this->statisticsPending[this->currentFrame] = false;
+
+	uint64_t fragmentInvocations;
+	const auto result = this->device.getQueryPoolResults(this->statisticsQueryPool, this->currentFrame, 1, sizeof(fragmentInvocations), &fragmentInvocations, sizeof(uint64_t), vk::QueryResultFlagBits::e64);
+	if (result != vk::Result::eSuccess)
+		return;
+
+	auto& statistics = this->statistics;
+	statistics.frames++;
+	statistics.fragmentInvocations = fragmentInvocations;
+	statistics.averageFragmentInvocations += (fragmentInvocations - statistics.averageFragmentInvocations) / statistics.frames;
+}
+
+void RenderSession::RequestTextureMips(const FrameSnapshot& snapshot)
+{
+	// usage feedback: pick the mip whose texel density matches the projected size of the mesh on screen
+	const auto radius = vkp::math::Length({ this->mesh.positionScale[0], this->mesh.positionScale[1], this->mesh.positionScale[2] });
+	const auto distance = vkp::math::Length(snapshot.cameraPosition - snapshot.cameraTarget);
+	const auto projectedSize = this->renderExtent.height * radius / (distance * std::tan(CAMERA_FOV * 0.5f));
+	const auto texelsPerPixel = this->texturePool->GetWidth(this->sceneTexture) / std::max(projectedSize, 1.f);
+	const auto mip = static_cast<uint32_t>(std::max(std::floor(std::log2(std::max(texelsPerPixel, 1.f))), 0.f));
+	this->texturePool->RequestMip(this->sceneTexture, mip, this->frameNumber);
+}
+
+uint32_t RenderSession::BeginFrame()
+{
+	this->device.waitForFences(1, &this->inFlightFences[this->currentFrame], VK_TRUE, std::numeric_limits<uint64_t>::max());
+	this->device.resetFences(1, &this->inFlightFences[this->currentFrame]);
+	this->allocator->BeginFrame(this->frameNumber);
+	this->descriptorAllocator->BeginFrame(this->currentFrame);
+	this->ReadFrameTimings();
+	this->ReadFrameStatistics();
+	return this->currentFrame;
+}
+
+vk::CommandBuffer RenderSession::RecordFrame(const FrameSnapshot& snapshot)
+{
+	this->dynamicResolution->Apply(this->extent.width, this->extent.height, this->renderExtent.width, this->renderExtent.height);
+	this->frameRenderScale[this->currentFrame] = this->dynamicResolution->GetScale();
+
+	auto commandBuffer = this->commandBuffers[this->currentFrame];
+	commandBuffer.reset({});
+	commandBuffer.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit, nullptr));
+
+	const auto firstTimestamp = this->currentFrame * TIMESTAMPS_PER_FRAME;
+	if (this->timestampQueryPool)
+		commandBuffer.resetQueryPool(this->timestampQueryPool, firstTimestamp, TIMESTAMPS_PER_FRAME);
+	if (this->statisticsQueryPool)
+		commandBuffer.resetQueryPool(this->statisticsQueryPool, this->currentFrame, 1);
+
+	// moved resources are patched through their callbacks before anything below picks up buffers, views or descriptors
+	this->allocator->Defragment(commandBuffer, DEFRAG_BYTES_PER_FRAME);
+
+	this->RequestTextureMips(snapshot);
+	this->texturePool->Update(commandBuffer, this->currentFrame, this->frameNumber);
+
+	// the frame is timed from here, once the relocations and uploads above completed, their cost depends on streaming and
+	// not on the render scale so dynamic resolution must not react to it
+	if (this->timestampQueryPool)
+		commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, this->timestampQueryPool, firstTimestamp);
+
+	const auto materialSet = this->descriptorAllocator->GetSet(this->renderDevice.GetMeshSetLayout(),
+	{
+		DescriptorResource::Image(0, vk::DescriptorType::eCombinedImageSampler, this->texturePool->GetSampler(), this->texturePool->GetView(this->sceneTexture), vk::ImageLayout::eShaderReadOnlyOptimal)
+	});
+
+	const auto width = static_cast<float>(this->renderExtent.width);
+	const auto height = static_cast<float>(this->renderExtent.height);
+	const auto projection = vkp::math::Perspective(CAMERA_FOV, width / height, CAMERA_NEAR, CAMERA_FAR);
+	const auto view = vkp::math::LookAt(snapshot.cameraPosition, snapshot.cameraTarget, { 0.f, 1.f, 0.f });
+	const auto viewProjection = projection * view;
+
+	// lights are assigned to the clusters of this frame's frustum before the scene pass reads them
+	this->lightClusters->Update(this->currentFrame, snapshot.time, projection, CAMERA_NEAR, CAMERA_FAR, this->renderExtent);
+	const auto lightSet = this->descriptorAllocator->GetSet(this->renderDevice.GetLightSetLayout(), this->lightClusters->GetResources(this->currentFrame));
+	if (this->timestampQueryPool)
+		commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, this->timestampQueryPool, firstTimestamp + 1);
+	this->lightClusters->Record(commandBuffer, this->currentFrame, view, lightSet);
+	if (this->timestampQueryPool)
+		commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eComputeShader, this->timestampQueryPool, firstTimestamp + 2);
+
+	// target, depth and with post-processing scene color and tonemapped color, only the cleared ones are used
+	const vk::ClearValue clearValues[] =
+	{
+		vk::ClearColorValue(std::array<float, 4> { 0.f, 0.f, 0.f, 1.f }),
+		vk::ClearDepthStencilValue(1.f, 0),
+		vk::ClearColorValue(std::array<float, 4> { 0.f, 0.f, 0.f, 1.f }),
+		vk::ClearColorValue(std::array<float, 4> { 0.f, 0.f, 0.f, 1.f })
+	};
+	vk::RenderPassBeginInfo renderPassInfo(this->scenePipelines.renderPass, this->renderTargets[this->currentFrame].frameBuffer, vk::Rect2D({0, 0}, this->renderExtent),
+		this->settings.postProcess ? 4 : 2, clearValues);
+	commandBuffer.beginRenderPass(&renderPassInfo, vk::SubpassContents::eInline);
+
+	vk::Viewport viewport(0, 0, width, height, 0.f, 1.f);
+	vk::Rect2D scissor({0, 0}, this->renderExtent);
+	commandBuffer.setViewport(0, viewport);
+	commandBuffer.setScissor(0, scissor);
+
+	// draws go through the render queue which orders them by state and skips redundant binds
+	auto& pipelineRegistry = this->renderDevice.GetPipelineRegistry();
+	const auto meshPipeline = this->scenePipelines.mesh;
+	const std::vector<RenderPipeline> pipelines = { { pipelineRegistry.Get(meshPipeline), pipelineRegistry.GetLayout(meshPipeline) } };
+	const std::vector<RenderMaterial> materials = { { materialSet } };
+	const std::vector<RenderMesh> meshes = { { this->mesh.vertexBuffer, this->mesh.indexBuffer, this->mesh.indexType, this->mesh.indexCount } };
+
+	// the light set stays bound at set 1 while the render queue switches the material set 0
+	commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipelines[0].layout, 1, lightSet, nullptr);
+
+	// additional instances are stacked behind the first one along the view direction and submitted back to front, the worst
+	// case for overdraw that state sorted queues run into whenever draws with different state overlap
+	const auto forward = vkp::math::Normalize(snapshot.cameraTarget - snapshot.cameraPosition);
+	const auto spacing = vkp::math::Length({ this->mesh.positionScale[0], this->mesh.positionScale[1], this->mesh.positionScale[2] }) * 0.5f;
+	const auto distance = vkp::math::Length(snapshot.cameraTarget - snapshot.cameraPosition);
+	this->renderQueue.Clear();
+	for (uint32_t instance = 0; instance < this->settings.sceneInstances; instance++)
+	{
+		const auto depth = (distance + instance * spacing) / CAMERA_FAR;
+		this->renderQueue.Add(RenderQueue::MakeKey(0, 0, 0, 0, this->settings.sceneInstances > 1 ? 1.f - depth : depth), { 0, 0, 0, instance });
+	}
+	this->renderQueue.Sort();
+
+	const auto pushInstance = [this, &snapshot, &viewProjection, &forward, spacing](vk::CommandBuffer& target, vk::PipelineLayout layout, uint32_t instance)
+	{
+		MeshPushConstants pushConstants = {};
+		const auto offset = forward * (instance * spacing);
+		const auto rotation = snapshot.meshRotation + instance * 0.4f;
+		pushConstants.mvp = viewProjection * vkp::math::Translation(offset) * vkp::math::RotationY(rotation);
+		std::copy_n(this->mesh.positionScale, 4, pushConstants.positionScale);
+		std::copy_n(this->mesh.positionOffset, 4, pushConstants.positionOffset);
+		std::copy_n(this->mesh.uvScaleOffset, 4, pushConstants.uvScaleOffset);
+		pushConstants.modelTransform[0] = offset.x;
+		pushConstants.modelTransform[1] = offset.y;
+		pushConstants.modelTransform[2] = offset.z;
+		pushConstants.modelTransform[3] = rotation;
+		target.pushConstants(layout, vk::ShaderStageFlagBits::eVertex, 0, sizeof(pushConstants), &pushConstants);
+	};
+
+	// the pre-pass records the same sorted draws with the depth only pipeline, the color subpass then only shades the
+	// fragments whose depth equals the front most one
+	this->prepassQueueStats = {};
+	if (this->settings.depthPrepass)
+	{
+		const auto depthPipeline = this->scenePipelines.depth;
+		const std::vector<RenderPipeline> depthPipelines = { { pipelineRegistry.Get(depthPipeline), pipelineRegistry.GetLayout(depthPipeline) } };
+		this->renderQueue.Record(commandBuffer, depthPipelines, materials, meshes, pushInstance);
+		this->prepassQueueStats = this->renderQueue.GetStats();
+		commandBuffer.nextSubpass(vk::SubpassContents::eInline);
+	}
+
+	if (this->statisticsQueryPool)
+		commandBuffer.beginQuery(this->statisticsQueryPool, this->currentFrame, {});
+	this->renderQueue.Record(commandBuffer, pipelines, materials, meshes, pushInstance);
+	if (this->statisticsQueryPool)
+	{
+		commandBuffer.endQuery(this->statisticsQueryPool, this->currentFrame);
+		this->statisticsPending[this->currentFrame] = true;
+	}
+
+	if (this->settings.postProcess)
+		this->RecordPostProcess(commandBuffer);
+
+	commandBuffer.endRenderPass();
+
+	if (this->timestampQueryPool)
+		commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, this->timestampQueryPool, firstTimestamp + 3);
+
+	return commandBuffer;
+}
+
+void RenderSession::RecordPostProcess(vk::CommandBuffer commandBuffer)
+{
+	// every effect is a full screen triangle in its own subpass reading the previous attachment at the same pixel
+	auto& pipelineRegistry = this->renderDevice.GetPipelineRegistry();
+	const auto& target = this->renderTargets[this->currentFrame];
+	const auto layout = pipelineRegistry.GetLayout(this->scenePipelines.tonemap);
+
+	PostProcessPushConstants pushConstants = {};
+	pushConstants.exposure = POST_EXPOSURE;
+	pushConstants.vignette = POST_VIGNETTE;
+	pushConstants.extent[0] = static_cast<float>(this->renderExtent.width);
+	pushConstants.extent[1] = static_cast<float>(this->renderExtent.height);
+
+	const std::pair<PipelineHandle, vk::ImageView> effects[] =
+	{
+		{ this->scenePipelines.tonemap, target.sceneColorView },
+		{ this->scenePipelines.composite, target.tonemappedView }
+	};
+	for (const auto& effect : effects)
+	{
+		commandBuffer.nextSubpass(vk::SubpassContents::eInline);
+		const auto inputSet = this->descriptorAllocator->GetSet(this->renderDevice.GetPostSetLayout(),
+		{
+			DescriptorResource::Image(0, vk::DescriptorType::eInputAttachment, nullptr, effect.second, vk::ImageLayout::eShaderReadOnlyOptimal)
+		});
+
+		commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pipelineRegistry.Get(effect.first));
+		commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, layout, 0, inputSet, nullptr);
+		commandBuffer.pushConstants(layout, vk::ShaderStageFlagBits::eFragment, 0, sizeof(pushConstants), &pushConstants);
+		commandBuffer.draw(3, 1, 0, 0);
+	}
+}
+
+void RenderSession::EndFrame()
+{
+	this->currentFrame = (this->currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+	this->frameNumber++;
+}
+
+GpuMesh RenderSession::LoadMesh(const std::string& name)
+{
+	const auto data = this->renderDevice.GetAssets().Get(name);
+	if (data.size < sizeof(vkp::assets::MeshHeader))
+		throw std::exception(std::string("mesh truncated: " + name).c_str());
+
+	const auto& header = *data.as<vkp::assets::MeshHeader>();
+	if (header.magic != vkp::assets::MeshMagic || header.version != vkp::assets::MeshVersion)
+		throw std::exception(std::string("not a mesh: " + name).c_str());
+	if (!vkp::assets::IsMeshLayoutValid(header, data.size))
+		throw std::exception(std::string("invalid mesh layout: " + name).c_str());
+
+	GpuMesh mesh = {};
+	mesh.indexCount = header.indexCount;
+	mesh.indexType = header.indexType == vkp::assets::MeshIndexType::UInt16 ? vk::IndexType::eUint16 : vk::IndexType::eUint32;
+	std::copy_n(header.positionScale, 3, mesh.positionScale);
+	std::copy_n(header.positionOffset, 3, mesh.positionOffset);
+	mesh.uvScaleOffset[0] = header.uvScale[0];
+	mesh.uvScaleOffset[1] = header.uvScale[1];
+	mesh.uvScaleOffset[2] = header.uvOffset[0];
+	mesh.uvScaleOffset[3] = header.uvOffset[1];
+
+	// both streams are stored in their GPU layout, so a single memcpy of the file region fills the staging buffer
+	const auto vertexSize = static_cast<vk::DeviceSize>(header.vertexCount) * header.vertexStride;
+	const auto streamSize = header.indexOffset + header.indexSize - header.vertexOffset;
+	const auto indexStagingOffset = header.indexOffset - header.vertexOffset;
+
+	AllocationHandle stagingAllocation;
+	const auto stagingBuffer = this->allocator->CreateBuffer(vk::BufferCreateInfo({}, streamSize, vk::BufferUsageFlagBits::eTransferSrc, vk::SharingMode::eExclusive),
+		vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, stagingAllocation);
+	std::memcpy(this->allocator->GetMappedData(stagingAllocation), data.data + header.vertexOffset, streamSize);
+
+	// transfer source usage allows the defragmenter to move the buffers
+	const auto transferUsage = vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eTransferDst;
+	mesh.vertexBuffer = this->allocator->CreateBuffer(vk::BufferCreateInfo({}, vertexSize, vk::BufferUsageFlagBits::eVertexBuffer | transferUsage, vk::SharingMode::eExclusive),
+		vk::MemoryPropertyFlagBits::eDeviceLocal, mesh.vertexAllocation);
+	mesh.indexBuffer = this->allocator->CreateBuffer(vk::BufferCreateInfo({}, header.indexSize, vk::BufferUsageFlagBits::eIndexBuffer | transferUsage, vk::SharingMode::eExclusive),
+		vk::MemoryPropertyFlagBits::eDeviceLocal, mesh.indexAllocation);
+
+	this->renderDevice.SubmitImmediate(this->queue, this->commandPool, [&](vk::CommandBuffer commandBuffer)
+	{
+		const vk::BufferCopy vertexRegion(0, 0, vertexSize);
+		const vk::BufferCopy indexRegion(indexStagingOffset, 0, header.indexSize);
+		commandBuffer.copyBuffer(stagingBuffer, mesh.vertexBuffer, 1, &vertexRegion);
+		commandBuffer.copyBuffer(stagingBuffer, mesh.indexBuffer, 1, &indexRegion);
+	});
+
+	this->allocator->Destroy(stagingAllocation);
+	return mesh;
+}
+
+void RenderSession::DestroyMesh(GpuMesh& mesh)
+{
+	if (mesh.vertexBuffer)
+		this->allocator->Destroy(mesh.vertexAllocation);
+	if (mesh.indexBuffer)
+		this->allocator->Destroy(mesh.indexAllocation);
+	mesh = {};
+}
+
+RenderQueueStats RenderSession::GetFrameQueueStats() const
+{
+	auto stats = this->renderQueue.GetStats();
+	const auto& prepass = this->prepassQueueStats;
+	stats.draws += prepass.draws;
+	stats.pipelineBinds += prepass.pipelineBinds;
+	stats.descriptorBinds += prepass.descriptorBinds;
+	stats.vertexBufferBinds += prepass.vertexBufferBinds;
+	stats.indexBufferBinds += prepass.indexBufferBinds;
+	stats.recordMilliseconds += prepass.recordMilliseconds;
+	return stats;
+}
+
+void RenderSession::LogStats() const
+{
+	auto log = spdlog::get("vk-perf");
+	this->allocator->LogStats();
+	log->info("Resolution scale {0:.2f} ({1}x{2}), GPU {3:.2f}/{4:.2f} ms", this->dynamicResolution->GetScale(),
+		this->renderExtent.width, this->renderExtent.height, this->dynamicResolution->GetFrameTime(), this->dynamicResolution->GetTargetFrameTime());
+	log->info("Transient attachments: {0} of {1} in lazily allocated memory", this->statistics.lazilyAllocatedAttachments, this->statistics.transientAttachments);
+
+	const auto& queueStats = this->renderQueue.GetStats();
+	log->info("Render queue: {0} draws, {1} pipeline, {2} descriptor, {3} vertex buffer binds, sort {4:.3f} ms, record {5:.3f} ms",
+		queueStats.draws, queueStats.pipelineBinds, queueStats.descriptorBinds, queueStats.vertexBufferBinds, queueStats.sortMilliseconds, queueStats.recordMilliseconds);
+	if (this->settings.depthPrepass)
+	{
+		const auto& prepassStats = this->prepassQueueStats;
+		log->info("Depth pre-pass: {0} draws, {1} pipeline, {2} descriptor, {3} vertex buffer binds, record {4:.3f} ms",
+			prepassStats.draws, prepassStats.pipelineBinds, prepassStats.descriptorBinds, prepassStats.vertexBufferBinds, prepassStats.recordMilliseconds);
+	}
+
+	const auto layoutStats = this->renderDevice.GetDescriptorLayouts().GetStats();
+	const auto& descriptorStats = this->descriptorAllocator->GetStats();
+	log->info("Descriptors: {0} layouts ({1}/{2} cache hits), {3} pools ({4} in use, {5} cache), {6}/{7} set cache hits, {8} sets cached, {9} written, {10} evicted, {11} pool resets",
+		layoutStats.layouts, layoutStats.hits, layoutStats.requests, descriptorStats.pools, descriptorStats.poolsInUse, descriptorStats.cachePools,
+		descriptorStats.hits, descriptorStats.requests, descriptorStats.cachedSets, descriptorStats.allocations, descriptorStats.evictions, descriptorStats.resets);
+
+	if (this->timestampQueryPool)
+	{
+		log->info("Lights: {0} in {1} clusters, culling {2:.3f} ms of {3:.3f} ms GPU per frame", this->lightClusters->GetLightCount(),
+			this->lightClusters->GetClusterCount(), this->statistics.averageCullingMilliseconds, this->statistics.averageGpuMilliseconds);
+	}
+
+	if (this->statisticsQueryPool)
+	{
+		const auto pixels = static_cast<double>(this->renderExtent.width) * this->renderExtent.height;
+		log->info("Fragment shader invocations: {0} last frame, {1:.0f} average ({2:.2f} per pixel), {3} instances, depth pre-pass {4}",
+			this->statistics.fragmentInvocations, this->statistics.averageFragmentInvocations, this->statistics.averageFragmentInvocations / pixels,
+			this->settings.sceneInstances, this->settings.depthPrepass ? "on" : "off");
+	}
+}
@@ -0,0 +1,162 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+#include "DescriptorAllocator.hpp"
+#include "DynamicResolution.hpp"
+#include "FrameSnapshot.hpp"
+#include "LightClusters.hpp"
+#include "MemoryAllocator.hpp"
+#include "RenderDevice.hpp"
+#include "RenderQueue.hpp"
+#include "TexturePool.hpp"
+
+struct GpuMesh
+{
+	vk::Buffer vertexBuffer;
+	AllocationHandle vertexAllocation;
+	vk::Buffer indexBuffer;
+	AllocationHandle indexAllocation;
+	vk::IndexType indexType;
+	uint32_t indexCount;
+	float positionScale[4];
+	float positionOffset[4];
+	float uvScaleOffset[4];
+};
+
+struct RenderTarget
+{
+	vk::Image image;
+	AllocationHandle allocation;
+	vk::ImageView view;
+	vk::Image depthImage;
+	AllocationHandle depthAllocation;
+	vk::ImageView depthView;
+	vk::Image sceneColorImage;         // post-processing input, only with post-processing
+	AllocationHandle sceneColorAllocation;
+	vk::ImageView sceneColorView;
+	vk::Image tonemappedImage;         // composite input, only with post-processing
+	AllocationHandle tonemappedAllocation;
+	vk::ImageView tonemappedView;
+	vk::Framebuffer frameBuffer;
+};
+
+struct RenderSessionSettings
+{
+	bool dynamicResolution = false;    // scale the rendered area by GPU frame time, otherwise the whole target is always rendered
+	bool depthPrepass = true;          // lay down depth first so the mesh shader runs once per pixel
+	uint32_t sceneInstances = 1;       // copies of the mesh stacked behind each other, more than 1 produces overdraw
+	bool pipelineStatistics = false;   // count fragment shader invocations of the color pass, if the device supports it
+	uint32_t lightCount = 0;           // point lights assigned to view frustum clusters by a compute pass every frame
+	bool postProcess = true;           // shade into a floating point attachment and tonemap and composite it in further subpasses
+};
+
+struct SessionStatistics
+{
+	uint64_t fragmentInvocations;      // of the color pass of the last frame with results
+	double averageFragmentInvocations;
+	uint64_t frames;                   // frames with statistics
+	double averageGpuMilliseconds;     // whole frame, from timestamps
+	double lastGpuMilliseconds;        // of the last frame with timestamps
+	double averageCullingMilliseconds; // light culling pass
+	uint64_t timedFrames;              // frames with timestamps
+	uint32_t transientAttachments;     // of the current render targets
+	uint32_t lazilyAllocatedAttachments;
+};
+
+// Session level state: one scene rendered at its own resolution into offscreen targets.
+// A session owns its memory, scene resources, command buffers and frame synchronization and only shares the RenderDevice,
+// so independent sessions can be driven from different threads. A single session must only be used by one thread at a time.
+// Frames are rendered as BeginFrame, RecordFrame, submit of the returned command buffer with GetFrameFence, EndFrame.
+class RenderSession
+{
+	RenderDevice& renderDevice;
+	vk::Device device;
+	uint32_t queue;
+	vk::Format format;
+	RenderSessionSettings settings;
+	vk::Extent2D extent;        // size of the render targets
+	vk::Extent2D renderExtent;  // area that is rendered to, smaller than extent under dynamic resolution
+	ScenePipelines scenePipelines;
+
+	std::unique_ptr<MemoryAllocator> allocator;
+	GpuMesh mesh = {};
+	std::unique_ptr<TexturePool> texturePool;
+	TextureHandle sceneTexture = 0;
+	std::unique_ptr<DescriptorAllocator> descriptorAllocator;
+	RenderQueue renderQueue;
+	RenderQueueStats prepassQueueStats = {};
+	std::unique_ptr<LightClusters> lightClusters;
+
+	std::vector<RenderTarget> renderTargets;
+	vk::CommandPool commandPool;
+	std::vector<vk::CommandBuffer> commandBuffers;
+	std::vector<vk::Fence> inFlightFences;
+	vk::QueryPool timestampQueryPool;
+	vk::QueryPool statisticsQueryPool;
+	std::vector<bool> statisticsPending;   // frame slots whose statistics query was recorded
+	SessionStatistics statistics = {};
+	std::unique_ptr<DynamicResolution> dynamicResolution;
+	std::vector<float> frameRenderScale;  // scale each frame slot was last rendered at, 0 if it has no timestamps yet
+	float timestampPeriod = 0.f;
+	uint64_t timestampMask = 0;
+	uint32_t currentFrame = 0;
+	uint64_t frameNumber = 0;
+
+	void CreateRenderTargets();
+	vk::ImageView CreateTransientAttachment(vk::Format format, vk::ImageUsageFlags usage, vk::ImageAspectFlags aspect, vk::Image& image, AllocationHandle& allocation);
+	void DestroyRenderTargets();
+	void CreateTimestampQueries();
+	void CreateStatisticsQueries();
+	void ReadFrameTimings();
+	void ReadFrameStatistics();
+	void RequestTextureMips(const FrameSnapshot& snapshot);
+	void RecordPostProcess(vk::CommandBuffer commandBuffer);
+	GpuMesh LoadMesh(const std::string& name);
+	void DestroyMesh(GpuMesh& mesh);
+
+public:
+	RenderSession(RenderDevice& renderDevice, vk::Format format, vk::Extent2D extent, const RenderSessionSettings& settings);
+	~RenderSession();
+
+	RenderSession(const RenderSession&) = delete;
+	RenderSession& operator=(const RenderSession&) = delete;
+
+	// waits for the frames of this session only, other sessions on the device keep running
+	void WaitIdle();
+	void Resize(vk::Extent2D extent);
+
+	// waits until the GPU is done with the next frame slot and recycles its resources, returns the slot index
+	uint32_t BeginFrame();
+
+	// returns the frame's command buffer with the scene recorded and still open: the caller may append commands
+	// (the render target is in eTransferSrcOptimal), ends it and submits it with GetFrameFence
+	vk::CommandBuffer RecordFrame(const FrameSnapshot& snapshot);
+	void EndFrame();
+
+	// renders the next RecordFrame at the given scale instead of the one dynamic resolution picked, replays use it to match
+	// the resolution of the captured frames
+	void SetRenderScale(float scale) { this->dynamicResolution->SetScale(scale); }
+
+	uint32_t GetFramesInFlight() const { return static_cast<uint32_t>(this->inFlightFences.size()); }
+	uint32_t GetQueue() const { return this->queue; }
+	vk::Fence GetFrameFence() const { return this->inFlightFences[this->currentFrame]; }
+	vk::Image GetRenderTarget() const { return this->renderTargets[this->currentFrame].image; }
+	vk::Extent2D GetExtent() const { return this->extent; }
+	vk::Extent2D GetRenderExtent() const { return this->renderExtent; }
+	float GetRenderScale() const { return this->dynamicResolution->GetScale(); }
+	uint64_t GetFrameNumber() const { return this->frameNumber; }
+	MemoryAllocator& GetAllocator() { return *this->allocator; }
+	const MemoryAllocator& GetAllocator() const { return *this->allocator; }
+	const RenderSessionSettings& GetSettings() const { return this->settings; }
+	const SessionStatistics& GetStatistics() const { return this->statistics; }
+	// color pass of the last recorded frame
+	const RenderQueueStats& GetRenderQueueStats() const { return this->renderQueue.GetStats(); }
+	// depth pre-pass of the last recorded frame, all zero without it
+	const RenderQueueStats& GetPrepassQueueStats() const { return this->prepassQueueStats; }
+	// both passes of the last recorded frame, everything the frame recorded
+	RenderQueueStats GetFrameQueueStats() const;
+	const TexturePoolStats& GetTextureStats() const { return this->texturePool->GetStats(); }
+
+	void LogStats() const;
+};
@@ -0,0 +1,316 @@
+#include "TexturePool.hpp"
+#include <algorithm>
+#include <cstring>
+#include <spdlog/spdlog.h>
+
+namespace
+{
+	// levels up to this size are uploaded together when a texture is first used and never evicted
+	const uint32_t MIP_TAIL_SIZE = 64;
+	const vk::DeviceSize STAGING_CHUNK_SIZE = 4 * 1024 * 1024;
+	const vk::DeviceSize STAGING_ALIGNMENT = 16;
+
+	vk::ImageSubresourceRange colorRange(uint32_t baseMip, uint32_t mipCount)
+	{
+		return vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, baseMip, mipCount, 0, 1);
+	}
+}
+
+TexturePool::TexturePool(vk::PhysicalDevice physicalDevice, vk::Device device, MemoryAllocator& allocator, const vkp::assets::AssetArchive& assets, uint32_t framesInFlight, vk::DeviceSize uploadBudget)
+	: physicalDevice(physicalDevice), device(device), allocator(allocator), assets(assets), framesInFlight(framesInFlight), uploadBudget(uploadBudget)
+{
+	this->staging.resize(framesInFlight);
+
+	// without VK_EXT_memory_budget textures may use up to a quarter of the largest device local heap
+	const auto memoryProperties = this->physicalDevice.getMemoryProperties();
+	vk::DeviceSize largestHeap = 0;
+	for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++)
+	{
+		const auto& heap = memoryProperties.memoryHeaps[i];
+		if ((heap.flags & vk::MemoryHeapFlagBits::eDeviceLocal) && heap.size > largestHeap)
+		{
+			largestHeap = heap.size;
+			this->deviceLocalHeap = i;
+		}
+	}
+	this->fallbackBudget = largestHeap / 4;
+
+	const vk::SamplerCreateInfo samplerCreateInfo({},
+		vk::Filter::eLinear, vk::Filter::eLinear, vk::SamplerMipmapMode::eLinear,
+		vk::SamplerAddressMode::eRepeat, vk::SamplerAddressMode::eRepeat, vk::SamplerAddressMode::eRepeat,
+		0.f, VK_FALSE, 1.f, VK_FALSE, vk::CompareOp::eAlways, 0.f, VK_LOD_CLAMP_NONE, vk::BorderColor::eFloatOpaqueBlack, VK_FALSE);
+	this->sampler = this->device.createSampler(samplerCreateInfo);
+}
+
+TexturePool::~TexturePool()
+{
+	for (auto& texture : this->textures)
+	{
+		if (texture.image)
+			this->Retire(true, texture.allocation, texture.view);
+	}
+
+	for (auto& image : this->retired)
+	{
+		this->device.destroyImageView(image.view);
+		if (image.ownsAllocation)
+			this->allocator.Destroy(image.allocation);
+	}
+	this->retired.clear();
+
+	for (auto& chunks : this->staging)
+	{
+		for (auto& chunk : chunks)
+			this->allocator.Destroy(chunk.allocation);
+	}
+	this->staging.clear();
+
+	if (this->sampler)
+		this->device.destroySampler(this->sampler);
+}
+
+TextureHandle TexturePool::Load(const std::string& name)
+{
+	Texture texture = {};
+	texture.name = name;
+	texture.source = vkp::assets::ParseKtx2(this->assets.Get(name), name);
+	texture.format = static_cast<vk::Format>(texture.source.vkFormat);
+
+	const auto features = this->physicalDevice.getFormatProperties(texture.format).optimalTilingFeatures;
+	if (!(features & vk::FormatFeatureFlagBits::eSampledImage) || !(features & vk::FormatFeatureFlagBits::eTransferDst))
+		throw std::exception(std::string("texture format not supported by device: " + name).c_str());
+
+	const auto levelCount = static_cast<uint32_t>(texture.source.levels.size());
+	texture.tailMip = levelCount - 1;
+	for (uint32_t i = 0; i < levelCount; i++)
+	{
+		const auto& level = texture.source.levels[i];
+		if (std::max(level.width, level.height) <= MIP_TAIL_SIZE)
+		{
+			texture.tailMip = i;
+			break;
+		}
+	}
+
+	texture.requestedMip = texture.tailMip;
+	texture.residentMip = levelCount;
+
+	this->textures.push_back(std::move(texture));
+	this->stats.textureCount = static_cast<uint32_t>(this->textures.size());
+	return static_cast<TextureHandle>(this->textures.size() - 1);
+}
+
+void TexturePool::RequestMip(TextureHandle handle, uint32_t mip, uint64_t frame)
+{
+	auto& texture = this->textures[handle];
+	texture.requestedMip = std::min(mip, texture.tailMip);
+	texture.lastUsedFrame = frame;
+}
+
+void TexturePool::QueryHeapBudget(vk::DeviceSize& budget, vk::DeviceSize& usage) const
+{
+	// the budget also accounts for allocations of other processes and the rest of the renderer
+	const auto heapStats = this->allocator.GetHeapStats(this->deviceLocalHeap);
+	budget = this->allocator.HasMemoryBudget() ? heapStats.budget : this->fallbackBudget;
+	usage = heapStats.usage;
+}
+
+TexturePool::StagingChunk& TexturePool::AllocateStaging(uint32_t frameIndex, vk::DeviceSize size, vk::DeviceSize& offset)
+{
+	auto& chunks = this->staging[frameIndex];
+	for (auto& chunk : chunks)
+	{
+		const auto alignedOffset = (chunk.used + STAGING_ALIGNMENT - 1) & ~(STAGING_ALIGNMENT - 1);
+		if (alignedOffset + size <= chunk.size)
+		{
+			offset = alignedOffset;
+			chunk.used = alignedOffset + size;
+			return chunk;
+		}
+	}
+
+	StagingChunk chunk = {};
+	chunk.size = std::max(size, STAGING_CHUNK_SIZE);
+	chunk.buffer = this->allocator.CreateBuffer(vk::BufferCreateInfo({}, chunk.size, vk::BufferUsageFlagBits::eTransferSrc, vk::SharingMode::eExclusive),
+		vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, chunk.allocation);
+	chunk.mapped = static_cast<uint8_t*>(this->allocator.GetMappedData(chunk.allocation));
+	chunk.used = size;
+	offset = 0;
+
+	chunks.push_back(chunk);
+	return chunks.back();
+}
+
+void TexturePool::Retire(bool ownsAllocation, AllocationHandle allocation, vk::ImageView view)
+{
+	// a replaced image is left in transfer source layout and is never sampled again, moving it would only waste defrag budget
+	if (ownsAllocation)
+		this->allocator.ClearMovable(allocation);
+	this->retired.push_back({ ownsAllocation, allocation, view, this->currentFrame });
+}
+
+void TexturePool::OnImageMoved(TextureHandle handle, AllocationHandle allocation)
+{
+	auto& texture = this->textures[handle];
+	if (texture.allocation != allocation)
+		return;
+
+	// frames in flight still sample through the old view, the old image itself is kept alive by the allocator
+	this->Retire(false, texture.allocation, texture.view);
+
+	const auto mipCount = static_cast<uint32_t>(texture.source.levels.size()) - texture.residentMip;
+	texture.image = this->allocator.GetImage(texture.allocation);
+	texture.view = this->device.createImageView(vk::ImageViewCreateInfo({}, texture.image, vk::ImageViewType::e2D, texture.format, {}, colorRange(0, mipCount)));
+}
+
+void TexturePool::SetResidency(Texture& texture, uint32_t residentMip, vk::CommandBuffer commandBuffer, uint32_t frameIndex)
+{
+	const auto levelCount = static_cast<uint32_t>(texture.source.levels.size());
+	const auto mipCount = levelCount - residentMip;
+	const auto& baseLevel = texture.source.levels[residentMip];
+
+	const vk::ImageCreateInfo imageCreateInfo({}, vk::ImageType::e2D, texture.format, vk::Extent3D(baseLevel.width, baseLevel.height, 1),
+		mipCount, 1, vk::SampleCountFlagBits::e1, vk::ImageTiling::eOptimal,
+		vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eTransferSrc,
+		vk::SharingMode::eExclusive, 0, nullptr, vk::ImageLayout::eUndefined);
+	AllocationHandle allocation;
+	const auto image = this->allocator.CreateImage(imageCreateInfo, vk::MemoryPropertyFlagBits::eDeviceLocal, allocation);
+	const auto handle = static_cast<TextureHandle>(&texture - this->textures.data());
+	this->allocator.SetMovable(allocation, vk::ImageLayout::eShaderReadOnlyOptimal, [this, handle](AllocationHandle moved) { this->OnImageMoved(handle, moved); });
+
+	const vk::ImageMemoryBarrier toTransferDst({}, vk::AccessFlagBits::eTransferWrite,
+		vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal,
+		VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, image, colorRange(0, mipCount));
+	commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer, {}, nullptr, nullptr, toTransferDst);
+
+	// levels that are resident in both images are copied on the GPU
+	const auto oldMipCount = levelCount - texture.residentMip;
+	if (texture.image)
+	{
+		const vk::ImageMemoryBarrier toTransferSrc(vk::AccessFlagBits::eShaderRead, vk::AccessFlagBits::eTransferRead,
+			vk::ImageLayout::eShaderReadOnlyOptimal, vk::ImageLayout::eTransferSrcOptimal,
+			VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, texture.image, colorRange(0, oldMipCount));
+		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eFragmentShader, vk::PipelineStageFlagBits::eTransfer, {}, nullptr, nullptr, toTransferSrc);
+
+		std::vector<vk::ImageCopy> regions;
+		for (auto level = std::max(residentMip, texture.residentMip); level < levelCount; level++)
+		{
+			const auto& source = texture.source.levels[level];
+			regions.emplace_back(
+				vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, level - texture.residentMip, 0, 1), vk::Offset3D(0, 0, 0),
+				vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, level - residentMip, 0, 1), vk::Offset3D(0, 0, 0),
+				vk::Extent3D(source.width, source.height, 1));
+		}
+		commandBuffer.copyImage(texture.image, vk::ImageLayout::eTransferSrcOptimal, image, vk::ImageLayout::eTransferDstOptimal, regions);
+	}
+
+	// levels that are new to the image are uploaded from the archive
+	for (auto level = residentMip; level < std::min(texture.residentMip, levelCount); level++)
+	{
+		const auto& source = texture.source.levels[level];
+		vk::DeviceSize offset;
+		auto& chunk = this->AllocateStaging(frameIndex, source.data.size, offset);
+		std::memcpy(chunk.mapped + offset, source.data.data, source.data.size);
+
+		const vk::BufferImageCopy region(offset, 0, 0,
+			vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, level - residentMip, 0, 1),
+			vk::Offset3D(0, 0, 0), vk::Extent3D(source.width, source.height, 1));
+		commandBuffer.copyBufferToImage(chunk.buffer, image, vk::ImageLayout::eTransferDstOptimal, region);
+
+		this->stats.uploadedBytes += source.data.size;
+		this->stats.uploadedLevels++;
+	}
+
+	const vk::ImageMemoryBarrier toShaderRead(vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eShaderRead,
+		vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal,
+		VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, image, colorRange(0, mipCount));
+	commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eFragmentShader, {}, nullptr, nullptr, toShaderRead);
+
+	if (texture.image)
+		this->Retire(true, texture.allocation, texture.view);
+	this->stats.residentBytes -= texture.residentBytes;
+
+	const vk::ImageViewCreateInfo viewCreateInfo({}, image, vk::ImageViewType::e2D, texture.format, {}, colorRange(0, mipCount));
+	texture.image = image;
+	texture.allocation = allocation;
+	texture.view = this->device.createImageView(viewCreateInfo);
+	texture.residentMip = residentMip;
+	texture.residentBytes = this->allocator.GetSize(allocation);
+	this->stats.residentBytes += texture.residentBytes;
+}
+
+void TexturePool::Update(vk::CommandBuffer commandBuffer, uint32_t frameIndex, uint64_t frame)
+{
+	this->currentFrame = frame;
+	this->stats.uploadedBytes = 0;
+
+	// resources of this frame slot are no longer in use once its fence has signaled
+	for (auto& chunk : this->staging[frameIndex])
+		chunk.used = 0;
+
+	const auto framesInFlight = this->framesInFlight;
+	const auto expired = std::partition(this->retired.begin(), this->retired.end(), [frame, framesInFlight](const RetiredImage& r) { return r.frame + framesInFlight > frame; });
+	for (auto it = expired; it != this->retired.end(); ++it)
+	{
+		this->device.destroyImageView(it->view);
+		if (it->ownsAllocation)
+			this->allocator.Destroy(it->allocation);
+	}
+	this->retired.erase(expired, this->retired.end());
+
+	// textures that are used for the first time get their mip tail regardless of the upload budget
+	for (auto& texture : this->textures)
+	{
+		if (texture.residentMip == texture.source.levels.size())
+			this->SetResidency(texture, texture.tailMip, commandBuffer, frameIndex);
+	}
+
+	// evict above 90% of the budget but only stream in below 80%, so residency does not flip every frame
+	vk::DeviceSize budget, usage;
+	this->QueryHeapBudget(budget, usage);
+	this->stats.underPressure = usage > budget / 10 * 9;
+	if (this->stats.underPressure)
+	{
+		// drop one fine level per frame, least recently used textures first
+		Texture* victim = nullptr;
+		for (auto& texture : this->textures)
+		{
+			if (texture.residentMip >= texture.tailMip)
+				continue;
+			if (victim == nullptr || texture.lastUsedFrame < victim->lastUsedFrame)
+				victim = &texture;
+		}
+
+		if (victim)
+		{
+			spdlog::get("vk-perf")->debug("Evicting mip {0} of {1}", victim->residentMip, victim->name);
+			this->SetResidency(*victim, victim->residentMip + 1, commandBuffer, frameIndex);
+			this->stats.evictedLevels++;
+		}
+		return;
+	}
+
+	// stream in one level per texture per frame, textures furthest away from their request first
+	std::vector<Texture*> pending;
+	for (auto& texture : this->textures)
+	{
+		if (texture.requestedMip < texture.residentMip)
+			pending.push_back(&texture);
+	}
+	std::sort(pending.begin(), pending.end(), [](const Texture* a, const Texture* b)
+	{
+		if (a->residentMip != b->residentMip)
+			return a->residentMip > b->residentMip;
+		return a->lastUsedFrame > b->lastUsedFrame;
+	});
+
+	for (auto texture : pending)
+	{
+		const auto levelSize = texture->source.levels[texture->residentMip - 1].data.size;
+		if (this->stats.uploadedBytes > 0 && this->stats.uploadedBytes + levelSize > this->uploadBudget)
+			break;
+		if (usage + this->stats.uploadedBytes + levelSize > budget / 10 * 8)
+			break;
+		this->SetResidency(*texture, texture->residentMip - 1, commandBuffer, frameIndex);
+	}
+}
@@ -0,0 +1,103 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+#include "../assets/AssetArchive.hpp"
+#include "../assets/Ktx2.hpp"
+#include "MemoryAllocator.hpp"
+
+using TextureHandle = uint32_t;
+
+struct TexturePoolStats
+{
+	uint32_t textureCount;
+	vk::DeviceSize residentBytes;
+	vk::DeviceSize uploadedBytes; // during the last Update
+	uint64_t uploadedLevels;
+	uint64_t evictedLevels;
+	bool underPressure;
+};
+
+// Streams mip levels of KTX2 textures from the asset archive.
+// Every texture always keeps its mip tail resident, finer levels are uploaded one per frame from coarsest to finest
+// until the requested level is reached. When the device local heap runs short (VK_EXT_memory_budget) the finest level
+// of the least recently used texture is dropped again.
+// Images only contain their resident levels, so changing residency recreates the image and copies the shared levels on the GPU.
+// Images are movable by the defragmenter, views are recreated when that happens.
+class TexturePool
+{
+	struct Texture
+	{
+		std::string name;
+		vkp::assets::Ktx2Texture source;
+		vk::Format format;
+		uint32_t tailMip;       // first level of the always resident mip tail
+		uint32_t requestedMip;  // finest level wanted by the last usage feedback
+		uint32_t residentMip;   // finest level currently resident, levelCount if nothing is resident yet
+		uint64_t lastUsedFrame;
+		vk::Image image;
+		AllocationHandle allocation;
+		vk::ImageView view;
+		vk::DeviceSize residentBytes;
+	};
+
+	struct RetiredImage
+	{
+		bool ownsAllocation;  // false for views retired after the image was moved
+		AllocationHandle allocation;
+		vk::ImageView view;
+		uint64_t frame;
+	};
+
+	struct StagingChunk
+	{
+		vk::Buffer buffer;
+		AllocationHandle allocation;
+		uint8_t* mapped;
+		vk::DeviceSize size;
+		vk::DeviceSize used;
+	};
+
+	vk::PhysicalDevice physicalDevice;
+	vk::Device device;
+	MemoryAllocator& allocator;
+	const vkp::assets::AssetArchive& assets;
+	uint32_t framesInFlight;
+	vk::DeviceSize uploadBudget;
+	vk::DeviceSize fallbackBudget;
+	uint32_t deviceLocalHeap = 0;
+	vk::Sampler sampler;
+
+	std::vector<Texture> textures;
+	std::vector<RetiredImage> retired;
+	std::vector<std::vector<StagingChunk>> staging;
+	TexturePoolStats stats = {};
+	uint64_t currentFrame = 0;
+
+	void QueryHeapBudget(vk::DeviceSize& budget, vk::DeviceSize& usage) const;
+	StagingChunk& AllocateStaging(uint32_t frameIndex, vk::DeviceSize size, vk::DeviceSize& offset);
+	void SetResidency(Texture& texture, uint32_t residentMip, vk::CommandBuffer commandBuffer, uint32_t frameIndex);
+	void Retire(bool ownsAllocation, AllocationHandle allocation, vk::ImageView view);
+	void OnImageMoved(TextureHandle handle, AllocationHandle allocation);
+
+public:
+	TexturePool(vk::PhysicalDevice physicalDevice, vk::Device device, MemoryAllocator& allocator, const vkp::assets::AssetArchive& assets, uint32_t framesInFlight, vk::DeviceSize uploadBudget);
+	~TexturePool();
+
+	TexturePool(const TexturePool&) = delete;
+	TexturePool& operator=(const TexturePool&) = delete;
+
+	TextureHandle Load(const std::string& name);
+
+	// usage feedback, mip is the finest level the texture is sampled at
+	void RequestMip(TextureHandle handle, uint32_t mip, uint64_t frame);
+
+	// records uploads and residency changes, has to be called before the texture views are used in the frame
+	void Update(vk::CommandBuffer commandBuffer, uint32_t frameIndex, uint64_t frame);
+
+	vk::ImageView GetView(TextureHandle handle) const { return this->textures[handle].view; }
+	vk::Sampler GetSampler() const { return this->sampler; }
+	uint32_t GetWidth(TextureHandle handle) const { return this->textures[handle].source.width; }
+	uint32_t GetResidentMip(TextureHandle handle) const { return this->textures[handle].residentMip; }
+	const TexturePoolStats& GetStats() const { return this->stats; }
+};
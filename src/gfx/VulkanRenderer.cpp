@@ -1,315 +1,98 @@
 #include "VulkanRenderer.h"
-#include <cassert>
-#include <set>
+#include <algorithm>
+#include <chrono>
+#include <limits>
 #include <vulkan/vulkan.hpp>
 #include <SDL_vulkan.h>
 #include <spdlog/spdlog.h>
 #include "../utils/Rating.hpp"
-#include <fstream>
 
-const int MAX_FRAMES_IN_FLIGHT = 2;
+const char* ASSET_ARCHIVE = "assets.vkpa";
+const uint64_t STATS_INTERVAL = 1000;
 
-std::vector<const char*> getExtensions(SDL_Window* window)
+VulkanRenderer::VulkanRenderer(const RenderSessionSettings& sessionSettings, ReadbackCallback readbackCallback, const FrameCaptureSettings& captureSettings)
+	: sessionSettings(sessionSettings), readbackCallback(std::move(readbackCallback)), captureSettings(captureSettings)
 {
-	uint32_t extCount = 0;
-	if (!SDL_Vulkan_GetInstanceExtensions(window, &extCount, nullptr))
-		throw std::exception(SDL_GetError());
-
-	std::vector<const char*> extensions;
-	extensions.resize(extCount);
-
-	if (!SDL_Vulkan_GetInstanceExtensions(window, &extCount, extensions.data()))
-		throw std::exception(SDL_GetError());
-
-#if _DEBUG
-	extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
-#endif
-
-	return extensions;
-}
-
-std::vector<const char*> getLayers()
-{
-	std::vector<const char*> layers =
-	{
-#if _DEBUG
-		"VK_LAYER_LUNARG_standard_validation"
-#endif
-	};
-	return layers;
-}
-
-static VKAPI_ATTR vk::Bool32 VKAPI_CALL debugCallback(
-	VkDebugUtilsMessageSeverityFlagBitsEXT severity,
-	VkDebugUtilsMessageTypeFlagsEXT type,
-	const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData,
-	void* pUserData)
-{
-	if (type == VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT && severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT)
-		return VK_FALSE;
-
-	const char* loggerName;
-	if (type == VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT)
-		loggerName = "vk-perf";
-	else if (type == VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT)
-		loggerName = "vk-val";
-	else
-		loggerName = "vk-general";
-
-	if (severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT)
-		spdlog::get(loggerName)->error(pCallbackData->pMessage);
-	else if (severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT)
-		spdlog::get(loggerName)->warn(pCallbackData->pMessage);
-	else if (severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT)
-		spdlog::get(loggerName)->info(pCallbackData->pMessage);
-	else if (severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT)
-		spdlog::get(loggerName)->trace(pCallbackData->pMessage);
-
-	return VK_FALSE;
 }
 
-VulkanRenderer::VulkanRenderer() = default;
-
 VulkanRenderer::~VulkanRenderer()
 {
+	if (!this->renderDevice)
+		return;
+
 	this->device.waitIdle();
 
-	if(!this->frameBuffers.empty())
+	// a capture that did not reach its frame count is finished with the frames it has
+	if (this->capture)
 	{
-		for (auto& frameBuffer : this->frameBuffers)
+		try
 		{
-			this->device.destroyFramebuffer(frameBuffer);
+			this->FinishCapture();
 		}
-		this->frameBuffers.clear();
-	}
-
-	if(this->pipeline)
-	{
-		this->device.destroyPipeline(this->pipeline);
-		this->pipeline = nullptr;
-	}
-
-	if(this->pipelineLayout)
-	{
-		this->device.destroyPipelineLayout(this->pipelineLayout);
-		this->pipelineLayout = nullptr;
-	}
-
-	if(this->renderPass)
-	{
-		this->device.destroyRenderPass(this->renderPass);
-		this->renderPass = nullptr;
-	}
-
-	if (!this->swapChainImageViews.empty())
-	{
-		for (auto& imageView : this->swapChainImageViews)
+		catch (const std::exception& e)
 		{
-			this->device.destroyImageView(imageView);
+			spdlog::get("logger")->error("Frame capture failed: {0}", e.what());
 		}
-		this->swapChainImageViews.clear();
 	}
 
-	if(this->swapChain)
+	// readback memory comes from the session allocator of the first window, the sessions from the device
+	if (this->readback)
 	{
-		this->device.destroySwapchainKHR(this->swapChain);
-		this->swapChain = nullptr;
-		this->swapChainImages.clear();
+		this->readback->DeliverAll();
+		this->readback.reset();
 	}
 
-	if (this->surface)
-	{
-		this->instance.destroySurfaceKHR(this->surface);
-		this->surface = nullptr;
-	}
+	for (auto& output : this->outputs)
+		this->DestroyOutput(output);
+	this->outputs.clear();
 
-	if(!this->inFlightFences.empty())
-	{
-		for (auto& fence : this->inFlightFences)
-			this->device.destroyFence(fence);
-		this->inFlightFences.clear();
-	}
-
-	if(!this->imageAvailableSemaphores.empty())
-	{
-		for (auto& semaphore : this->imageAvailableSemaphores) 
-			this->device.destroySemaphore(semaphore);
-		this->imageAvailableSemaphores.clear();
-	}
+	this->renderDevice.reset();
+}
 
-	if(!this->renderFinishedSemaphores.empty())
-	{
-		for (auto& semaphore : this->renderFinishedSemaphores)
-			this->device.destroySemaphore(semaphore);
-		this->renderFinishedSemaphores.clear();
-	}
+void VulkanRenderer::DestroyOutput(WindowOutput& output)
+{
+	output.session.reset();
+	this->DestroyRetiredSwapChains(output, true);
 
-	if(this->commandPool)
+	if(output.swapChain)
 	{
-		this->device.destroyCommandPool(this->commandPool);
-		this->commandPool = nullptr;
+		this->device.destroySwapchainKHR(output.swapChain);
+		output.swapChain = nullptr;
+		output.swapChainImages.clear();
 	}
 
-	if (this->device)
+	if (output.surface)
 	{
-		this->device.destroy();
-		this->device = nullptr;
+		this->renderDevice->GetInstance().destroySurfaceKHR(output.surface);
+		output.surface = nullptr;
 	}
 
-	this->DestroyDebugCallback();
-
-	if (this->instance)
+	if(!output.imageAvailableSemaphores.empty())
 	{
-		this->instance.destroy();
-		this->instance = nullptr;
+		for (auto& semaphore : output.imageAvailableSemaphores) 
+			this->device.destroySemaphore(semaphore);
+		output.imageAvailableSemaphores.clear();
 	}
-}
-
-void VulkanRenderer::RegisterDebugCallback()
-{
-	vk::DebugUtilsMessengerCreateInfoEXT createInfo(
-		vk::DebugUtilsMessengerCreateFlagsEXT(),
-		vk::DebugUtilsMessageSeverityFlagBitsEXT::eVerbose | vk::DebugUtilsMessageSeverityFlagBitsEXT::eInfo | vk::DebugUtilsMessageSeverityFlagBitsEXT::eWarning | vk::DebugUtilsMessageSeverityFlagBitsEXT::eError,
-		vk::DebugUtilsMessageTypeFlagBitsEXT::eGeneral | vk::DebugUtilsMessageTypeFlagBitsEXT::ePerformance | vk::DebugUtilsMessageTypeFlagBitsEXT::eValidation,
-		debugCallback,
-		nullptr);
-
-	const auto func = reinterpret_cast<PFN_vkCreateDebugUtilsMessengerEXT>(vkGetInstanceProcAddr(static_cast<VkInstance>(this->instance), "vkCreateDebugUtilsMessengerEXT"));
-	func(static_cast<VkInstance>(this->instance), reinterpret_cast<const struct VkDebugUtilsMessengerCreateInfoEXT*>(&createInfo), nullptr, &this->callback);
-}
 
-void VulkanRenderer::DestroyDebugCallback()
-{
-	if (this->callback)
+	if(!output.renderFinishedSemaphores.empty())
 	{
-		const auto func = reinterpret_cast<PFN_vkDestroyDebugUtilsMessengerEXT>(vkGetInstanceProcAddr(
-			static_cast<VkInstance>(this->instance), "vkDestroyDebugUtilsMessengerEXT"));
-		func(static_cast<VkInstance>(this->instance), this->callback, nullptr);
-		this->callback = VK_NULL_HANDLE;
+		for (auto& semaphore : output.renderFinishedSemaphores)
+			this->device.destroySemaphore(semaphore);
+		output.renderFinishedSemaphores.clear();
 	}
-}
-
-void VulkanRenderer::CreateInstance(SDL_Window* window)
-{
-	auto log = spdlog::get("logger");
-	log->info("Initializing vulkan instance");
-
-	vk::ApplicationInfo appInfo("VkPlayground", VK_MAKE_VERSION(0, 1, 0), "unnamed", VK_MAKE_VERSION(0, 1, 0), VK_API_VERSION_1_1);
-
-	auto extensions = getExtensions(window);
-	auto layers = getLayers();
-
-	for (auto& extension : extensions)
-		log->info("Requesting extension {0}", extension);
-
-	this->instance = vk::createInstance(vk::InstanceCreateInfo({}, &appInfo, static_cast<uint32_t>(layers.size()), layers.data(), static_cast<uint32_t>(extensions.size()), extensions.data()));
-	assert(instance);
-
-	if (std::find(extensions.begin(), extensions.end(), VK_EXT_DEBUG_UTILS_EXTENSION_NAME) != extensions.end())
-		this->RegisterDebugCallback();
-}
-
-void VulkanRenderer::CreateSurface(SDL_Window* window)
-{
-	if (!SDL_Vulkan_CreateSurface(window, static_cast<VkInstance>(this->instance), reinterpret_cast<VkSurfaceKHR*>(&this->surface)))
-		throw std::exception(SDL_GetError());
-}
-
-float ratePhysicalDevice(const vk::PhysicalDevice& physicalDevice)
-{
-	auto extensions = physicalDevice.enumerateDeviceExtensionProperties();
-	if (std::find_if(extensions.begin(), extensions.end(), [](vk::ExtensionProperties& ext) { return strcmp(ext.extensionName, VK_KHR_SWAPCHAIN_EXTENSION_NAME); }) == extensions.end())
-		return -1;
-
-	const auto props = physicalDevice.getProperties();
-	if (props.deviceType == vk::PhysicalDeviceType::eDiscreteGpu)
-		return 100;
-	if (props.deviceType == vk::PhysicalDeviceType::eIntegratedGpu)
-		return 50;
-	if (props.deviceType == vk::PhysicalDeviceType::eCpu)
-		return 10;
-	if (props.deviceType == vk::PhysicalDeviceType::eVirtualGpu)
-		return 1;
-
-	return -1;
-}
 
-void VulkanRenderer::PickPhysicalDevice()
-{
-	auto log = spdlog::get("logger");
-
-	auto i = 0;
-	auto deviceList = this->instance.enumeratePhysicalDevices();
-	for (auto& device : deviceList)
+	if(output.presentCommandPool)
 	{
-		auto props = device.getProperties();
-		log->info("[{0}] Name: {1}, Driver: {2}, Api: {3}", i++, props.deviceName, props.driverVersion, props.apiVersion);
+		this->device.destroyCommandPool(output.presentCommandPool);
+		output.presentCommandPool = nullptr;
 	}
-
-	const auto r = GetBestRatedElement<vk::PhysicalDevice>(deviceList, ratePhysicalDevice);
-	if (r.score <= 0)
-		throw std::exception("No suitable physical device found");
-
-	this->physicalDevice = r.element;
-	auto props = this->physicalDevice.getProperties();
-	log->info("Using GPU {0}", props.deviceName);
 }
 
-void VulkanRenderer::CreateDevice()
+void VulkanRenderer::CreateSwapChain(WindowOutput& output)
 {
-	const auto families = this->physicalDevice.getQueueFamilyProperties();
-	auto graphicsQueue = GetBestRatedElement<vk::QueueFamilyProperties>(families, [](const auto& p)
-	{
-		float score = -100;
-		if (p.queueFlags & vk::QueueFlagBits::eGraphics)
-			score += 200.0f;
-		if (p.queueFlags & vk::QueueFlagBits::eTransfer)
-			score += 10.0f;
-		return score;
-	});
-
-	auto physicalDevice = this->physicalDevice;
-	auto surface = this->surface;
-
-	auto presentQueue = GetBestRatedElement<vk::QueueFamilyProperties>(families, [physicalDevice, surface](const auto& p, int index)
-	{
-		float score = -100;
-		if (physicalDevice.getSurfaceSupportKHR(index, surface))
-			score += 200;
-
-		return score;
-	});
-
-	if (graphicsQueue.score <= 0)
-		throw std::exception("Unable to find device queue with graphics support");
-
-	if (presentQueue.score <= 0)
-		throw std::exception("Unable to find device queue with present support");
-
-	std::set<int> queues;
-	queues.emplace(graphicsQueue.index);
-	queues.emplace(presentQueue.index);
+	const auto physicalDevice = this->renderDevice->GetPhysicalDevice();
+	const auto& queueInfo = this->renderDevice->GetQueueInfo();
 
-	std::vector<vk::DeviceQueueCreateInfo> queueCreateInfos;
-	for (auto& queue : queues)
-	{
-		auto queuePriority = 1.f;
-		queueCreateInfos.emplace_back(vk::DeviceQueueCreateInfo({}, queue, 1, &queuePriority));
-	}
-
-	std::vector<const char*> deviceExtensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
-
-	const vk::DeviceCreateInfo createInfo({}, static_cast<uint32_t>(queueCreateInfos.size()), queueCreateInfos.data(), 0, nullptr, static_cast<uint32_t>(deviceExtensions.size()), deviceExtensions.data());
-	this->device = this->physicalDevice.createDevice(createInfo);
-
-	this->queueInfo.graphicsQueueFamilyIndex = graphicsQueue.index;
-	this->queueInfo.presentQueueFamilyIndex = presentQueue.index;
-	this->queueInfo.graphicsQueue = this->device.getQueue(graphicsQueue.index, 0);
-	this->queueInfo.presentQueue = this->device.getQueue(presentQueue.index, 0);
-}
-
-void VulkanRenderer::CreateSwapChain(SDL_Window* window)
-{
 	struct SwapChainSupportDetails
 	{
 		vk::SurfaceCapabilitiesKHR capabilities;
@@ -318,9 +101,9 @@ void VulkanRenderer::CreateSwapChain(SDL_Window* window)
 	};
 
 	SwapChainSupportDetails details;
-	details.capabilities = this->physicalDevice.getSurfaceCapabilitiesKHR(this->surface);
-	details.formats = this->physicalDevice.getSurfaceFormatsKHR(this->surface);
-	details.presentModes = this->physicalDevice.getSurfacePresentModesKHR(this->surface);
+	details.capabilities = physicalDevice.getSurfaceCapabilitiesKHR(output.surface);
+	details.formats = physicalDevice.getSurfaceFormatsKHR(output.surface);
+	details.presentModes = physicalDevice.getSurfacePresentModesKHR(output.surface);
 
 	if (details.formats.empty())
 		throw std::exception("SwapChain incompatible: no supported surface formats found");
@@ -374,7 +157,7 @@ void VulkanRenderer::CreateSwapChain(SDL_Window* window)
 	else
 	{
 		int width, height;
-		SDL_GetWindowSize(window, &width, &height);
+		SDL_GetWindowSize(output.window, &width, &height);
 		const auto minExtent = details.capabilities.minImageExtent;
 		const auto maxExtent = details.capabilities.maxImageExtent;
 		extent.width = std::clamp(minExtent.width, maxExtent.width, static_cast<uint32_t>(width));
@@ -388,259 +171,378 @@ void VulkanRenderer::CreateSwapChain(SDL_Window* window)
 	if (details.capabilities.maxImageCount > 0 && imageCount > details.capabilities.maxImageCount)
 	    imageCount = details.capabilities.maxImageCount;
 
-	auto oldSwapChain = this->swapChain ? this->swapChain : nullptr;
+	// the scene is rendered offscreen and blitted into the swap chain image
+	if (!(details.capabilities.supportedUsageFlags & vk::ImageUsageFlagBits::eTransferDst))
+		throw std::exception("SwapChain incompatible: images can not be used as transfer destination");
+
+	const auto formatFeatures = physicalDevice.getFormatProperties(surfaceFormat.format).optimalTilingFeatures;
+	if (!(formatFeatures & vk::FormatFeatureFlagBits::eBlitSrc) || !(formatFeatures & vk::FormatFeatureFlagBits::eBlitDst))
+		throw std::exception("SwapChain incompatible: surface format does not support blits");
+	output.blitFilter = (formatFeatures & vk::FormatFeatureFlagBits::eSampledImageFilterLinear) ? vk::Filter::eLinear : vk::Filter::eNearest;
+
+	// frame readback copies out of the swap chain image after the blit
+	auto imageUsage = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferDst;
+	output.swapChainReadable = static_cast<bool>(details.capabilities.supportedUsageFlags & vk::ImageUsageFlagBits::eTransferSrc);
+	if (this->readbackCallback && output.swapChainReadable)
+		imageUsage |= vk::ImageUsageFlagBits::eTransferSrc;
+
+	auto oldSwapChain = output.swapChain ? output.swapChain : nullptr;
 	vk::SwapchainCreateInfoKHR swapchainCreateInfo({},
-		this->surface, imageCount, surfaceFormat.format, surfaceFormat.colorSpace, extent, 1, vk::ImageUsageFlagBits::eColorAttachment,
+		output.surface, imageCount, surfaceFormat.format, surfaceFormat.colorSpace, extent, 1, imageUsage,
 		vk::SharingMode::eExclusive, 
 		0, nullptr, 
 		details.capabilities.currentTransform,
 		vk::CompositeAlphaFlagBitsKHR::eOpaque,
 		bestPresentMode.element, VK_TRUE, oldSwapChain);
 
-	if(this->queueInfo.graphicsQueueFamilyIndex != this->queueInfo.presentQueueFamilyIndex)
+	if(queueInfo.graphicsQueueFamilyIndex != queueInfo.presentQueueFamilyIndex)
 	{
-		uint32_t queues[] = { this->queueInfo.graphicsQueueFamilyIndex, this->queueInfo.presentQueueFamilyIndex };
+		uint32_t queues[] = { queueInfo.graphicsQueueFamilyIndex, queueInfo.presentQueueFamilyIndex };
 		// TODO: [Performance] convert this into Exclusive mode and handle ownership transfer during rendering
 		swapchainCreateInfo.imageSharingMode = vk::SharingMode::eConcurrent;
 		swapchainCreateInfo.queueFamilyIndexCount = 2;
 		swapchainCreateInfo.pQueueFamilyIndices = queues;
 	}
 
-	this->swapChain = this->device.createSwapchainKHR(swapchainCreateInfo);
-	this->swapChainImages = this->device.getSwapchainImagesKHR(this->swapChain);
+	output.swapChain = this->device.createSwapchainKHR(swapchainCreateInfo);
+	output.swapChainImages = this->device.getSwapchainImagesKHR(output.swapChain);
 
-	this->swapChainDetails = { surfaceFormat.format, surfaceFormat.colorSpace, bestPresentMode.element, extent };
-
-	for (auto& image : this->swapChainImages)
-	{
-		vk::ImageViewCreateInfo createInfo({}, image, vk::ImageViewType::e2D, surfaceFormat.format, {}, vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1));
-		this->swapChainImageViews.emplace_back(this->device.createImageView(createInfo));
-	}
+	output.swapChainDetails = { surfaceFormat.format, surfaceFormat.colorSpace, bestPresentMode.element, extent };
 
+	// frames of the session may still present from the old swap chain, it is destroyed once they are done
 	if(oldSwapChain)
-	{
-		this->device.destroySwapchainKHR(oldSwapChain);
-	}
+		output.retiredSwapChains.push_back({ oldSwapChain, output.session ? output.session->GetFrameNumber() : 0 });
 }
-
-void VulkanRenderer::CreateRenderPass()
+void VulkanRenderer::DestroyRetiredSwapChains(WindowOutput& output, bool all)
 {
-	vk::AttachmentDescription colorAttachment({}, this->swapChainDetails.format,
-		vk::SampleCountFlagBits::e1, vk::AttachmentLoadOp::eClear, vk::AttachmentStoreOp::eStore,
-		vk::AttachmentLoadOp::eDontCare, vk::AttachmentStoreOp::eDontCare,
-		vk::ImageLayout::eUndefined, vk::ImageLayout::ePresentSrcKHR);
-
-	vk::AttachmentReference colorAttachmentRef(0, vk::ImageLayout::eColorAttachmentOptimal);
-	vk::SubpassDescription subpass({}, vk::PipelineBindPoint::eGraphics, 0, nullptr, 1, &colorAttachmentRef);
-	vk::SubpassDependency subpassDependency(
-		VK_SUBPASS_EXTERNAL, 0,
-		vk::PipelineStageFlagBits::eColorAttachmentOutput,
-		vk::PipelineStageFlagBits::eColorAttachmentOutput,
-		{}, vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eColorAttachmentWrite);
-
-	const vk::RenderPassCreateInfo createInfo({}, 1, &colorAttachment, 1, &subpass, 1, &subpassDependency);
-	this->renderPass = this->device.createRenderPass(createInfo);
+	// presents are queued behind the submissions of their frame, once the session waited for the fences of every frame
+	// slot after the retirement nothing can still read from the old images
+	const auto frameNumber = output.session ? output.session->GetFrameNumber() : 0;
+	const auto framesInFlight = output.session ? output.session->GetFramesInFlight() : 0;
+	auto& retired = output.retiredSwapChains;
+	retired.erase(std::remove_if(retired.begin(), retired.end(), [this, all, frameNumber, framesInFlight](const RetiredSwapChain& swapChain)
+	{
+		if (!all && frameNumber < swapChain.frameNumber + framesInFlight)
+			return false;
+		this->device.destroySwapchainKHR(swapChain.swapChain);
+		return true;
+	}), retired.end());
 }
 
-static std::vector<char> readFile(const std::string& filename)
+void VulkanRenderer::CreatePresentCommandBuffers(WindowOutput& output)
 {
-	std::ifstream file(filename, std::ios::ate | std::ios::binary);
-	if(file.fail())
-		throw std::exception(std::string("unable to open " + filename).c_str());
-
-	const auto fileSize = file.tellg();
-	std::vector<char> buffer(fileSize);
-	file.seekg(0);
-	file.read(buffer.data(), fileSize);
-	file.close();
-	return buffer;
-}
+	// the blit into the swap chain image is recorded separately from the scene, so only it waits for image acquisition
+	const vk::CommandPoolCreateInfo createInfo(vk::CommandPoolCreateFlagBits::eResetCommandBuffer, this->renderDevice->GetQueueInfo().graphicsQueueFamilyIndex);
+	output.presentCommandPool = this->device.createCommandPool(createInfo);
 
-static vk::ShaderModule createShaderModule(const std::vector<char>& code, const vk::Device& device)
-{
-	const vk::ShaderModuleCreateInfo createInfo({}, code.size(), reinterpret_cast<const uint32_t*>(code.data()));
-	return device.createShaderModule(createInfo);
+	const vk::CommandBufferAllocateInfo allocateInfo(output.presentCommandPool, vk::CommandBufferLevel::ePrimary, output.session->GetFramesInFlight());
+	output.presentCommandBuffers = this->device.allocateCommandBuffers(allocateInfo);
 }
 
-void VulkanRenderer::CreateGraphicsPipeline()
+void VulkanRenderer::RecordPresentCommandBuffer(WindowOutput& output, vk::CommandBuffer commandBuffer, uint32_t frameIndex, uint32_t imageIndex)
 {
-	const auto vertShader = createShaderModule(readFile("shader/triangle.vert.spv"), this->device);
-	const auto fragShader = createShaderModule(readFile("shader/triangle.frag.spv"), this->device);
-
-	const vk::PipelineShaderStageCreateInfo vertShaderStageInfo({}, vk::ShaderStageFlagBits::eVertex, vertShader, "main");
-	const vk::PipelineShaderStageCreateInfo fragShaderStageInfo({}, vk::ShaderStageFlagBits::eFragment, fragShader, "main");
-
-	vk::PipelineShaderStageCreateInfo shaderStages[] = { vertShaderStageInfo, fragShaderStageInfo };
+	vk::CommandBufferBeginInfo beginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit, nullptr);
+	commandBuffer.begin(beginInfo);
+
+	const auto swapChainImage = output.swapChainImages[imageIndex];
+	const vk::ImageSubresourceRange range(vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1);
+
+	const vk::ImageMemoryBarrier toTransferDst({}, vk::AccessFlagBits::eTransferWrite,
+		vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal,
+		VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, swapChainImage, range);
+	commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer, {}, nullptr, nullptr, toTransferDst);
+
+	// upscale the rendered area to the whole swap chain image
+	const auto source = output.session->GetRenderExtent();
+	const auto& destination = output.swapChainDetails.extent;
+	const vk::ImageSubresourceLayers layers(vk::ImageAspectFlagBits::eColor, 0, 0, 1);
+	const vk::ImageBlit region(
+		layers, { vk::Offset3D(0, 0, 0), vk::Offset3D(source.width, source.height, 1) },
+		layers, { vk::Offset3D(0, 0, 0), vk::Offset3D(destination.width, destination.height, 1) });
+	commandBuffer.blitImage(output.session->GetRenderTarget(), vk::ImageLayout::eTransferSrcOptimal, swapChainImage, vk::ImageLayout::eTransferDstOptimal, region, output.blitFilter);
+
+	auto presentSourceLayout = vk::ImageLayout::eTransferDstOptimal;
+	vk::AccessFlags presentSourceAccess = vk::AccessFlagBits::eTransferWrite;
+	if (this->readback && &output == &this->outputs.front())
+	{
+		const vk::ImageMemoryBarrier toTransferSrc(vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eTransferRead,
+			vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eTransferSrcOptimal,
+			VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, swapChainImage, range);
+		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer, {}, nullptr, nullptr, toTransferSrc);
+
+		this->readback->Record(commandBuffer, frameIndex, output.session->GetFrameNumber(), swapChainImage, destination);
+		presentSourceLayout = vk::ImageLayout::eTransferSrcOptimal;
+		presentSourceAccess = {};
+	}
 
-	vk::PipelineVertexInputStateCreateInfo vertexInputInfo({},  0, nullptr, 0, nullptr);
-	vk::PipelineInputAssemblyStateCreateInfo inputAssembly({}, vk::PrimitiveTopology::eTriangleList, VK_FALSE);
+	const vk::ImageMemoryBarrier toPresent(presentSourceAccess, {},
+		presentSourceLayout, vk::ImageLayout::ePresentSrcKHR,
+		VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, swapChainImage, range);
+	commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eBottomOfPipe, {}, nullptr, nullptr, toPresent);
 
+	commandBuffer.end();
+}
 
-	vk::PipelineViewportStateCreateInfo viewportState({}, 1, nullptr, 1, nullptr);
-	std::vector<vk::DynamicState> enabledDynamicStates = 
+void VulkanRenderer::CreateSyncObjects(WindowOutput& output)
+{
+	for(uint32_t i = 0; i < output.session->GetFramesInFlight(); i++)
 	{
-		vk::DynamicState::eViewport,
-		vk::DynamicState::eScissor
-	};
-	vk::PipelineDynamicStateCreateInfo dynamicStateCreateInfo({}, enabledDynamicStates.size(), enabledDynamicStates.data());
-
-	vk::PipelineRasterizationStateCreateInfo rasterizerState({}, VK_FALSE, VK_FALSE, vk::PolygonMode::eFill, vk::CullModeFlagBits::eBack, vk::FrontFace::eClockwise, 0, 0, 0, 0, 1.f);
-	// enabling multisampling requires a GPU logical device feature to be enabled during creation
-	vk::PipelineMultisampleStateCreateInfo multisampleState({}, vk::SampleCountFlagBits::e1, VK_FALSE, 1.f, nullptr, VK_FALSE, VK_FALSE);
-	//vk::PipelineDepthStencilStateCreateInfo depthStencilInfo({});
-	vk::PipelineColorBlendAttachmentState colorBlendAttachment(VK_TRUE, vk::BlendFactor::eSrcAlpha, vk::BlendFactor::eOneMinusSrcAlpha, vk::BlendOp::eAdd, vk::BlendFactor::eOne, vk::BlendFactor::eZero, vk::BlendOp::eAdd, vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA);
-	vk::PipelineColorBlendStateCreateInfo colorBlending({}, VK_FALSE, vk::LogicOp::eCopy, 1, &colorBlendAttachment);
-
-	vk::PipelineLayoutCreateInfo pipelineLayoutCreateInfo({}, 0, nullptr, 0, nullptr);
-	this->pipelineLayout = this->device.createPipelineLayout(pipelineLayoutCreateInfo);
-
-	vk::GraphicsPipelineCreateInfo pipelineCreateInfo({}, 2, shaderStages, &vertexInputInfo, &inputAssembly, nullptr, &viewportState, &rasterizerState, &multisampleState, nullptr, &colorBlending, &dynamicStateCreateInfo, this->pipelineLayout, this->renderPass, 0, nullptr, -1);
-	this->pipeline = this->device.createGraphicsPipelines(nullptr, pipelineCreateInfo)[0];
-
-	this->device.destroyShaderModule(vertShader);
-	this->device.destroyShaderModule(fragShader);
+		output.imageAvailableSemaphores.emplace_back(this->device.createSemaphore({}));
+		output.renderFinishedSemaphores.emplace_back(this->device.createSemaphore({}));
+	}
 }
 
-void VulkanRenderer::CreateFrameBuffers()
+void VulkanRenderer::LogStats() const
 {
-	for (auto& swapChainImageView : this->swapChainImageViews)
+	for (size_t i = 0; i < this->outputs.size(); i++)
 	{
-		const auto extent = this->swapChainDetails.extent;
-		vk::FramebufferCreateInfo framebufferCreateInfo({}, this->renderPass, 1, &swapChainImageView, extent.width, extent.height, 1);
+		const auto& extent = this->outputs[i].swapChainDetails.extent;
+		spdlog::get("vk-perf")->info("Window {0} ({1}x{2}):", i, extent.width, extent.height);
+		this->outputs[i].session->LogStats();
+	}
+
+	const auto registryStats = this->renderDevice->GetPipelineRegistry().GetStats();
+	spdlog::get("vk-perf")->info("Pipelines: {0} states, {1} created, {2}/{3} duplicate registrations, {4:.3f} ms creation",
+		registryStats.states, registryStats.pipelines, registryStats.duplicates, registryStats.registrations, registryStats.createMilliseconds);
 
-		this->frameBuffers.emplace_back(this->device.createFramebuffer(framebufferCreateInfo));
+	if (this->readback)
+	{
+		const auto& readbackStats = this->readback->GetStats();
+		spdlog::get("vk-perf")->info("Readback: {0} frames, {1:.1f} MiB, {2:.3f} ms/frame conversion, {3:.3f} ms/frame consumer", readbackStats.frames,
+			readbackStats.bytes / (1024.0 * 1024.0), readbackStats.convertMilliseconds / std::max<uint64_t>(readbackStats.frames, 1), readbackStats.callbackMilliseconds / std::max<uint64_t>(readbackStats.frames, 1));
 	}
 }
 
-void VulkanRenderer::CreateCommandPool()
+RendererStats VulkanRenderer::GetStats() const
 {
-	const vk::CommandPoolCreateInfo createInfo({}, this->queueInfo.graphicsQueueFamilyIndex);
-	this->commandPool = this->device.createCommandPool(createInfo);
+	RendererStats stats = {};
+	if (this->outputs.empty())
+		return stats;
+
+	const auto& first = *this->outputs.front().session;
+	stats.frames = first.GetFrameNumber();
+	stats.timedFrames = first.GetStatistics().timedFrames;
+	stats.lastGpuMilliseconds = first.GetStatistics().lastGpuMilliseconds;
+
+	// every session allocates from its own allocator
+	for (const auto& output : this->outputs)
+	{
+		const auto& allocatorStats = output.session->GetAllocator().GetAllocatorStats();
+		stats.memoryAllocations += allocatorStats.allocations;
+		stats.deviceMemoryAllocations += allocatorStats.blockAllocations;
+		stats.deviceMemoryBytes += allocatorStats.blockBytes;
+		stats.peakDeviceMemoryBytes += allocatorStats.peakBlockBytes;
+	}
+	return stats;
 }
 
-void VulkanRenderer::CreateCommandBuffers()
+void VulkanRenderer::Initialize(const std::vector<SDL_Window*>& windows)
 {
-	const vk::CommandBufferAllocateInfo allocateInfo(this->commandPool, vk::CommandBufferLevel::ePrimary, this->frameBuffers.size());
-	this->commandBuffers = this->device.allocateCommandBuffers(allocateInfo);
+	if (windows.empty())
+		throw std::exception("No window to render to");
 
-	for(auto i = 0; i < this->commandBuffers.size(); i++)
-	{
-		auto commandBuffer = this->commandBuffers[i];
-		vk::CommandBufferBeginInfo beginInfo(vk::CommandBufferUsageFlagBits::eSimultaneousUse, nullptr);
-		commandBuffer.begin(beginInfo);
+	// the present queue is picked for the first window, every other window has to be presentable from it as well
+	this->renderDevice = std::make_unique<RenderDevice>(windows.front(), ASSET_ARCHIVE);
+	this->device = this->renderDevice->GetDevice();
 
-		vk::ClearValue clearValue[] = 
-		{
-			vk::ClearColorValue(std::array<float, 4> { 0.f, 0.f, 0.f, 1.f })
-		};
-		vk::RenderPassBeginInfo renderPassInfo(this->renderPass, this->frameBuffers[i], vk::Rect2D({0, 0}, this->swapChainDetails.extent), 1, clearValue);
-		commandBuffer.beginRenderPass(&renderPassInfo, vk::SubpassContents::eInline);
-
-		const auto width = static_cast<float>(this->swapChainDetails.extent.width);
-		const auto height = static_cast<float>(this->swapChainDetails.extent.height);
-		vk::Viewport viewport(0, 0, width, height, 0.f, 1.f);
-		vk::Rect2D scissor({0, 0}, this->swapChainDetails.extent);
-		commandBuffer.setViewport(0, viewport);
-		commandBuffer.setScissor(0, scissor);
+	// outputs are never added later, so references to them stay valid
+	this->outputs.resize(windows.size());
+	for (size_t i = 0; i < windows.size(); i++)
+	{
+		auto& output = this->outputs[i];
+		output.window = windows[i];
+		output.surface = this->renderDevice->CreateSurface(output.window);
+		if (!this->renderDevice->GetPhysicalDevice().getSurfaceSupportKHR(this->renderDevice->GetQueueInfo().presentQueueFamilyIndex, output.surface))
+			throw std::exception("Present queue can not present to the window surface");
 
-		commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, this->pipeline);
+		// TODO: handle swapchain format changes (i.e. on window resize)
+		this->CreateSwapChain(output);
+		output.session = std::make_unique<RenderSession>(*this->renderDevice, output.swapChainDetails.format, output.swapChainDetails.extent, this->sessionSettings);
 
-		commandBuffer.draw(3, 1, 0, 0);
+		this->CreatePresentCommandBuffers(output);
+		this->CreateSyncObjects(output);
+	}
 
-		commandBuffer.endRenderPass();
-		commandBuffer.end();
+	if (this->readbackCallback)
+	{
+		auto& output = this->outputs.front();
+		if (output.swapChainReadable)
+			this->readback = std::make_unique<FrameReadback>(output.session->GetAllocator(), output.session->GetFramesInFlight(), output.swapChainDetails.format, this->readbackCallback);
+		else
+			spdlog::get("vk-perf")->warn("Swap chain images can not be copied, frame readback disabled");
 	}
 }
 
-void VulkanRenderer::CreateSyncObjects()
+void VulkanRenderer::Resize(size_t window, uint32_t width, uint32_t height)
 {
-	for(auto i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+	// only the frames of this window are waited for, the other windows keep rendering and presenting
+	auto& output = this->outputs[window];
+	output.session->WaitIdle();
+	if (this->readback && window == 0)
+		this->readback->DeliverAll();
+
+	this->CreateSwapChain(output);
+	output.session->Resize(output.swapChainDetails.extent);
+
+	if (this->capture)
 	{
-		this->imageAvailableSemaphores.emplace_back(this->device.createSemaphore({}));
-		this->renderFinishedSemaphores.emplace_back(this->device.createSemaphore({}));
-		this->inFlightFences.emplace_back(this->device.createFence(vk::FenceCreateInfo(vk::FenceCreateFlagBits::eSignaled)));
+		const auto& extent = output.swapChainDetails.extent;
+		const vkp::trace::TraceResize resize = { this->capture->GetTimestamp(), static_cast<uint32_t>(window), width, height, extent.width, extent.height, 0 };
+		this->capture->WriteResize(resize);
 	}
 }
 
-void VulkanRenderer::Initialize(SDL_Window* window)
+void VulkanRenderer::BeginCapture()
 {
-	this->CreateInstance(window);
-	this->CreateSurface(window);
-	this->PickPhysicalDevice();
-	this->CreateDevice();
-	this->CreateCommandPool();
-
-	this->CreateSwapChain(window);
+	std::vector<vkp::trace::TraceWindow> windows;
+	for (const auto& output : this->outputs)
+	{
+		const auto& details = output.swapChainDetails;
+		windows.push_back({ static_cast<uint32_t>(details.format), static_cast<uint32_t>(details.presentMode), details.extent.width, details.extent.height });
+	}
 
-	// TODO: handle swapchain format changes (i.e. on window resize)
-	this->CreateRenderPass();
-	this->CreateGraphicsPipeline();
+	const auto firstFrame = this->outputs.front().session->GetFrameNumber();
+	this->capture = std::make_unique<FrameCapture>(this->captureSettings.filename, this->sessionSettings, firstFrame, this->captureSettings.frameCount, windows);
+	spdlog::get("logger")->info("Capturing {0} frames from frame {1} to {2}", this->captureSettings.frameCount, firstFrame, this->captureSettings.filename);
+}
 
-	this->CreateFrameBuffers();
+void VulkanRenderer::CaptureFrame(const FrameSnapshot& snapshot, uint64_t timestamp, float drawMilliseconds)
+{
+	this->captureWindows.clear();
+	for (size_t i = 0; i < this->outputs.size(); i++)
+	{
+		const auto& session = *this->outputs[i].session;
+		const auto& extent = this->outputs[i].swapChainDetails.extent;
+
+		vkp::trace::TraceWindowFrame window = {};
+		window.width = i < snapshot.windows.size() ? snapshot.windows[i].width : extent.width;
+		window.height = i < snapshot.windows.size() ? snapshot.windows[i].height : extent.height;
+		window.minimized = i < snapshot.windows.size() && snapshot.windows[i].minimized;
+		window.renderScale = session.GetRenderScale();
+		if (!window.minimized)
+		{
+			const auto queueStats = session.GetFrameQueueStats();
+			window.draws = queueStats.draws;
+			window.pipelineBinds = queueStats.pipelineBinds;
+			window.descriptorBinds = queueStats.descriptorBinds;
+			window.bufferBinds = queueStats.vertexBufferBinds + queueStats.indexBufferBinds;
+			window.uploadedBytes = session.GetTextureStats().uploadedBytes;
+		}
+		this->captureWindows.push_back(window);
+	}
 
-	this->CreateCommandBuffers();
-	this->CreateSyncObjects();
+	const auto gpuMilliseconds = static_cast<float>(this->outputs.front().session->GetStatistics().lastGpuMilliseconds);
+	this->capture->WriteFrame(snapshot, timestamp, drawMilliseconds, gpuMilliseconds, this->captureWindows);
+	if (this->capture->IsComplete())
+		this->FinishCapture();
 }
 
-void VulkanRenderer::Resize(SDL_Window* window, uint32_t width, uint32_t height)
+void VulkanRenderer::FinishCapture()
 {
-	this->device.waitIdle();
-
-	this->device.freeCommandBuffers(this->commandPool, this->commandBuffers);
-	this->commandBuffers.clear();
+	// only one capture per run, the frame count would trigger it again right away
+	auto capture = std::move(this->capture);
+	this->captureSettings.frameCount = 0;
+	capture->Finish(this->renderDevice->GetAssets());
+}
 
-	for (auto& imageView : this->swapChainImageViews)
-		this->device.destroyImageView(imageView);
-	this->swapChainImageViews.clear();
+void VulkanRenderer::Draw(const FrameSnapshot& snapshot)
+{
+	if (!this->capture && this->captureSettings.frameCount > 0 && this->outputs.front().session->GetFrameNumber() >= this->captureSettings.firstFrame)
+		this->BeginCapture();
 
-	for (auto& frameBuffer : this->frameBuffers)
-		this->device.destroyFramebuffer(frameBuffer);
-	this->frameBuffers.clear();
+	if (!this->capture)
+	{
+		this->DrawWindows(snapshot);
+		return;
+	}
 
-	this->CreateSwapChain(window);
-	this->CreateFrameBuffers();
-	this->CreateCommandBuffers();
+	const auto timestamp = this->capture->GetTimestamp();
+	const auto start = std::chrono::high_resolution_clock::now();
+	this->DrawWindows(snapshot);
+	const auto drawMilliseconds = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	this->CaptureFrame(snapshot, timestamp, drawMilliseconds);
 }
 
-void VulkanRenderer::Draw()
+void VulkanRenderer::DrawWindows(const FrameSnapshot& snapshot)
 {
-	this->device.waitForFences(1, &this->inFlightFences[currentFrame], VK_TRUE, std::numeric_limits<uint64_t>::max());
-	this->device.resetFences(1, &this->inFlightFences[currentFrame]);
+	if (this->outputs.front().session->GetFrameNumber() % STATS_INTERVAL == 0)
+		this->LogStats();
+
+	this->presentWaitSemaphores.clear();
+	this->presentSwapChains.clear();
+	this->presentImageIndices.clear();
+	this->presentOutputs.clear();
+
+	// every window records and submits its own frame, only the presentation is batched
+	for (size_t i = 0; i < this->outputs.size(); i++)
+	{
+		if (i < snapshot.windows.size() && snapshot.windows[i].minimized)
+			continue;
+
+		auto& output = this->outputs[i];
+		auto& session = *output.session;
+		const auto frameIndex = session.BeginFrame();
+		this->DestroyRetiredSwapChains(output, false);
+		if (this->readback && i == 0)
+			this->readback->Deliver(frameIndex);
+
+		uint32_t imageIndex;
+		const auto acquireImageResult = this->device.acquireNextImageKHR(output.swapChain, std::numeric_limits<uint64_t>::max(), output.imageAvailableSemaphores[frameIndex], nullptr, &imageIndex);
+		const auto acquired = acquireImageResult == vk::Result::eSuccess || acquireImageResult == vk::Result::eSuboptimalKHR;
+		if (!acquired && acquireImageResult != vk::Result::eErrorOutOfDateKHR)
+			throw std::exception("Unable to retrieve image from swap chain");
 
-	uint32_t imageIndex;
-	const auto acquireImageResult = this->device.acquireNextImageKHR(this->swapChain, std::numeric_limits<uint64_t>::max(), this->imageAvailableSemaphores[currentFrame], nullptr, &imageIndex);
-	if(acquireImageResult != vk::Result::eSuccess)
-	{
-		if(acquireImageResult == vk::Result::eErrorOutOfDateKHR)
+		auto commandBuffer = session.RecordFrame(snapshot);
+		commandBuffer.end();
+
+		if (!acquired)
 		{
-			
+			// the window is being resized: the scene is still submitted so the frame fence signals, nothing is presented
+			const vk::SubmitInfo submitInfo(0, nullptr, nullptr, 1, &commandBuffer, 0, nullptr);
+			if (this->renderDevice->Submit(session.GetQueue(), 1, &submitInfo, session.GetFrameFence()) != vk::Result::eSuccess)
+				throw std::exception("error while submitting command buffer to graphics queue");
+			session.EndFrame();
+			continue;
 		}
-		else
+
+		auto presentCommandBuffer = output.presentCommandBuffers[frameIndex];
+		presentCommandBuffer.reset({});
+		this->RecordPresentCommandBuffer(output, presentCommandBuffer, frameIndex, imageIndex);
+
+		// only the blit waits for the swap chain image, the scene (and its timestamps) never stalls on presentation
+		vk::PipelineStageFlags waitStages[] = { vk::PipelineStageFlagBits::eTransfer };
+		const vk::SubmitInfo submitInfos[] =
 		{
-			throw std::exception("Unable to retrieve image from swap chain");
-		}
+			vk::SubmitInfo(0, nullptr, nullptr, 1, &commandBuffer, 0, nullptr),
+			vk::SubmitInfo(1, &output.imageAvailableSemaphores[frameIndex], waitStages, 1, &presentCommandBuffer, 1, &output.renderFinishedSemaphores[frameIndex])
+		};
+
+		if(this->renderDevice->Submit(session.GetQueue(), 2, submitInfos, session.GetFrameFence()) != vk::Result::eSuccess)
+			throw std::exception("error while submitting command buffer to graphics queue");
+
+		this->presentWaitSemaphores.push_back(output.renderFinishedSemaphores[frameIndex]);
+		this->presentSwapChains.push_back(output.swapChain);
+		this->presentImageIndices.push_back(imageIndex);
+		this->presentOutputs.push_back(i);
+		session.EndFrame();
 	}
 
-	vk::PipelineStageFlags waitStages[] = { vk::PipelineStageFlagBits::eColorAttachmentOutput };
-	vk::SubmitInfo submitInfo(1, &this->imageAvailableSemaphores[currentFrame], waitStages, 1, &this->commandBuffers[imageIndex], 1, &this->renderFinishedSemaphores[currentFrame]);
+	if (this->presentSwapChains.empty())
+		return;
 
-	if(this->queueInfo.graphicsQueue.submit(1, &submitInfo, this->inFlightFences[currentFrame]) != vk::Result::eSuccess)
-		throw std::exception("error while submitting command buffer to graphics queue");
+	// one presentKHR for all windows, per swap chain results tell which windows are out of date
+	const auto count = static_cast<uint32_t>(this->presentSwapChains.size());
+	this->presentResults.assign(count, vk::Result::eSuccess);
+	const vk::PresentInfoKHR presentInfo(count, this->presentWaitSemaphores.data(), count, this->presentSwapChains.data(), this->presentImageIndices.data(), this->presentResults.data());
 
-	const vk::PresentInfoKHR presentInfo(1, &this->renderFinishedSemaphores[currentFrame], 1, &this->swapChain, &imageIndex);
+	const auto presentResult = this->renderDevice->Present(presentInfo);
+	if(presentResult != vk::Result::eSuccess && presentResult != vk::Result::eSuboptimalKHR && presentResult != vk::Result::eErrorOutOfDateKHR)
+		throw std::exception("Error presenting next frame");
 
-	const auto presentResult = this->queueInfo.presentQueue.presentKHR(&presentInfo);
-	if(presentResult != vk::Result::eSuccess)
+	// out of date swap chains are recreated by the resize events of their window
+	for (uint32_t i = 0; i < count; i++)
 	{
-		if(presentResult == vk::Result::eErrorOutOfDateKHR)
-		{
-			
-		}
-		else
-		{
-			throw std::exception("Error presenting next frame");
-		}
+		if (this->presentResults[i] == vk::Result::eErrorOutOfDateKHR)
+			spdlog::get("logger")->debug("Swap chain of window {0} is out of date", this->presentOutputs[i]);
 	}
-
-	currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
 }
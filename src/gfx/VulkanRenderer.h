@@ -1,14 +1,11 @@
 #pragma once
 #include "IRenderer.hpp"
+#include <memory>
 #include <vulkan/vulkan.hpp>
-
-struct QueueInfo
-{
-	uint32_t graphicsQueueFamilyIndex;
-	vk::Queue graphicsQueue;
-	uint32_t presentQueueFamilyIndex;
-	vk::Queue presentQueue;
-};
+#include "FrameCapture.hpp"
+#include "FrameReadback.hpp"
+#include "RenderDevice.hpp"
+#include "RenderSession.hpp"
 
 struct SwapChainDetails
 {
@@ -18,52 +15,73 @@ struct SwapChainDetails
 	vk::Extent2D extent;
 };
 
-class VulkanRenderer :
-	public IRenderer
+// swap chain replaced by a resize, destroyed once the frames that may still present from it are done
+struct RetiredSwapChain
 {
-    vk::Instance instance;
-	VkDebugUtilsMessengerEXT callback;
-	vk::PhysicalDevice physicalDevice;
-	vk::Device device;
+	vk::SwapchainKHR swapChain;
+	uint64_t frameNumber;  // session frame number at retirement
+};
+
+// Everything of one window: its surface and swap chain and the session rendering its scene.
+struct WindowOutput
+{
+	SDL_Window* window;
 	vk::SurfaceKHR surface;
 	vk::SwapchainKHR swapChain;
 	std::vector<vk::Image> swapChainImages;
-	std::vector<vk::ImageView> swapChainImageViews;
-	vk::RenderPass renderPass;
-	vk::PipelineLayout pipelineLayout;
-	vk::Pipeline pipeline;
-	std::vector<vk::Framebuffer> frameBuffers;
-	vk::CommandPool commandPool;
-	std::vector<vk::CommandBuffer> commandBuffers;
+	std::vector<RetiredSwapChain> retiredSwapChains;
+	SwapChainDetails swapChainDetails;
+	vk::Filter blitFilter;
+	bool swapChainReadable;
+	std::unique_ptr<RenderSession> session;
+	vk::CommandPool presentCommandPool;
+	std::vector<vk::CommandBuffer> presentCommandBuffers;
 	std::vector<vk::Semaphore> imageAvailableSemaphores;
 	std::vector<vk::Semaphore> renderFinishedSemaphores;
-	std::vector<vk::Fence> inFlightFences;
-	
-	QueueInfo queueInfo = {};
-	SwapChainDetails swapChainDetails = {};
-	int currentFrame = 0;
-	
-	void RegisterDebugCallback();
-	void DestroyDebugCallback();
-	
-	void CreateInstance(SDL_Window* window);
-	void CreateSurface(SDL_Window* window);
-	void PickPhysicalDevice();
-	void CreateDevice();
-	void CreateSwapChain(SDL_Window* window);
-	void CreateRenderPass();
-	void CreateGraphicsPipeline();
-	void CreateFrameBuffers();
-	void CreateCommandPool();
-	void CreateCommandBuffers();
-	void CreateSyncObjects();
+};
+
+// Windowed renderer: one RenderDevice shared by all windows, each window renders its own RenderSession whose targets are
+// blitted into the window's swap chain. The images of all windows are presented together by a single presentKHR.
+class VulkanRenderer :
+	public IRenderer
+{
+	std::unique_ptr<RenderDevice> renderDevice;
+	vk::Device device;
+	std::vector<WindowOutput> outputs;
+	RenderSessionSettings sessionSettings;
+	ReadbackCallback readbackCallback;
+	std::unique_ptr<FrameReadback> readback;  // frames of the first window
+	FrameCaptureSettings captureSettings;
+	std::unique_ptr<FrameCapture> capture;
+	std::vector<vkp::trace::TraceWindowFrame> captureWindows;
+
+	// per Draw, reused to batch the presentation of all windows
+	std::vector<vk::Semaphore> presentWaitSemaphores;
+	std::vector<vk::SwapchainKHR> presentSwapChains;
+	std::vector<uint32_t> presentImageIndices;
+	std::vector<size_t> presentOutputs;
+	std::vector<vk::Result> presentResults;
+
+	void CreateSwapChain(WindowOutput& output);
+	void DestroyRetiredSwapChains(WindowOutput& output, bool all);
+	void CreatePresentCommandBuffers(WindowOutput& output);
+	void CreateSyncObjects(WindowOutput& output);
+	void DestroyOutput(WindowOutput& output);
+	void RecordPresentCommandBuffer(WindowOutput& output, vk::CommandBuffer commandBuffer, uint32_t frameIndex, uint32_t imageIndex);
+	void DrawWindows(const FrameSnapshot& snapshot);
+	void BeginCapture();
+	void CaptureFrame(const FrameSnapshot& snapshot, uint64_t timestamp, float drawMilliseconds);
+	void FinishCapture();
+	void LogStats() const;
 
-	void CleanupSwapChain();
 public:
-	VulkanRenderer();
+	// sessionSettings apply to the session of every window,
+	// readbackCallback receives every presented frame of the first window as RGBA8 a few frames after it was rendered,
+	// captureSettings writes a trace of the given frames for FrameReplay
+	explicit VulkanRenderer(const RenderSessionSettings& sessionSettings = {}, ReadbackCallback readbackCallback = nullptr, const FrameCaptureSettings& captureSettings = {});
 	virtual ~VulkanRenderer();
-	void Initialize(SDL_Window* window) override;
-	void Resize(SDL_Window* window, uint32_t width, uint32_t height) override;
-	void Draw() override;
+	void Initialize(const std::vector<SDL_Window*>& windows) override;
+	void Resize(size_t window, uint32_t width, uint32_t height) override;
+	void Draw(const FrameSnapshot& snapshot) override;
+	RendererStats GetStats() const override;
 };
-
@@ -3,8 +3,20 @@
 #include <SDL.h>
 #include <spdlog/spdlog.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
 #include "App.hpp"
 #include "gfx/VulkanRenderer.h"
+#include "utils/ThreadPool.hpp"
+
+namespace
+{
+	// captures waiting for the writer, further frames are skipped while the disk falls behind
+	const uint32_t MAX_PENDING_CAPTURES = 8;
+}
 
 void setupLogging()
 {
@@ -14,18 +26,102 @@ void setupLogging()
 	spdlog::stdout_color_mt("vk-val")->set_level(spdlog::level::level_enum::trace);
 }
 
+// binary PPM from tightly packed RGBA8 rows, the alpha channel is dropped
+void writePpm(const std::string& filename, uint32_t width, uint32_t height, const std::vector<uint8_t>& pixels)
+{
+	std::ofstream file(filename, std::ios::binary);
+	file << "P6\n" << width << " " << height << "\n255\n";
+
+	std::vector<char> row(width * 3);
+	for (uint32_t y = 0; y < height; y++)
+	{
+		const auto source = pixels.data() + static_cast<size_t>(y) * width * 4;
+		for (uint32_t x = 0; x < width; x++)
+		{
+			row[x * 3 + 0] = source[x * 4 + 0];
+			row[x * 3 + 1] = source[x * 4 + 1];
+			row[x * 3 + 2] = source[x * 4 + 2];
+		}
+		file.write(row.data(), row.size());
+	}
+}
+
 int main(int argc, const char* argv[])
 {
 	setupLogging();
 	auto log = spdlog::get("logger");
 
+	uint32_t maxFrameLatency = 1;
+	uint64_t frameLimit = 0;
+	uint64_t captureInterval = 0;
+	uint32_t windowCount = 1;
+	RenderSessionSettings sessionSettings;
+	FrameCaptureSettings traceSettings;
+	sessionSettings.dynamicResolution = true;
+	sessionSettings.pipelineStatistics = true;
+	for (auto i = 1; i + 1 < argc; i += 2)
+	{
+		const std::string option = argv[i];
+		if (option == "--latency")
+			maxFrameLatency = static_cast<uint32_t>(std::stoul(argv[i + 1]));
+		else if (option == "--frames")
+			frameLimit = std::stoull(argv[i + 1]);
+		else if (option == "--capture")
+			captureInterval = std::stoull(argv[i + 1]);
+		else if (option == "--windows")
+			windowCount = static_cast<uint32_t>(std::stoul(argv[i + 1]));
+		else if (option == "--prepass")
+			sessionSettings.depthPrepass = std::stoul(argv[i + 1]) != 0;
+		else if (option == "--overdraw")
+			sessionSettings.sceneInstances = static_cast<uint32_t>(std::stoul(argv[i + 1]));
+		else if (option == "--lights")
+			sessionSettings.lightCount = static_cast<uint32_t>(std::stoul(argv[i + 1]));
+		else if (option == "--post")
+			sessionSettings.postProcess = std::stoul(argv[i + 1]) != 0;
+		else if (option == "--trace")
+			traceSettings.frameCount = std::stoull(argv[i + 1]);
+		else if (option == "--trace-start")
+			traceSettings.firstFrame = std::stoull(argv[i + 1]);
+		else
+			log->warn("Unknown option {0}", option);
+	}
+
 	SDL_SetMainReady();
 	if (SDL_Init(SDL_INIT_VIDEO) < 0)
 		throw std::exception(SDL_GetError());
 
 	try
 	{
-		App app([]() { return std::make_unique<VulkanRenderer>(); });
+		// every frame is read back while capturing, only every captureInterval-th one is copied and written to disk by a worker
+		// so the render thread never waits on the file system. The writer outlives the app and finishes pending files on exit.
+		std::unique_ptr<vkp::ThreadPool> captureWriter;
+		auto pendingCaptures = std::make_shared<std::atomic<uint32_t>>(0);
+		ReadbackCallback readback;
+		if (captureInterval > 0)
+		{
+			captureWriter = std::make_unique<vkp::ThreadPool>(1);
+			readback = [captureInterval, writer = captureWriter.get(), pendingCaptures, log](const ReadbackFrame& frame)
+			{
+				if (frame.frame % captureInterval != 0)
+					return;
+				if (pendingCaptures->load() >= MAX_PENDING_CAPTURES)
+				{
+					log->warn("Skipped capture of frame {0}, {1} captures are waiting to be written", frame.frame, MAX_PENDING_CAPTURES);
+					return;
+				}
+
+				pendingCaptures->fetch_add(1);
+				std::vector<uint8_t> pixels(frame.pixels, frame.pixels + static_cast<size_t>(frame.width) * frame.height * 4);
+				const auto filename = "capture_" + std::to_string(frame.frame) + ".ppm";
+				writer->Submit([filename, width = frame.width, height = frame.height, pixels = std::move(pixels), pendingCaptures]()
+				{
+					writePpm(filename, width, height, pixels);
+					pendingCaptures->fetch_sub(1);
+				});
+			};
+		}
+
+		App app([sessionSettings, readback, traceSettings]() { return std::make_unique<VulkanRenderer>(sessionSettings, readback, traceSettings); }, maxFrameLatency, frameLimit, windowCount);
 		app.Run();
 	}
 	catch(const std::exception& e)
@@ -0,0 +1,20 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+namespace vkp
+{
+	// Non owning view on a range of bytes, the owner has to outlive the span
+	struct ByteSpan
+	{
+		const uint8_t* data = nullptr;
+		size_t size = 0;
+
+		bool empty() const { return size == 0; }
+		const uint8_t* begin() const { return data; }
+		const uint8_t* end() const { return data + size; }
+
+		template <typename T>
+		const T* as() const { return reinterpret_cast<const T*>(data); }
+	};
+}
@@ -0,0 +1,115 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace vkp
+{
+	struct FramePipelineStats
+	{
+		uint64_t frames;
+		double producerWaitSeconds;  // time the producer was blocked because the consumer fell behind
+		double consumerWaitSeconds;  // time the consumer was idle waiting for the next frame
+	};
+
+	// Hands frame snapshots from a producer thread (simulation) to a consumer thread (rendering) without locks.
+	// The producer may run up to maxLatency frames ahead of the consumer: with a latency of 1 the snapshots are double
+	// buffered and frame N+1 is simulated while frame N is rendered, 0 runs both stages in lock step.
+	// Exactly one thread may produce and one thread may consume.
+	template<typename T>
+	class FramePipeline
+	{
+		std::vector<T> slots;
+		std::atomic<uint64_t> produced{ 0 };
+		std::atomic<uint64_t> consumed{ 0 };
+		std::atomic<bool> closed{ false };
+		double producerWaitSeconds = 0.0;
+		double consumerWaitSeconds = 0.0;
+
+		// spins briefly, then yields and finally sleeps so a waiting thread does not burn a whole core for a frame
+		template<typename Predicate>
+		static double Wait(const Predicate& ready)
+		{
+			if (ready())
+				return 0.0;
+
+			const auto start = std::chrono::high_resolution_clock::now();
+			for (uint32_t i = 0; !ready(); i++)
+			{
+				if (i < 64)
+					continue;
+				if (i < 128)
+					std::this_thread::yield();
+				else
+					std::this_thread::sleep_for(std::chrono::microseconds(50));
+			}
+			return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+		}
+
+	public:
+		explicit FramePipeline(uint32_t maxLatency)
+			: slots(maxLatency + 1)
+		{
+		}
+
+		FramePipeline(const FramePipeline&) = delete;
+		FramePipeline& operator=(const FramePipeline&) = delete;
+
+		uint32_t GetMaxLatency() const { return static_cast<uint32_t>(this->slots.size() - 1); }
+
+		// producer: returns the snapshot to fill for the next frame, blocks while the consumer is maxLatency frames behind.
+		// Check IsClosed afterwards, the consumer may have given up.
+		T& BeginProduce()
+		{
+			const auto frame = this->produced.load(std::memory_order_relaxed);
+			const auto slotCount = this->slots.size();
+			this->producerWaitSeconds += Wait([this, frame, slotCount]()
+			{
+				return frame - this->consumed.load(std::memory_order_acquire) < slotCount || this->closed.load(std::memory_order_acquire);
+			});
+			return this->slots[frame % slotCount];
+		}
+
+		// producer: hands the snapshot returned by BeginProduce to the consumer
+		void EndProduce()
+		{
+			this->produced.fetch_add(1, std::memory_order_release);
+		}
+
+		// consumer: waits for the next snapshot, returns nullptr once the pipeline was closed and every frame was consumed
+		const T* BeginConsume()
+		{
+			const auto frame = this->consumed.load(std::memory_order_relaxed);
+			this->consumerWaitSeconds += Wait([this, frame]()
+			{
+				return this->produced.load(std::memory_order_acquire) > frame || this->closed.load(std::memory_order_acquire);
+			});
+
+			if (this->produced.load(std::memory_order_acquire) == frame)
+				return nullptr;
+			return &this->slots[frame % this->slots.size()];
+		}
+
+		// consumer: releases the snapshot, the producer may overwrite it afterwards
+		void EndConsume()
+		{
+			this->consumed.fetch_add(1, std::memory_order_release);
+		}
+
+		// wakes up both sides, the consumer still drains frames that were already produced
+		void Close()
+		{
+			this->closed.store(true, std::memory_order_release);
+		}
+
+		bool IsClosed() const { return this->closed.load(std::memory_order_acquire); }
+
+		// only meaningful once both threads are done
+		FramePipelineStats GetStats() const
+		{
+			return { this->consumed.load(), this->producerWaitSeconds, this->consumerWaitSeconds };
+		}
+	};
+}
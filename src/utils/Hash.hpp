@@ -0,0 +1,19 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace vkp
+{
+	// FNV-1a, only meant for plain structs without padding bytes. Pass the previous result as seed to hash several values.
+	inline uint64_t HashBytes(const void* data, size_t size, uint64_t seed = 14695981039346656037ull)
+	{
+		const auto bytes = static_cast<const uint8_t*>(data);
+		auto hash = seed;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+}
@@ -0,0 +1,187 @@
+#include "Lz4.hpp"
+#include <cstring>
+#include <vector>
+
+namespace
+{
+	constexpr size_t MinMatch = 4;
+	constexpr size_t LastLiterals = 5;
+	constexpr size_t MatchFindLimit = 12;
+	constexpr size_t MaxOffset = 65535;
+	constexpr uint32_t HashLog = 16;
+
+	uint32_t read32(const uint8_t* p)
+	{
+		uint32_t v;
+		std::memcpy(&v, p, sizeof(v));
+		return v;
+	}
+
+	uint32_t hash(uint32_t sequence)
+	{
+		return (sequence * 2654435761u) >> (32 - HashLog);
+	}
+
+	bool writeLength(uint8_t*& op, const uint8_t* opEnd, size_t length)
+	{
+		while (length >= 255)
+		{
+			if (op >= opEnd)
+				return false;
+			*op++ = 255;
+			length -= 255;
+		}
+		if (op >= opEnd)
+			return false;
+		*op++ = static_cast<uint8_t>(length);
+		return true;
+	}
+
+	bool writeSequence(uint8_t*& op, const uint8_t* opEnd, const uint8_t* literals, size_t literalLength, size_t offset, size_t matchLength)
+	{
+		if (op >= opEnd)
+			return false;
+
+		auto token = op++;
+		*token = static_cast<uint8_t>((literalLength >= 15 ? 15 : literalLength) << 4);
+		if (literalLength >= 15 && !writeLength(op, opEnd, literalLength - 15))
+			return false;
+
+		if (static_cast<size_t>(opEnd - op) < literalLength)
+			return false;
+		std::memcpy(op, literals, literalLength);
+		op += literalLength;
+
+		// the last sequence only carries literals
+		if (matchLength == 0)
+			return true;
+
+		if (static_cast<size_t>(opEnd - op) < 2)
+			return false;
+		*op++ = static_cast<uint8_t>(offset & 0xFF);
+		*op++ = static_cast<uint8_t>(offset >> 8);
+
+		const auto encodedMatchLength = matchLength - MinMatch;
+		*token |= static_cast<uint8_t>(encodedMatchLength >= 15 ? 15 : encodedMatchLength);
+		if (encodedMatchLength >= 15 && !writeLength(op, opEnd, encodedMatchLength - 15))
+			return false;
+
+		return true;
+	}
+
+	bool readLength(const uint8_t*& ip, const uint8_t* ipEnd, size_t& length)
+	{
+		uint8_t b;
+		do
+		{
+			if (ip >= ipEnd)
+				return false;
+			b = *ip++;
+			length += b;
+		} while (b == 255);
+		return true;
+	}
+}
+
+namespace vkp::lz4
+{
+	size_t CompressBound(size_t size)
+	{
+		return size + size / 255 + 16;
+	}
+
+	size_t Compress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity)
+	{
+		auto op = dst;
+		const auto opEnd = dst + dstCapacity;
+		size_t anchor = 0;
+
+		if (srcSize > MatchFindLimit)
+		{
+			// table entries store position + 1, 0 marks an empty slot
+			std::vector<uint32_t> table(size_t(1) << HashLog, 0);
+			const auto matchLimit = srcSize - LastLiterals;
+			const auto inputLimit = srcSize - MatchFindLimit;
+
+			size_t ip = 0;
+			while (ip <= inputLimit)
+			{
+				const auto sequence = read32(src + ip);
+				auto& slot = table[hash(sequence)];
+				const auto candidate = slot;
+				slot = static_cast<uint32_t>(ip + 1);
+
+				if (candidate == 0 || ip - (candidate - 1) > MaxOffset || read32(src + candidate - 1) != sequence)
+				{
+					ip++;
+					continue;
+				}
+
+				const auto ref = candidate - 1;
+				auto matchLength = MinMatch;
+				while (ip + matchLength < matchLimit && src[ref + matchLength] == src[ip + matchLength])
+					matchLength++;
+
+				if (!writeSequence(op, opEnd, src + anchor, ip - anchor, ip - ref, matchLength))
+					return 0;
+
+				ip += matchLength;
+				anchor = ip;
+			}
+		}
+
+		if (!writeSequence(op, opEnd, src + anchor, srcSize - anchor, 0, 0))
+			return 0;
+
+		return static_cast<size_t>(op - dst);
+	}
+
+	bool Decompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize)
+	{
+		auto ip = src;
+		const auto ipEnd = src + srcSize;
+		auto op = dst;
+		const auto opEnd = dst + dstSize;
+
+		while (ip < ipEnd)
+		{
+			const auto token = *ip++;
+
+			size_t literalLength = token >> 4;
+			if (literalLength == 15 && !readLength(ip, ipEnd, literalLength))
+				return false;
+
+			if (static_cast<size_t>(ipEnd - ip) < literalLength || static_cast<size_t>(opEnd - op) < literalLength)
+				return false;
+			std::memcpy(op, ip, literalLength);
+			ip += literalLength;
+			op += literalLength;
+
+			// the final sequence has no match part
+			if (ip == ipEnd)
+				break;
+
+			if (ipEnd - ip < 2)
+				return false;
+			const size_t offset = ip[0] | (ip[1] << 8);
+			ip += 2;
+			if (offset == 0 || offset > static_cast<size_t>(op - dst))
+				return false;
+
+			size_t matchLength = token & 0x0F;
+			if (matchLength == 15 && !readLength(ip, ipEnd, matchLength))
+				return false;
+			matchLength += MinMatch;
+
+			if (static_cast<size_t>(opEnd - op) < matchLength)
+				return false;
+
+			// matches may overlap their own output, so copy byte by byte
+			auto match = op - offset;
+			for (size_t i = 0; i < matchLength; i++)
+				*op++ = *match++;
+		}
+
+		return op == opEnd;
+	}
+}
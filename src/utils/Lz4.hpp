@@ -0,0 +1,17 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+// Minimal LZ4 block format codec (no frame format), compatible with the reference implementation.
+// Used by the asset archive for optional per entry compression.
+namespace vkp::lz4
+{
+	// Worst case size of the compressed output for an input of the given size
+	size_t CompressBound(size_t size);
+
+	// Returns the number of bytes written to dst or 0 if dst is too small
+	size_t Compress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity);
+
+	// Returns false if the input is malformed or does not decompress to exactly dstSize bytes
+	bool Decompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize);
+}
@@ -0,0 +1,101 @@
+#include "MappedFile.hpp"
+#include <exception>
+#if _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace vkp
+{
+	MappedFile::MappedFile(const std::string& filename)
+	{
+#if _WIN32
+		this->fileHandle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr);
+		if (this->fileHandle == INVALID_HANDLE_VALUE)
+		{
+			this->fileHandle = nullptr;
+			throw std::exception(std::string("unable to open " + filename).c_str());
+		}
+
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(this->fileHandle, &fileSize))
+		{
+			this->Close();
+			throw std::exception(std::string("unable to query size of " + filename).c_str());
+		}
+		this->size = static_cast<size_t>(fileSize.QuadPart);
+		if (this->size == 0)
+			return;
+
+		this->mappingHandle = CreateFileMappingA(this->fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (this->mappingHandle == nullptr)
+		{
+			this->Close();
+			throw std::exception(std::string("unable to map " + filename).c_str());
+		}
+
+		this->data = static_cast<const uint8_t*>(MapViewOfFile(this->mappingHandle, FILE_MAP_READ, 0, 0, 0));
+		if (this->data == nullptr)
+		{
+			this->Close();
+			throw std::exception(std::string("unable to map " + filename).c_str());
+		}
+#else
+		const auto fd = open(filename.c_str(), O_RDONLY);
+		if (fd < 0)
+			throw std::exception(std::string("unable to open " + filename).c_str());
+
+		struct stat st;
+		if (fstat(fd, &st) != 0)
+		{
+			close(fd);
+			throw std::exception(std::string("unable to query size of " + filename).c_str());
+		}
+		this->size = static_cast<size_t>(st.st_size);
+
+		if (this->size > 0)
+		{
+			const auto mapping = mmap(nullptr, this->size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (mapping == MAP_FAILED)
+			{
+				close(fd);
+				throw std::exception(std::string("unable to map " + filename).c_str());
+			}
+			this->data = static_cast<const uint8_t*>(mapping);
+		}
+
+		// the mapping keeps its own reference to the file
+		close(fd);
+#endif
+	}
+
+	MappedFile::~MappedFile()
+	{
+		this->Close();
+	}
+
+	void MappedFile::Close()
+	{
+#if _WIN32
+		if (this->data)
+			UnmapViewOfFile(this->data);
+		if (this->mappingHandle)
+			CloseHandle(this->mappingHandle);
+		if (this->fileHandle)
+			CloseHandle(this->fileHandle);
+		this->mappingHandle = nullptr;
+		this->fileHandle = nullptr;
+#else
+		if (this->data)
+			munmap(const_cast<uint8_t*>(this->data), this->size);
+#endif
+		this->data = nullptr;
+		this->size = 0;
+	}
+}
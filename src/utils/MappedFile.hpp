@@ -0,0 +1,28 @@
+#pragma once
+#include <string>
+#include "ByteSpan.hpp"
+
+namespace vkp
+{
+	// Read only memory mapping of a whole file
+	class MappedFile
+	{
+		const uint8_t* data = nullptr;
+		size_t size = 0;
+#if _WIN32
+		void* fileHandle = nullptr;
+		void* mappingHandle = nullptr;
+#endif
+
+		void Close();
+
+	public:
+		explicit MappedFile(const std::string& filename);
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		ByteSpan GetData() const { return { this->data, this->size }; }
+	};
+}
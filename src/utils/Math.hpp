@@ -0,0 +1,87 @@
+#pragma once
+#include <cmath>
+
+// Just enough linear algebra for the playground, matrices are column major like GLSL expects them
+namespace vkp::math
+{
+	struct Vec3
+	{
+		float x, y, z;
+	};
+
+	inline Vec3 operator-(const Vec3& a, const Vec3& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+	inline Vec3 operator+(const Vec3& a, const Vec3& b) { return { a.x + b.x, a.y + b.y, a.z + b.z }; }
+	inline Vec3 operator*(const Vec3& a, float s) { return { a.x * s, a.y * s, a.z * s }; }
+	inline float Dot(const Vec3& a, const Vec3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+	inline Vec3 Cross(const Vec3& a, const Vec3& b) { return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+	inline float Length(const Vec3& a) { return std::sqrt(Dot(a, a)); }
+	inline Vec3 Normalize(const Vec3& a)
+	{
+		const auto length = Length(a);
+		return length > 0.f ? a * (1.f / length) : Vec3 { 0.f, 0.f, 0.f };
+	}
+
+	struct Mat4
+	{
+		float m[16];
+
+		float& operator()(int row, int column) { return m[column * 4 + row]; }
+		float operator()(int row, int column) const { return m[column * 4 + row]; }
+
+		static Mat4 Identity()
+		{
+			return { { 1, 0, 0, 0,  0, 1, 0, 0,  0, 0, 1, 0,  0, 0, 0, 1 } };
+		}
+	};
+
+	inline Mat4 operator*(const Mat4& a, const Mat4& b)
+	{
+		Mat4 r = {};
+		for (auto column = 0; column < 4; column++)
+			for (auto row = 0; row < 4; row++)
+				for (auto k = 0; k < 4; k++)
+					r(row, column) += a(row, k) * b(k, column);
+		return r;
+	}
+
+	// right handed, depth range [0, 1] and y pointing down in clip space as vulkan expects it
+	inline Mat4 Perspective(float fovY, float aspect, float zNear, float zFar)
+	{
+		const auto f = 1.f / std::tan(fovY * 0.5f);
+		Mat4 r = {};
+		r(0, 0) = f / aspect;
+		r(1, 1) = -f;
+		r(2, 2) = zFar / (zNear - zFar);
+		r(2, 3) = zNear * zFar / (zNear - zFar);
+		r(3, 2) = -1.f;
+		return r;
+	}
+
+	inline Mat4 LookAt(const Vec3& eye, const Vec3& target, const Vec3& up)
+	{
+		const auto forward = Normalize(target - eye);
+		const auto right = Normalize(Cross(forward, up));
+		const auto cameraUp = Cross(right, forward);
+
+		auto r = Mat4::Identity();
+		r(0, 0) = right.x; r(0, 1) = right.y; r(0, 2) = right.z; r(0, 3) = -Dot(right, eye);
+		r(1, 0) = cameraUp.x; r(1, 1) = cameraUp.y; r(1, 2) = cameraUp.z; r(1, 3) = -Dot(cameraUp, eye);
+		r(2, 0) = -forward.x; r(2, 1) = -forward.y; r(2, 2) = -forward.z; r(2, 3) = Dot(forward, eye);
+		return r;
+	}
+
+	inline Mat4 Translation(const Vec3& offset)
+	{
+		auto r = Mat4::Identity();
+		r(0, 3) = offset.x; r(1, 3) = offset.y; r(2, 3) = offset.z;
+		return r;
+	}
+
+	inline Mat4 RotationY(float angle)
+	{
+		auto r = Mat4::Identity();
+		r(0, 0) = std::cos(angle); r(0, 2) = std::sin(angle);
+		r(2, 0) = -std::sin(angle); r(2, 2) = std::cos(angle);
+		return r;
+	}
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace vkp
+{
+	// Fixed number of worker threads pulling tasks from one shared queue in submission order.
+	// Meant for coarse tasks like rendering a whole frame of a session, the queue is guarded by a single mutex.
+	// Pending tasks are still run when the pool is destroyed.
+	class ThreadPool
+	{
+		std::vector<std::thread> workers;
+		std::deque<std::packaged_task<void()>> tasks;
+		std::mutex mutex;
+		std::condition_variable available;
+		bool stopping = false;
+
+		void Work()
+		{
+			for (;;)
+			{
+				std::packaged_task<void()> task;
+				{
+					std::unique_lock<std::mutex> lock(this->mutex);
+					this->available.wait(lock, [this]() { return this->stopping || !this->tasks.empty(); });
+					if (this->tasks.empty())
+						return;
+
+					task = std::move(this->tasks.front());
+					this->tasks.pop_front();
+				}
+				task();
+			}
+		}
+
+	public:
+		explicit ThreadPool(uint32_t threadCount)
+		{
+			for (uint32_t i = 0; i < std::max(threadCount, 1u); i++)
+				this->workers.emplace_back([this]() { this->Work(); });
+		}
+
+		~ThreadPool()
+		{
+			{
+				std::lock_guard<std::mutex> lock(this->mutex);
+				this->stopping = true;
+			}
+			this->available.notify_all();
+
+			for (auto& worker : this->workers)
+				worker.join();
+		}
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		uint32_t GetThreadCount() const { return static_cast<uint32_t>(this->workers.size()); }
+
+		// exceptions thrown by the task are rethrown by get() of the returned future
+		std::future<void> Submit(std::function<void()> task)
+		{
+			std::packaged_task<void()> packaged(std::move(task));
+			auto future = packaged.get_future();
+			{
+				std::lock_guard<std::mutex> lock(this->mutex);
+				this->tasks.push_back(std::move(packaged));
+			}
+			this->available.notify_one();
+			return future;
+		}
+	};
+}
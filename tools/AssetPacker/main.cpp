@@ -0,0 +1,98 @@
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <spdlog/spdlog.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include "../../src/assets/AssetArchiveWriter.hpp"
+
+namespace fs = std::filesystem;
+
+static std::vector<uint8_t> readFile(const fs::path& path)
+{
+	std::ifstream file(path, std::ios::ate | std::ios::binary);
+	if (file.fail())
+		throw std::exception(std::string("unable to open " + path.string()).c_str());
+
+	const auto fileSize = file.tellg();
+	std::vector<uint8_t> buffer(static_cast<size_t>(fileSize));
+	file.seekg(0);
+	file.read(reinterpret_cast<char*>(buffer.data()), fileSize);
+	return buffer;
+}
+
+static void printUsage()
+{
+	spdlog::get("logger")->info("usage: AssetPacker <output.vkpa> <input directory>... [--lz4] [--all]");
+	spdlog::get("logger")->info("  entries are named relative to the parent of each input directory, e.g. shader/triangle.vert.spv");
+	spdlog::get("logger")->info("  --lz4  compress entries where it saves at least 10%");
+	spdlog::get("logger")->info("  --all  also pack files of unknown type as raw entries");
+}
+
+int main(int argc, const char* argv[])
+{
+	spdlog::stdout_color_mt("logger")->set_level(spdlog::level::level_enum::info);
+	auto log = spdlog::get("logger");
+
+	std::string output;
+	std::vector<fs::path> inputs;
+	auto compress = false;
+	auto packAll = false;
+
+	for (auto i = 1; i < argc; i++)
+	{
+		const std::string arg = argv[i];
+		if (arg == "--lz4")
+			compress = true;
+		else if (arg == "--all")
+			packAll = true;
+		else if (output.empty())
+			output = arg;
+		else
+			inputs.emplace_back(arg);
+	}
+
+	if (output.empty() || inputs.empty())
+	{
+		printUsage();
+		return EXIT_FAILURE;
+	}
+
+	try
+	{
+		vkp::assets::AssetArchiveWriter writer;
+		auto count = 0;
+		for (auto& input : inputs)
+		{
+			// names keep the input directory as first component, "shaders/" and "shaders/." have to name it like "shaders" does
+			auto directory = fs::absolute(input).lexically_normal();
+			if (!directory.has_filename())
+				directory = directory.parent_path();
+			const auto root = directory.parent_path();
+			for (auto& file : fs::recursive_directory_iterator(input))
+			{
+				if (!file.is_regular_file())
+					continue;
+
+				const auto name = fs::relative(fs::absolute(file.path()), root).generic_string();
+				const auto type = vkp::assets::GuessAssetType(name);
+				if (type == vkp::assets::AssetType::Raw && !packAll)
+					continue;
+
+				log->info("Packing {0}", name);
+				writer.Add(name, type, readFile(file.path()), compress);
+				count++;
+			}
+		}
+
+		writer.Write(output);
+		log->info("Wrote {0} entries to {1}", count, output);
+	}
+	catch (const std::exception& e)
+	{
+		log->error("Packing failed: {0}", e.what());
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
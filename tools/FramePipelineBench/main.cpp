@@ -0,0 +1,126 @@
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <spdlog/spdlog.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include "../../src/utils/FramePipeline.hpp"
+
+using Clock = std::chrono::high_resolution_clock;
+
+namespace
+{
+	const uint32_t MaxLatencies[] = { 0, 1, 2 };
+
+	struct Snapshot
+	{
+		uint64_t frame;
+		Clock::time_point produced;
+		std::vector<float> transforms;
+	};
+
+	struct BenchmarkResult
+	{
+		double seconds;
+		double averageLatency;
+		vkp::FramePipelineStats stats;
+	};
+
+	void printUsage()
+	{
+		spdlog::get("logger")->info("usage: FramePipelineBench [frames] [simulation ms] [render ms] [gpu ms]");
+	}
+
+	// burns cpu time like simulation or command recording would
+	void busyWait(double milliseconds)
+	{
+		const auto end = Clock::now() + std::chrono::duration<double, std::milli>(milliseconds);
+		while (Clock::now() < end)
+		{
+		}
+	}
+
+	BenchmarkResult run(uint32_t maxLatency, uint64_t frames, double simulationMs, double renderMs, double gpuMs)
+	{
+		vkp::FramePipeline<Snapshot> pipeline(maxLatency);
+		double latencySum = 0.0;
+		uint64_t outOfOrder = 0;
+
+		// the render thread records the frame and then blocks like it would in waitForFences/presentKHR
+		std::thread renderThread([&]()
+		{
+			uint64_t expected = 0;
+			while (const auto snapshot = pipeline.BeginConsume())
+			{
+				if (snapshot->frame != expected++)
+					outOfOrder++;
+				busyWait(renderMs);
+				std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(gpuMs));
+				latencySum += std::chrono::duration<double, std::milli>(Clock::now() - snapshot->produced).count();
+				pipeline.EndConsume();
+			}
+		});
+
+		const auto start = Clock::now();
+		for (uint64_t frame = 0; frame < frames; frame++)
+		{
+			auto& snapshot = pipeline.BeginProduce();
+			snapshot.frame = frame;
+			snapshot.transforms.assign(1024, static_cast<float>(frame));
+			busyWait(simulationMs);
+			snapshot.produced = Clock::now();
+			pipeline.EndProduce();
+		}
+		pipeline.Close();
+		renderThread.join();
+
+		if (outOfOrder > 0)
+			throw std::exception(std::string("frames were consumed out of order: " + std::to_string(outOfOrder)).c_str());
+
+		BenchmarkResult result = {};
+		result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+		result.stats = pipeline.GetStats();
+		result.averageLatency = latencySum / frames;
+		return result;
+	}
+}
+
+int main(int argc, const char* argv[])
+{
+	spdlog::stdout_color_mt("logger")->set_level(spdlog::level::level_enum::info);
+	auto log = spdlog::get("logger");
+
+	std::vector<std::string> args(argv + 1, argv + argc);
+	if (!args.empty() && args[0] == "--help")
+	{
+		printUsage();
+		return EXIT_SUCCESS;
+	}
+
+	try
+	{
+		const auto frames = args.size() >= 1 ? std::stoull(args[0]) : 300;
+		const auto simulationMs = args.size() >= 2 ? std::stod(args[1]) : 4.0;
+		const auto renderMs = args.size() >= 3 ? std::stod(args[2]) : 3.0;
+		const auto gpuMs = args.size() >= 4 ? std::stod(args[3]) : 2.0;
+		log->info("{0} frames, simulation {1:.2f} ms, recording {2:.2f} ms, gpu/present wait {3:.2f} ms", frames, simulationMs, renderMs, gpuMs);
+
+		double baseline = 0.0;
+		for (const auto maxLatency : MaxLatencies)
+		{
+			const auto result = run(maxLatency, frames, simulationMs, renderMs, gpuMs);
+			const auto fps = result.stats.frames / result.seconds;
+			if (maxLatency == 0)
+				baseline = fps;
+
+			log->info("latency {0}: {1:>7.1f} fps ({2:.2f}x), frame latency {3:>6.2f} ms, simulation waited {4:>6.3f}s, render waited {5:>6.3f}s",
+				maxLatency, fps, fps / baseline, result.averageLatency, result.stats.producerWaitSeconds, result.stats.consumerWaitSeconds);
+		}
+	}
+	catch (const std::exception& e)
+	{
+		log->error("Benchmark failed: {0}", e.what());
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,317 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <spdlog/spdlog.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include "../../src/assets/AssetArchiveWriter.hpp"
+#include "../../src/gfx/FrameTraceFormat.hpp"
+#include "../../src/gfx/RenderDevice.hpp"
+#include "../../src/gfx/RenderSession.hpp"
+#include "../../src/utils/Lz4.hpp"
+#include "../../src/utils/MappedFile.hpp"
+
+using namespace vkp::trace;
+using Clock = std::chrono::high_resolution_clock;
+
+namespace
+{
+	const size_t SLOWEST_FRAMES = 5;
+	const uint32_t MAX_REPORTED_MISMATCHES = 10;
+	const uint64_t MAX_ASSET_SIZE = 1ull << 30;  // uncompressed, larger sizes only come from corrupt traces
+
+	// a frame or resize in trace order, payloads are copied out because records are not aligned after asset data
+	struct TraceEvent
+	{
+		TraceRecordType type;
+		TraceFrame frame;
+		std::vector<TraceWindowFrame> windows;
+		TraceResize resize;
+	};
+
+	struct Trace
+	{
+		TraceHeader header;
+		std::vector<TraceWindow> windows;
+		std::vector<TraceEvent> events;
+		vkp::assets::AssetArchiveWriter assets;
+		uint32_t assetCount = 0;
+	};
+
+	struct ReplayedFrame
+	{
+		uint64_t frame;
+		double cpuMilliseconds;
+		float originalMilliseconds;
+		float originalGpuMilliseconds;
+	};
+
+	void printUsage()
+	{
+		spdlog::get("logger")->info("usage: FrameReplay <trace.vkpt> [fast|timed] [loops]");
+	}
+
+	template <typename T>
+	T readStruct(const vkp::ByteSpan& data, size_t offset)
+	{
+		if (offset + sizeof(T) > data.size)
+			throw std::exception("trace truncated");
+		T value;
+		std::memcpy(&value, data.data + offset, sizeof(T));
+		return value;
+	}
+
+	Trace readTrace(const vkp::ByteSpan& data)
+	{
+		Trace trace = {};
+		trace.header = readStruct<TraceHeader>(data, 0);
+		if (trace.header.magic != TraceMagic)
+			throw std::exception("not a frame trace");
+		if (trace.header.version != TraceVersion)
+			throw std::exception("unsupported frame trace version");
+		if (trace.header.windowCount == 0)
+			throw std::exception("frame trace without windows");
+
+		auto offset = sizeof(TraceHeader);
+		for (uint32_t i = 0; i < trace.header.windowCount; i++, offset += sizeof(TraceWindow))
+			trace.windows.push_back(readStruct<TraceWindow>(data, offset));
+
+		// a capture that was cut short has no end record, everything up to its last complete record is replayed
+		while (offset + sizeof(TraceRecord) <= data.size)
+		{
+			const auto record = readStruct<TraceRecord>(data, offset);
+			offset += sizeof(TraceRecord);
+			if (record.type == TraceRecordType::End || offset + record.size > data.size)
+				break;
+
+			if (record.type == TraceRecordType::Frame)
+			{
+				TraceEvent event = {};
+				event.type = record.type;
+				event.frame = readStruct<TraceFrame>(data, offset);
+				if (event.frame.windowCount != trace.header.windowCount || record.size != sizeof(TraceFrame) + event.frame.windowCount * sizeof(TraceWindowFrame))
+					throw std::exception("malformed frame record");
+				for (uint32_t i = 0; i < event.frame.windowCount; i++)
+					event.windows.push_back(readStruct<TraceWindowFrame>(data, offset + sizeof(TraceFrame) + i * sizeof(TraceWindowFrame)));
+				trace.events.push_back(std::move(event));
+			}
+			else if (record.type == TraceRecordType::Resize)
+			{
+				TraceEvent event = {};
+				event.type = record.type;
+				event.resize = readStruct<TraceResize>(data, offset);
+				if (event.resize.window >= trace.header.windowCount)
+					throw std::exception("resize of an unknown window");
+				trace.events.push_back(std::move(event));
+			}
+			else if (record.type == TraceRecordType::Asset)
+			{
+				// sizes are untrusted, ranges are checked by subtraction so they cannot wrap around
+				if (record.size < sizeof(TraceAsset))
+					throw std::exception("malformed asset record");
+				const auto asset = readStruct<TraceAsset>(data, offset);
+				if (asset.nameLength > record.size - sizeof(TraceAsset) || asset.storedSize != record.size - sizeof(TraceAsset) - asset.nameLength)
+					throw std::exception("malformed asset record");
+				if (asset.size > MAX_ASSET_SIZE || (!(asset.flags & TraceAssetFlagLz4) && asset.storedSize != asset.size))
+					throw std::exception("malformed asset record");
+
+				const auto name = data.data + offset + sizeof(TraceAsset);
+				const auto stored = name + asset.nameLength;
+				std::vector<uint8_t> contents(asset.size);
+				if (asset.flags & TraceAssetFlagLz4)
+				{
+					if (!vkp::lz4::Decompress(stored, asset.storedSize, contents.data(), contents.size()))
+						throw std::exception("corrupt asset in trace");
+				}
+				else
+					std::copy_n(stored, asset.storedSize, contents.data());
+
+				// the replay archive is only read once, compressing it again would only cost time
+				trace.assets.Add(std::string(reinterpret_cast<const char*>(name), asset.nameLength), static_cast<vkp::assets::AssetType>(asset.type), std::move(contents), false);
+				trace.assetCount++;
+			}
+			offset += record.size;
+		}
+		return trace;
+	}
+
+	FrameSnapshot makeSnapshot(const TraceEvent& event)
+	{
+		const auto& frame = event.frame;
+		FrameSnapshot snapshot = {};
+		snapshot.frame = frame.frame;
+		snapshot.time = frame.time;
+		snapshot.deltaTime = frame.deltaTime;
+		for (const auto& window : event.windows)
+			snapshot.windows.push_back({ window.width, window.height, window.minimized != 0 });
+		snapshot.cameraPosition = { frame.cameraPosition[0], frame.cameraPosition[1], frame.cameraPosition[2] };
+		snapshot.cameraTarget = { frame.cameraTarget[0], frame.cameraTarget[1], frame.cameraTarget[2] };
+		snapshot.meshRotation = frame.meshRotation;
+		return snapshot;
+	}
+
+	// the replay has to record exactly the draws and binds of the capture, otherwise its timings are not comparable
+	bool matchesCapture(const RenderSession& session, const TraceWindowFrame& captured)
+	{
+		const auto stats = session.GetFrameQueueStats();
+		return stats.draws == captured.draws && stats.pipelineBinds == captured.pipelineBinds && stats.descriptorBinds == captured.descriptorBinds &&
+			stats.vertexBufferBinds + stats.indexBufferBinds == captured.bufferBinds;
+	}
+}
+
+int main(int argc, const char* argv[])
+{
+	spdlog::stdout_color_mt("logger")->set_level(spdlog::level::level_enum::info);
+	spdlog::stdout_color_mt("vk-perf")->set_level(spdlog::level::level_enum::warn);
+	spdlog::stdout_color_mt("vk-general")->set_level(spdlog::level::level_enum::warn);
+	spdlog::stdout_color_mt("vk-val")->set_level(spdlog::level::level_enum::warn);
+	auto log = spdlog::get("logger");
+
+	std::vector<std::string> args(argv + 1, argv + argc);
+	if (args.empty() || args[0] == "--help")
+	{
+		printUsage();
+		return args.empty() ? EXIT_FAILURE : EXIT_SUCCESS;
+	}
+
+	const auto archive = args[0] + ".vkpa";
+	try
+	{
+		const auto timed = args.size() >= 2 && args[1] == "timed";
+		const auto loops = args.size() >= 3 ? std::max(std::stoul(args[2]), 1ul) : 1ul;
+
+		std::unique_ptr<Trace> trace;
+		{
+			vkp::MappedFile file(args[0]);
+			trace = std::make_unique<Trace>(readTrace(file.GetData()));
+		}
+		trace->assets.Write(archive);
+
+		const auto& header = trace->header;
+		const auto frameCount = std::count_if(trace->events.begin(), trace->events.end(), [](const TraceEvent& e) { return e.type == TraceRecordType::Frame; });
+		log->info("{0}: {1} windows, {2} frames from frame {3}, {4} assets, {5} replay", args[0], header.windowCount, frameCount, header.firstFrame,
+			trace->assetCount, timed ? "timed" : "fast");
+		if (frameCount == 0)
+			throw std::exception("trace contains no frames");
+
+		RenderSessionSettings settings;
+		settings.dynamicResolution = header.settings.dynamicResolution != 0;
+		settings.depthPrepass = header.settings.depthPrepass != 0;
+		settings.sceneInstances = header.settings.sceneInstances;
+		settings.pipelineStatistics = header.settings.pipelineStatistics != 0;
+		settings.lightCount = header.settings.lightCount;
+		settings.postProcess = header.settings.postProcess != 0;
+
+		// the device goes first, the archive file can only be removed once it is unmapped
+		{
+			RenderDevice renderDevice(nullptr, archive);
+			std::vector<std::unique_ptr<RenderSession>> sessions;
+			for (const auto& window : trace->windows)
+				sessions.push_back(std::make_unique<RenderSession>(renderDevice, static_cast<vk::Format>(window.format), vk::Extent2D(window.width, window.height), settings));
+
+			std::vector<ReplayedFrame> replayed;
+			uint32_t mismatches = 0;
+			const auto firstTimestamp = std::find_if(trace->events.begin(), trace->events.end(), [](const TraceEvent& e) { return e.type == TraceRecordType::Frame; })->frame.timestamp;
+			const auto start = Clock::now();
+			for (unsigned long loop = 0; loop < loops; loop++)
+			{
+				// every loop starts from the window sizes at the start of the capture
+				for (size_t i = 0; i < sessions.size(); i++)
+				{
+					const vk::Extent2D extent(trace->windows[i].width, trace->windows[i].height);
+					if (sessions[i]->GetExtent() != extent)
+					{
+						sessions[i]->WaitIdle();
+						sessions[i]->Resize(extent);
+					}
+				}
+
+				const auto loopStart = Clock::now();
+				for (const auto& event : trace->events)
+				{
+					if (event.type == TraceRecordType::Resize)
+					{
+						auto& session = *sessions[event.resize.window];
+						session.WaitIdle();
+						session.Resize(vk::Extent2D(event.resize.swapChainWidth, event.resize.swapChainHeight));
+						continue;
+					}
+
+					if (timed)
+						std::this_thread::sleep_until(loopStart + std::chrono::nanoseconds(event.frame.timestamp - firstTimestamp));
+
+					const auto snapshot = makeSnapshot(event);
+					const auto frameStart = Clock::now();
+					for (size_t i = 0; i < sessions.size(); i++)
+					{
+						const auto& captured = event.windows[i];
+						if (captured.minimized)
+							continue;
+
+						auto& session = *sessions[i];
+						session.BeginFrame();
+						session.SetRenderScale(captured.renderScale);
+						auto commandBuffer = session.RecordFrame(snapshot);
+						commandBuffer.end();
+
+						const vk::SubmitInfo submitInfo(0, nullptr, nullptr, 1, &commandBuffer, 0, nullptr);
+						if (renderDevice.Submit(session.GetQueue(), 1, &submitInfo, session.GetFrameFence()) != vk::Result::eSuccess)
+							throw std::exception("error while submitting command buffer to graphics queue");
+						session.EndFrame();
+
+						if (!matchesCapture(session, captured) && mismatches++ < MAX_REPORTED_MISMATCHES)
+						{
+							const auto stats = session.GetFrameQueueStats();
+							log->warn("frame {0} window {1}: replayed {2} draws, {3} pipeline binds, captured {4} draws, {5} pipeline binds", event.frame.frame, i,
+								stats.draws, stats.pipelineBinds, captured.draws, captured.pipelineBinds);
+						}
+					}
+					replayed.push_back({ event.frame.frame, std::chrono::duration<double, std::milli>(Clock::now() - frameStart).count(),
+						event.frame.drawMilliseconds, event.frame.gpuMilliseconds });
+				}
+			}
+
+			for (auto& session : sessions)
+				session->WaitIdle();
+			const auto seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+			const auto& statistics = sessions.front()->GetStatistics();
+			double cpuMilliseconds = 0.0;
+			double originalMilliseconds = 0.0;
+			for (const auto& frame : replayed)
+			{
+				cpuMilliseconds += frame.cpuMilliseconds;
+				originalMilliseconds += frame.originalMilliseconds;
+			}
+			log->info("{0} frames in {1:.3f} s ({2:.1f} frames/s), CPU {3:.3f} ms/frame (captured {4:.3f}), GPU {5:.3f} ms/frame over {6} timed frames",
+				replayed.size(), seconds, replayed.size() / seconds, cpuMilliseconds / replayed.size(), originalMilliseconds / replayed.size(), statistics.averageGpuMilliseconds, statistics.timedFrames);
+
+			// the slowest frames of the replay next to what they cost when they were captured, spikes that replay are in the renderer
+			std::sort(replayed.begin(), replayed.end(), [](const ReplayedFrame& a, const ReplayedFrame& b) { return a.cpuMilliseconds > b.cpuMilliseconds; });
+			for (size_t i = 0; i < std::min(SLOWEST_FRAMES, replayed.size()); i++)
+			{
+				const auto& frame = replayed[i];
+				log->info("  frame {0:>8}: {1:>8.3f} ms CPU, captured {2:>8.3f} ms CPU / {3:>8.3f} ms GPU", frame.frame, frame.cpuMilliseconds,
+					frame.originalMilliseconds, frame.originalGpuMilliseconds);
+			}
+
+			if (mismatches > 0)
+				log->warn("{0} window frames recorded different work than captured", mismatches);
+			for (auto& session : sessions)
+				session->LogStats();
+		}
+		std::filesystem::remove(archive);
+	}
+	catch (const std::exception& e)
+	{
+		std::error_code error;
+		std::filesystem::remove(archive, error);
+		log->error("Replay failed: {0}", e.what());
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,190 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <future>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <spdlog/spdlog.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include "../../src/gfx/FrameReadback.hpp"
+#include "../../src/gfx/RenderDevice.hpp"
+#include "../../src/gfx/RenderSession.hpp"
+#include "../../src/utils/ThreadPool.hpp"
+
+using Clock = std::chrono::high_resolution_clock;
+
+namespace
+{
+	const char* ASSET_ARCHIVE = "assets.vkpa";
+	const vk::Format SESSION_FORMAT = vk::Format::eR8G8B8A8Unorm;
+	const vk::Extent2D SESSION_EXTENTS[] = { { 1280, 720 }, { 1920, 1080 }, { 640, 480 }, { 1024, 1024 } };
+	const double FRAME_TIME = 1.0 / 60.0;
+
+	struct ServerSession
+	{
+		// the readback is declared after the session so it is destroyed first, its buffers live in the session allocator
+		std::unique_ptr<RenderSession> session;
+		std::unique_ptr<FrameReadback> readback;
+		uint64_t framesRead = 0;
+		double seconds = 0.0;  // accumulated CPU time of the frames of the last run
+	};
+
+	void printUsage()
+	{
+		spdlog::get("logger")->info("usage: HeadlessServer [sessions] [frames] [graphics queues] [readback 0|1] [depth pre-pass 0|1] [instances] [lights]");
+	}
+
+	// every session looks at the scene from its own orbit, so no two sessions render the same image
+	FrameSnapshot makeSnapshot(size_t session, uint64_t frame)
+	{
+		FrameSnapshot snapshot = {};
+		snapshot.frame = frame;
+		snapshot.time = frame * FRAME_TIME;
+		snapshot.deltaTime = static_cast<float>(FRAME_TIME);
+
+		const auto angle = static_cast<float>(session) * 0.7f;
+		const auto distance = 4.f + static_cast<float>(session % 4);
+		snapshot.cameraPosition = { std::sin(angle) * distance, 2.5f, std::cos(angle) * distance };
+		snapshot.cameraTarget = { 0.f, 0.f, 0.f };
+		snapshot.meshRotation = static_cast<float>(snapshot.time * (0.5 + 0.1 * session));
+		return snapshot;
+	}
+
+	// renders one frame of the session, called by exactly one worker at a time per session
+	void renderFrame(RenderDevice& renderDevice, ServerSession& server, size_t index, uint64_t frame)
+	{
+		const auto start = Clock::now();
+		auto& session = *server.session;
+
+		const auto frameIndex = session.BeginFrame();
+		if (server.readback)
+			server.readback->Deliver(frameIndex);
+
+		auto commandBuffer = session.RecordFrame(makeSnapshot(index, frame));
+		if (server.readback)
+			server.readback->Record(commandBuffer, frameIndex, session.GetFrameNumber(), session.GetRenderTarget(), session.GetExtent());
+		commandBuffer.end();
+
+		const vk::SubmitInfo submitInfo(0, nullptr, nullptr, 1, &commandBuffer, 0, nullptr);
+		if (renderDevice.Submit(session.GetQueue(), 1, &submitInfo, session.GetFrameFence()) != vk::Result::eSuccess)
+			throw std::exception("error while submitting command buffer to graphics queue");
+
+		session.EndFrame();
+		server.seconds += std::chrono::duration<double>(Clock::now() - start).count();
+	}
+
+	// every tick renders one frame of each session on the pool and waits for all of them, returns the wall clock time
+	double run(RenderDevice& renderDevice, std::vector<ServerSession>& sessions, uint32_t threads, uint64_t frames)
+	{
+		vkp::ThreadPool pool(threads);
+		for (auto& server : sessions)
+			server.seconds = 0.0;
+
+		std::vector<std::future<void>> pending;
+		const auto start = Clock::now();
+		for (uint64_t frame = 0; frame < frames; frame++)
+		{
+			pending.clear();
+			for (size_t i = 0; i < sessions.size(); i++)
+				pending.emplace_back(pool.Submit([&renderDevice, &sessions, i, frame]() { renderFrame(renderDevice, sessions[i], i, frame); }));
+
+			for (auto& future : pending)
+				future.get();
+		}
+
+		for (auto& server : sessions)
+		{
+			server.session->WaitIdle();
+			if (server.readback)
+				server.readback->DeliverAll();
+		}
+		return std::chrono::duration<double>(Clock::now() - start).count();
+	}
+}
+
+int main(int argc, const char* argv[])
+{
+	spdlog::stdout_color_mt("logger")->set_level(spdlog::level::level_enum::info);
+	spdlog::stdout_color_mt("vk-perf")->set_level(spdlog::level::level_enum::info);
+	spdlog::stdout_color_mt("vk-general")->set_level(spdlog::level::level_enum::warn);
+	spdlog::stdout_color_mt("vk-val")->set_level(spdlog::level::level_enum::warn);
+	auto log = spdlog::get("logger");
+
+	std::vector<std::string> args(argv + 1, argv + argc);
+	if (!args.empty() && args[0] == "--help")
+	{
+		printUsage();
+		return EXIT_SUCCESS;
+	}
+
+	try
+	{
+		const auto sessionCount = args.size() >= 1 ? std::stoul(args[0]) : 4;
+		const auto frames = args.size() >= 2 ? std::stoull(args[1]) : 600;
+		const auto queues = args.size() >= 3 ? static_cast<uint32_t>(std::stoul(args[2])) : 1;
+		const auto readback = args.size() >= 4 && args[3] == "1";
+
+		RenderSessionSettings settings;
+		settings.depthPrepass = args.size() < 5 || args[4] != "0";
+		settings.sceneInstances = args.size() >= 6 ? static_cast<uint32_t>(std::stoul(args[5])) : 1;
+		settings.pipelineStatistics = true;
+		settings.lightCount = args.size() >= 7 ? static_cast<uint32_t>(std::stoul(args[6])) : 0;
+
+		RenderDevice renderDevice(nullptr, ASSET_ARCHIVE, queues);
+		log->info("{0} sessions, {1} frames, {2} graphics queue(s), readback {3}, depth pre-pass {4}, {5} instance(s), {6} light(s)", sessionCount, frames,
+			renderDevice.GetQueueInfo().graphicsQueues.size(), readback ? "on" : "off", settings.depthPrepass ? "on" : "off", settings.sceneInstances, settings.lightCount);
+
+		std::vector<ServerSession> sessions(sessionCount);
+		for (size_t i = 0; i < sessions.size(); i++)
+		{
+			auto& server = sessions[i];
+			const auto extent = SESSION_EXTENTS[i % std::size(SESSION_EXTENTS)];
+			server.session = std::make_unique<RenderSession>(renderDevice, SESSION_FORMAT, extent, settings);
+			if (readback)
+			{
+				auto& framesRead = server.framesRead;
+				server.readback = std::make_unique<FrameReadback>(server.session->GetAllocator(), server.session->GetFramesInFlight(), SESSION_FORMAT,
+					[&framesRead](const ReadbackFrame& frame) { framesRead++; });
+			}
+			log->info("session {0}: {1}x{2} on queue {3}", i, extent.width, extent.height, server.session->GetQueue());
+		}
+
+		// thread counts double up to one thread per session, capped by the cores of the machine
+		const auto maxThreads = std::max(1u, std::min(static_cast<uint32_t>(sessions.size()), std::thread::hardware_concurrency()));
+		std::vector<uint32_t> threadCounts;
+		for (uint32_t threads = 1; threads < maxThreads; threads *= 2)
+			threadCounts.push_back(threads);
+		threadCounts.push_back(maxThreads);
+
+		double baseline = 0.0;
+		for (const auto threads : threadCounts)
+		{
+			const auto seconds = run(renderDevice, sessions, threads, frames);
+			const auto fps = sessions.size() * frames / seconds;
+			if (threads == 1)
+				baseline = fps;
+
+			log->info("{0} thread(s): {1:>8.1f} frames/s total ({2:.2f}x), {3:>7.1f} frames/s per session", threads, fps, fps / baseline, fps / sessions.size());
+			for (size_t i = 0; i < sessions.size(); i++)
+			{
+				const auto& server = sessions[i];
+				const auto& statistics = server.session->GetStatistics();
+				const auto extent = server.session->GetExtent();
+				log->info("  session {0}: {1:.3f} ms CPU/frame, {2} frames read back, {3:.2f} fragment invocations per pixel", i, server.seconds * 1000.0 / frames,
+					server.framesRead, statistics.averageFragmentInvocations / (static_cast<double>(extent.width) * extent.height));
+			}
+		}
+
+		for (auto& server : sessions)
+			server.session->LogStats();
+	}
+	catch (const std::exception& e)
+	{
+		log->error("Server failed: {0}", e.what());
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,129 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+#include <spdlog/spdlog.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include "../../src/gfx/RenderDevice.hpp"
+#include "../../src/gfx/RenderSession.hpp"
+
+using Clock = std::chrono::high_resolution_clock;
+
+namespace
+{
+	const char* ASSET_ARCHIVE = "assets.vkpa";
+	const vk::Format SESSION_FORMAT = vk::Format::eR8G8B8A8Unorm;
+	const vk::Extent2D SESSION_EXTENT = { 1920, 1080 };
+	const uint32_t DefaultLightCounts[] = { 16, 64, 256, 1024, 4096, 10000 };
+	const double FRAME_TIME = 1.0 / 60.0;
+
+	struct BenchmarkResult
+	{
+		double cpuMilliseconds;
+		double gpuMilliseconds;
+		double cullingMilliseconds;
+		double fragmentInvocationsPerPixel;
+	};
+
+	void printUsage()
+	{
+		spdlog::get("logger")->info("usage: LightClusterBench [frames] [light counts...]");
+	}
+
+	// the camera circles the scene, so clusters see the lights from every side during a run
+	FrameSnapshot makeSnapshot(uint64_t frame)
+	{
+		FrameSnapshot snapshot = {};
+		snapshot.frame = frame;
+		snapshot.time = frame * FRAME_TIME;
+		snapshot.deltaTime = static_cast<float>(FRAME_TIME);
+
+		const auto angle = static_cast<float>(snapshot.time * 0.3);
+		snapshot.cameraPosition = { std::sin(angle) * 5.f, 2.5f, std::cos(angle) * 5.f };
+		snapshot.cameraTarget = { 0.f, 0.f, 0.f };
+		snapshot.meshRotation = static_cast<float>(snapshot.time * 0.5);
+		return snapshot;
+	}
+
+	BenchmarkResult run(RenderDevice& renderDevice, uint32_t lightCount, uint64_t frames)
+	{
+		RenderSessionSettings settings;
+		settings.lightCount = lightCount;
+		settings.pipelineStatistics = true;
+		RenderSession session(renderDevice, SESSION_FORMAT, SESSION_EXTENT, settings);
+
+		double seconds = 0.0;
+		for (uint64_t frame = 0; frame < frames; frame++)
+		{
+			const auto start = Clock::now();
+			session.BeginFrame();
+			auto commandBuffer = session.RecordFrame(makeSnapshot(frame));
+			commandBuffer.end();
+
+			const vk::SubmitInfo submitInfo(0, nullptr, nullptr, 1, &commandBuffer, 0, nullptr);
+			if (renderDevice.Submit(session.GetQueue(), 1, &submitInfo, session.GetFrameFence()) != vk::Result::eSuccess)
+				throw std::exception("error while submitting command buffer to graphics queue");
+
+			session.EndFrame();
+			seconds += std::chrono::duration<double>(Clock::now() - start).count();
+		}
+
+		// the timings of the last frames in flight are never read, they would only be when their slots come around again
+		session.WaitIdle();
+
+		const auto& statistics = session.GetStatistics();
+		const auto pixels = static_cast<double>(SESSION_EXTENT.width) * SESSION_EXTENT.height;
+		return { seconds * 1000.0 / frames, statistics.averageGpuMilliseconds, statistics.averageCullingMilliseconds, statistics.averageFragmentInvocations / pixels };
+	}
+}
+
+int main(int argc, const char* argv[])
+{
+	spdlog::stdout_color_mt("logger")->set_level(spdlog::level::level_enum::info);
+	spdlog::stdout_color_mt("vk-perf")->set_level(spdlog::level::level_enum::warn);
+	spdlog::stdout_color_mt("vk-general")->set_level(spdlog::level::level_enum::warn);
+	spdlog::stdout_color_mt("vk-val")->set_level(spdlog::level::level_enum::warn);
+	auto log = spdlog::get("logger");
+
+	std::vector<std::string> args(argv + 1, argv + argc);
+	if (!args.empty() && args[0] == "--help")
+	{
+		printUsage();
+		return EXIT_SUCCESS;
+	}
+
+	try
+	{
+		const auto frames = args.size() >= 1 ? std::max(std::stoull(args[0]), 1ull) : 600;
+		std::vector<uint32_t> lightCounts;
+		for (size_t i = 1; i < args.size(); i++)
+			lightCounts.push_back(static_cast<uint32_t>(std::stoul(args[i])));
+		if (lightCounts.empty())
+			lightCounts.assign(std::begin(DefaultLightCounts), std::end(DefaultLightCounts));
+
+		RenderDevice renderDevice(nullptr, ASSET_ARCHIVE);
+		log->info("{0}x{1}, {2} frames per light count", SESSION_EXTENT.width, SESSION_EXTENT.height, frames);
+
+		// the recorded command buffers are the same for every light count, only the light upload grows on the CPU
+		double baseline = 0.0;
+		for (const auto lightCount : lightCounts)
+		{
+			const auto result = run(renderDevice, lightCount, frames);
+			if (baseline == 0.0)
+				baseline = result.gpuMilliseconds;
+
+			log->info("{0:>6} lights: {1:>7.3f} ms CPU, {2:>7.3f} ms GPU ({3:.2f}x), culling {4:>7.3f} ms, {5:.2f} fragment invocations per pixel",
+				lightCount, result.cpuMilliseconds, result.gpuMilliseconds, baseline > 0.0 ? result.gpuMilliseconds / baseline : 0.0,
+				result.cullingMilliseconds, result.fragmentInvocationsPerPixel);
+		}
+	}
+	catch (const std::exception& e)
+	{
+		log->error("Benchmark failed: {0}", e.what());
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// Unquantized intermediate representation shared by the loaders, the optimizer and the encoder
+struct ImportedVertex
+{
+	float position[3];
+	float normal[3];
+	float uv[2];
+};
+
+struct ImportedMesh
+{
+	std::vector<ImportedVertex> vertices;
+	std::vector<uint32_t> indices;
+};
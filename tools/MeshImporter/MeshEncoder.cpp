@@ -0,0 +1,160 @@
+#include "MeshEncoder.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <exception>
+#include <limits>
+#include <string>
+
+using namespace vkp::assets;
+
+namespace
+{
+	int16_t toSnorm16(float value)
+	{
+		return static_cast<int16_t>(std::lround(std::clamp(value, -1.f, 1.f) * 32767.f));
+	}
+
+	uint16_t toUnorm16(float value)
+	{
+		return static_cast<uint16_t>(std::lround(std::clamp(value, 0.f, 1.f) * 65535.f));
+	}
+
+	float fromSnorm16(int16_t value)
+	{
+		return std::max(value / 32767.f, -1.f);
+	}
+
+	float signNotZero(float value)
+	{
+		return value >= 0.f ? 1.f : -1.f;
+	}
+
+	void encodeOctahedral(const float normal[3], int16_t out[2])
+	{
+		const auto l1 = std::abs(normal[0]) + std::abs(normal[1]) + std::abs(normal[2]);
+		auto x = l1 > 0.f ? normal[0] / l1 : 0.f;
+		auto y = l1 > 0.f ? normal[1] / l1 : 0.f;
+		if (normal[2] < 0.f)
+		{
+			const auto ox = (1.f - std::abs(y)) * signNotZero(x);
+			const auto oy = (1.f - std::abs(x)) * signNotZero(y);
+			x = ox;
+			y = oy;
+		}
+		out[0] = toSnorm16(x);
+		out[1] = toSnorm16(y);
+	}
+
+	void decodeOctahedral(const int16_t in[2], float normal[3])
+	{
+		auto x = fromSnorm16(in[0]);
+		auto y = fromSnorm16(in[1]);
+		const auto z = 1.f - std::abs(x) - std::abs(y);
+		const auto t = std::max(-z, 0.f);
+		x += x >= 0.f ? -t : t;
+		y += y >= 0.f ? -t : t;
+		const auto length = std::sqrt(x * x + y * y + z * z);
+		normal[0] = x / length;
+		normal[1] = y / length;
+		normal[2] = z / length;
+	}
+
+	size_t alignUp(size_t value, size_t alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+}
+
+std::vector<uint8_t> EncodeMesh(const ImportedMesh& mesh)
+{
+	// loaders only validate the layout, the indices have to be right when the file is written
+	if (mesh.vertices.empty() || mesh.indices.empty())
+		throw std::exception("mesh has no vertices or no indices");
+	if (mesh.vertices.size() > std::numeric_limits<uint32_t>::max() || mesh.indices.size() > std::numeric_limits<uint32_t>::max())
+		throw std::exception("mesh has too many vertices or indices");
+	const auto maxIndex = *std::max_element(mesh.indices.begin(), mesh.indices.end());
+	if (maxIndex >= mesh.vertices.size())
+		throw std::exception(std::string("index " + std::to_string(maxIndex) + " out of range of " + std::to_string(mesh.vertices.size()) + " vertices").c_str());
+
+	MeshHeader header = {};
+	header.magic = MeshMagic;
+	header.version = MeshVersion;
+	header.vertexCount = static_cast<uint32_t>(mesh.vertices.size());
+	header.indexCount = static_cast<uint32_t>(mesh.indices.size());
+	header.vertexStride = sizeof(PackedVertex);
+	header.indexType = mesh.vertices.size() <= std::numeric_limits<uint16_t>::max() ? MeshIndexType::UInt16 : MeshIndexType::UInt32;
+
+	float minPosition[3], maxPosition[3], minUv[2], maxUv[2];
+	std::fill_n(minPosition, 3, std::numeric_limits<float>::max());
+	std::fill_n(maxPosition, 3, std::numeric_limits<float>::lowest());
+	std::fill_n(minUv, 2, std::numeric_limits<float>::max());
+	std::fill_n(maxUv, 2, std::numeric_limits<float>::lowest());
+	for (auto& v : mesh.vertices)
+	{
+		for (auto i = 0; i < 3; i++)
+		{
+			minPosition[i] = std::min(minPosition[i], v.position[i]);
+			maxPosition[i] = std::max(maxPosition[i], v.position[i]);
+		}
+		for (auto i = 0; i < 2; i++)
+		{
+			minUv[i] = std::min(minUv[i], v.uv[i]);
+			maxUv[i] = std::max(maxUv[i], v.uv[i]);
+		}
+	}
+
+	// positions are stored relative to the bounding box center, uvs relative to their bounding rectangle
+	for (auto i = 0; i < 3; i++)
+	{
+		header.positionOffset[i] = (minPosition[i] + maxPosition[i]) * 0.5f;
+		header.positionScale[i] = std::max((maxPosition[i] - minPosition[i]) * 0.5f, 1e-6f);
+	}
+	for (auto i = 0; i < 2; i++)
+	{
+		header.uvOffset[i] = minUv[i];
+		header.uvScale[i] = std::max(maxUv[i] - minUv[i], 1e-6f);
+	}
+
+	const auto indexSize = header.indexType == MeshIndexType::UInt16 ? sizeof(uint16_t) : sizeof(uint32_t);
+	header.vertexOffset = alignUp(sizeof(MeshHeader), 16);
+	header.indexOffset = alignUp(header.vertexOffset + mesh.vertices.size() * sizeof(PackedVertex), 16);
+	header.indexSize = mesh.indices.size() * indexSize;
+
+	std::vector<uint8_t> data(header.indexOffset + header.indexSize, 0);
+	std::memcpy(data.data(), &header, sizeof(header));
+
+	auto packed = reinterpret_cast<PackedVertex*>(data.data() + header.vertexOffset);
+	for (auto& v : mesh.vertices)
+	{
+		for (auto i = 0; i < 3; i++)
+			packed->position[i] = toSnorm16((v.position[i] - header.positionOffset[i]) / header.positionScale[i]);
+		packed->position[3] = 32767;
+		encodeOctahedral(v.normal, packed->normal);
+		for (auto i = 0; i < 2; i++)
+			packed->uv[i] = toUnorm16((v.uv[i] - header.uvOffset[i]) / header.uvScale[i]);
+		packed++;
+	}
+
+	if (header.indexType == MeshIndexType::UInt16)
+	{
+		auto out = reinterpret_cast<uint16_t*>(data.data() + header.indexOffset);
+		for (const auto index : mesh.indices)
+			*out++ = static_cast<uint16_t>(index);
+	}
+	else
+		std::memcpy(data.data() + header.indexOffset, mesh.indices.data(), header.indexSize);
+
+	return data;
+}
+
+ImportedVertex DecodeVertex(const MeshHeader& header, const PackedVertex& vertex)
+{
+	ImportedVertex result = {};
+	for (auto i = 0; i < 3; i++)
+		result.position[i] = fromSnorm16(vertex.position[i]) * header.positionScale[i] + header.positionOffset[i];
+	decodeOctahedral(vertex.normal, result.normal);
+	for (auto i = 0; i < 2; i++)
+		result.uv[i] = vertex.uv[i] / 65535.f * header.uvScale[i] + header.uvOffset[i];
+	return result;
+}
@@ -0,0 +1,10 @@
+#pragma once
+#include <vector>
+#include "ImportedMesh.hpp"
+#include "../../src/assets/MeshFormat.hpp"
+
+// Quantizes the mesh and serializes it into the binary .vkmesh layout, throws for empty meshes and out of range indices
+std::vector<uint8_t> EncodeMesh(const ImportedMesh& mesh);
+
+// Expands a packed vertex back to floats, used for error reporting and the benchmark baseline
+ImportedVertex DecodeVertex(const vkp::assets::MeshHeader& header, const vkp::assets::PackedVertex& vertex);
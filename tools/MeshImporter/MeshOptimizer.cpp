@@ -0,0 +1,281 @@
+#include "MeshOptimizer.hpp"
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include "../../src/utils/Math.hpp"
+
+using vkp::math::Vec3;
+
+namespace
+{
+	constexpr int ForsythCacheSize = 32;
+
+	float vertexScore(int cachePosition, uint32_t liveTriangles)
+	{
+		if (liveTriangles == 0)
+			return -1.f;
+
+		auto score = 0.f;
+		if (cachePosition >= 0)
+		{
+			// the last triangle's vertices get a fixed score so the next triangle does not simply reuse the same edge
+			if (cachePosition < 3)
+				score = 0.75f;
+			else
+				score = std::pow(1.f - static_cast<float>(cachePosition - 3) / (ForsythCacheSize - 3), 1.5f);
+		}
+
+		// favor vertices with few remaining triangles to get rid of lone triangles early
+		score += 2.f / std::sqrt(static_cast<float>(liveTriangles));
+		return score;
+	}
+
+	Vec3 positionOf(const ImportedVertex& v)
+	{
+		return { v.position[0], v.position[1], v.position[2] };
+	}
+}
+
+VertexCacheStats AnalyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize)
+{
+	std::deque<uint32_t> cache;
+	std::vector<bool> cached(vertexCount, false);
+	uint32_t misses = 0;
+
+	for (const auto index : indices)
+	{
+		if (cached[index])
+			continue;
+
+		misses++;
+		cache.push_back(index);
+		cached[index] = true;
+		if (cache.size() > cacheSize)
+		{
+			cached[cache.front()] = false;
+			cache.pop_front();
+		}
+	}
+
+	const auto triangles = indices.size() / 3;
+	return {
+		triangles > 0 ? static_cast<float>(misses) / triangles : 0.f,
+		vertexCount > 0 ? static_cast<float>(misses) / vertexCount : 0.f,
+		misses
+	};
+}
+
+void OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount)
+{
+	const auto triangleCount = indices.size() / 3;
+
+	// vertex -> triangle adjacency in compressed row form
+	std::vector<uint32_t> liveTriangles(vertexCount, 0);
+	for (const auto index : indices)
+		liveTriangles[index]++;
+
+	std::vector<uint32_t> adjacencyOffset(vertexCount + 1, 0);
+	for (size_t v = 0; v < vertexCount; v++)
+		adjacencyOffset[v + 1] = adjacencyOffset[v] + liveTriangles[v];
+
+	std::vector<uint32_t> adjacency(indices.size());
+	std::vector<uint32_t> fill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+	for (size_t i = 0; i < indices.size(); i++)
+		adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+
+	std::vector<int> cachePosition(vertexCount, -1);
+	std::vector<float> vertexScores(vertexCount);
+	for (size_t v = 0; v < vertexCount; v++)
+		vertexScores[v] = vertexScore(-1, liveTriangles[v]);
+
+	std::vector<bool> emitted(triangleCount, false);
+
+	std::vector<uint32_t> result;
+	result.reserve(indices.size());
+	std::vector<uint32_t> cache;
+	std::vector<uint32_t> nextCache;
+	size_t scanCursor = 0;
+	auto bestTriangle = triangleCount > 0 ? 0 : -1;
+
+	while (result.size() < indices.size())
+	{
+		if (bestTriangle < 0)
+		{
+			// nothing adjacent to the cache is left, continue with the next unprocessed triangle
+			while (scanCursor < triangleCount && emitted[scanCursor])
+				scanCursor++;
+			bestTriangle = static_cast<int>(scanCursor);
+		}
+
+		const auto triangle = static_cast<size_t>(bestTriangle);
+		emitted[triangle] = true;
+
+		nextCache.clear();
+		for (auto k = 0; k < 3; k++)
+		{
+			const auto v = indices[triangle * 3 + k];
+			result.push_back(v);
+			nextCache.push_back(v);
+
+			// remove the triangle from the vertex' live list
+			const auto begin = adjacency.begin() + adjacencyOffset[v];
+			const auto end = begin + liveTriangles[v];
+			const auto it = std::find(begin, end, static_cast<uint32_t>(triangle));
+			if (it == end)
+				continue;
+			std::iter_swap(it, end - 1);
+			liveTriangles[v]--;
+		}
+
+		for (const auto v : cache)
+		{
+			if (std::find(nextCache.begin(), nextCache.begin() + 3, v) == nextCache.begin() + 3)
+				nextCache.push_back(v);
+		}
+
+		// vertices pushed out of the cache lose their cache score
+		for (size_t i = ForsythCacheSize; i < nextCache.size(); i++)
+		{
+			cachePosition[nextCache[i]] = -1;
+			vertexScores[nextCache[i]] = vertexScore(-1, liveTriangles[nextCache[i]]);
+		}
+		if (nextCache.size() > ForsythCacheSize)
+			nextCache.resize(ForsythCacheSize);
+		std::swap(cache, nextCache);
+
+		for (size_t i = 0; i < cache.size(); i++)
+		{
+			cachePosition[cache[i]] = static_cast<int>(i);
+			vertexScores[cache[i]] = vertexScore(static_cast<int>(i), liveTriangles[cache[i]]);
+		}
+
+		// only triangles touching the cache can change their score
+		bestTriangle = -1;
+		auto bestScore = -1.f;
+		for (const auto v : cache)
+		{
+			for (auto a = adjacencyOffset[v]; a < adjacencyOffset[v] + liveTriangles[v]; a++)
+			{
+				const auto t = adjacency[a];
+				const auto score = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+				if (score > bestScore)
+				{
+					bestScore = score;
+					bestTriangle = static_cast<int>(t);
+				}
+			}
+		}
+	}
+
+	indices = std::move(result);
+}
+
+void OptimizeOverdraw(ImportedMesh& mesh, uint32_t cacheSize)
+{
+	const auto& indices = mesh.indices;
+	const auto triangleCount = indices.size() / 3;
+	if (triangleCount == 0)
+		return;
+
+	// a cluster starts whenever a triangle misses the cache with all three vertices,
+	// reordering whole clusters therefore keeps the cache behavior of the optimized order mostly intact
+	std::vector<size_t> clusterStarts;
+	{
+		std::deque<uint32_t> cache;
+		std::vector<bool> cached(mesh.vertices.size(), false);
+		for (size_t t = 0; t < triangleCount; t++)
+		{
+			auto misses = 0;
+			for (auto k = 0; k < 3; k++)
+			{
+				const auto v = indices[t * 3 + k];
+				if (cached[v])
+					continue;
+				misses++;
+				cache.push_back(v);
+				cached[v] = true;
+				if (cache.size() > cacheSize)
+				{
+					cached[cache.front()] = false;
+					cache.pop_front();
+				}
+			}
+			if (t == 0 || misses == 3)
+				clusterStarts.push_back(t);
+		}
+	}
+	clusterStarts.push_back(triangleCount);
+
+	Vec3 meshCentroid = { 0.f, 0.f, 0.f };
+	auto meshArea = 0.f;
+
+	struct Cluster
+	{
+		size_t begin;
+		size_t end;
+		Vec3 centroid;
+		Vec3 normal;
+		float sortKey;
+	};
+	std::vector<Cluster> clusters;
+
+	for (size_t c = 0; c + 1 < clusterStarts.size(); c++)
+	{
+		Cluster cluster = { clusterStarts[c], clusterStarts[c + 1], { 0.f, 0.f, 0.f }, { 0.f, 0.f, 0.f }, 0.f };
+		auto clusterArea = 0.f;
+		for (auto t = cluster.begin; t < cluster.end; t++)
+		{
+			const auto a = positionOf(mesh.vertices[indices[t * 3]]);
+			const auto b = positionOf(mesh.vertices[indices[t * 3 + 1]]);
+			const auto d = positionOf(mesh.vertices[indices[t * 3 + 2]]);
+			const auto normal = vkp::math::Cross(b - a, d - a);
+			const auto area = vkp::math::Length(normal);
+			const auto center = (a + b + d) * (1.f / 3.f);
+
+			cluster.centroid = cluster.centroid + center * area;
+			cluster.normal = cluster.normal + normal;
+			clusterArea += area;
+			meshCentroid = meshCentroid + center * area;
+			meshArea += area;
+		}
+		if (clusterArea > 0.f)
+			cluster.centroid = cluster.centroid * (1.f / clusterArea);
+		cluster.normal = vkp::math::Normalize(cluster.normal);
+		clusters.push_back(cluster);
+	}
+
+	if (meshArea > 0.f)
+		meshCentroid = meshCentroid * (1.f / meshArea);
+
+	for (auto& cluster : clusters)
+		cluster.sortKey = vkp::math::Dot(cluster.centroid - meshCentroid, cluster.normal);
+
+	std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b) { return a.sortKey > b.sortKey; });
+
+	std::vector<uint32_t> result;
+	result.reserve(indices.size());
+	for (auto& cluster : clusters)
+		result.insert(result.end(), indices.begin() + cluster.begin * 3, indices.begin() + cluster.end * 3);
+	mesh.indices = std::move(result);
+}
+
+void OptimizeVertexFetch(ImportedMesh& mesh)
+{
+	constexpr auto Unused = ~0u;
+	std::vector<uint32_t> remap(mesh.vertices.size(), Unused);
+	std::vector<ImportedVertex> vertices;
+	vertices.reserve(mesh.vertices.size());
+
+	for (auto& index : mesh.indices)
+	{
+		if (remap[index] == Unused)
+		{
+			remap[index] = static_cast<uint32_t>(vertices.size());
+			vertices.push_back(mesh.vertices[index]);
+		}
+		index = remap[index];
+	}
+
+	// unreferenced vertices are dropped
+	mesh.vertices = std::move(vertices);
+}
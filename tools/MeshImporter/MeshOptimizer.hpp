@@ -0,0 +1,22 @@
+#pragma once
+#include "ImportedMesh.hpp"
+
+struct VertexCacheStats
+{
+	float acmr; // average cache misses per triangle, 0.5 is the theoretical optimum for regular grids
+	float atvr; // average transformed vertices per vertex, 1.0 is optimal
+	uint32_t misses;
+};
+
+// Simulates a FIFO post-transform cache of the given size
+VertexCacheStats AnalyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize);
+
+// Reorders triangles for post-transform cache locality (Tom Forsyth, "Linear-Speed Vertex Cache Optimisation")
+void OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount);
+
+// Splits the cache optimized triangle order into clusters at cache restarts and sorts the clusters
+// so outward facing ones are drawn first, which lets early depth testing reject more of the inner/back clusters
+void OptimizeOverdraw(ImportedMesh& mesh, uint32_t cacheSize);
+
+// Renumbers vertices in order of first use so vertex fetches walk memory linearly
+void OptimizeVertexFetch(ImportedMesh& mesh);
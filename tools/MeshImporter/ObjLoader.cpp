@@ -0,0 +1,174 @@
+#include "ObjLoader.hpp"
+#include <array>
+#include <cmath>
+#include <exception>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include "../../src/utils/Math.hpp"
+
+using vkp::math::Vec3;
+
+namespace
+{
+	struct VertexKey
+	{
+		int position;
+		int uv;
+		int normal;
+
+		bool operator<(const VertexKey& other) const
+		{
+			if (position != other.position) return position < other.position;
+			if (uv != other.uv) return uv < other.uv;
+			return normal < other.normal;
+		}
+	};
+
+	// OBJ indices are 1 based, negative values are relative to the end of the list
+	int resolveIndex(const std::string& token, size_t count)
+	{
+		if (token.empty())
+			return -1;
+		const auto index = std::stoi(token);
+		if (index < 0)
+			return static_cast<int>(count) + index;
+		return index - 1;
+	}
+
+	VertexKey parseFaceVertex(const std::string& token, size_t positions, size_t uvs, size_t normals)
+	{
+		std::array<std::string, 3> parts;
+		size_t part = 0;
+		for (const auto c : token)
+		{
+			if (c == '/')
+			{
+				if (++part >= parts.size())
+					throw std::exception(std::string("invalid face vertex " + token).c_str());
+				continue;
+			}
+			parts[part] += c;
+		}
+
+		const VertexKey key = { resolveIndex(parts[0], positions), resolveIndex(parts[1], uvs), resolveIndex(parts[2], normals) };
+		if (key.position < 0 || key.position >= static_cast<int>(positions)
+			|| key.uv >= static_cast<int>(uvs) || key.normal >= static_cast<int>(normals))
+			throw std::exception(std::string("face vertex out of range " + token).c_str());
+		return key;
+	}
+}
+
+ImportedMesh LoadObj(const std::string& filename)
+{
+	std::ifstream file(filename);
+	if (file.fail())
+		throw std::exception(std::string("unable to open " + filename).c_str());
+
+	std::vector<Vec3> positions;
+	std::vector<std::array<float, 2>> uvs;
+	std::vector<Vec3> normals;
+	std::map<VertexKey, uint32_t> vertexLookup;
+	ImportedMesh mesh;
+	auto generateNormals = false;
+
+	std::string line;
+	while (std::getline(file, line))
+	{
+		std::istringstream stream(line);
+		std::string type;
+		stream >> type;
+
+		if (type == "v")
+		{
+			Vec3 p = {};
+			stream >> p.x >> p.y >> p.z;
+			positions.push_back(p);
+		}
+		else if (type == "vt")
+		{
+			std::array<float, 2> uv = {};
+			stream >> uv[0] >> uv[1];
+			// OBJ has its texture origin in the bottom left corner, vulkan in the top left
+			uv[1] = 1.f - uv[1];
+			uvs.push_back(uv);
+		}
+		else if (type == "vn")
+		{
+			Vec3 n = {};
+			stream >> n.x >> n.y >> n.z;
+			normals.push_back(n);
+		}
+		else if (type == "f")
+		{
+			std::vector<uint32_t> polygon;
+			std::string token;
+			while (stream >> token)
+			{
+				const auto key = parseFaceVertex(token, positions.size(), uvs.size(), normals.size());
+				auto it = vertexLookup.find(key);
+				if (it == vertexLookup.end())
+				{
+					ImportedVertex vertex = {};
+					const auto& p = positions[key.position];
+					vertex.position[0] = p.x; vertex.position[1] = p.y; vertex.position[2] = p.z;
+					if (key.uv >= 0)
+					{
+						vertex.uv[0] = uvs[key.uv][0];
+						vertex.uv[1] = uvs[key.uv][1];
+					}
+					if (key.normal >= 0)
+					{
+						const auto n = vkp::math::Normalize(normals[key.normal]);
+						vertex.normal[0] = n.x; vertex.normal[1] = n.y; vertex.normal[2] = n.z;
+					}
+					else
+						generateNormals = true;
+
+					it = vertexLookup.emplace(key, static_cast<uint32_t>(mesh.vertices.size())).first;
+					mesh.vertices.push_back(vertex);
+				}
+				polygon.push_back(it->second);
+			}
+
+			for (size_t i = 2; i < polygon.size(); i++)
+			{
+				mesh.indices.push_back(polygon[0]);
+				mesh.indices.push_back(polygon[i - 1]);
+				mesh.indices.push_back(polygon[i]);
+			}
+		}
+	}
+
+	if (mesh.indices.empty())
+		throw std::exception(std::string("no faces found in " + filename).c_str());
+
+	if (generateNormals)
+	{
+		// area weighted face normals accumulated on every vertex sharing the same position
+		std::vector<Vec3> accumulated(positions.size(), Vec3 { 0.f, 0.f, 0.f });
+		std::vector<int> positionOf(mesh.vertices.size());
+		for (auto& entry : vertexLookup)
+			positionOf[entry.second] = entry.first.position;
+
+		for (size_t i = 0; i < mesh.indices.size(); i += 3)
+		{
+			const auto a = positionOf[mesh.indices[i]], b = positionOf[mesh.indices[i + 1]], c = positionOf[mesh.indices[i + 2]];
+			const auto faceNormal = vkp::math::Cross(positions[b] - positions[a], positions[c] - positions[a]);
+			accumulated[a] = accumulated[a] + faceNormal;
+			accumulated[b] = accumulated[b] + faceNormal;
+			accumulated[c] = accumulated[c] + faceNormal;
+		}
+
+		for (auto& entry : vertexLookup)
+		{
+			if (entry.first.normal >= 0)
+				continue;
+			const auto n = vkp::math::Normalize(accumulated[entry.first.position]);
+			auto& vertex = mesh.vertices[entry.second];
+			vertex.normal[0] = n.x; vertex.normal[1] = n.y; vertex.normal[2] = n.z;
+		}
+	}
+
+	return mesh;
+}
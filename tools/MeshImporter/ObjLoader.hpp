@@ -0,0 +1,6 @@
+#pragma once
+#include <string>
+#include "ImportedMesh.hpp"
+
+// Wavefront OBJ loader, polygons are triangulated as fans and missing normals are generated from the faces
+ImportedMesh LoadObj(const std::string& filename);
@@ -0,0 +1,215 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <vector>
+#include <spdlog/spdlog.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include "../../src/utils/MappedFile.hpp"
+#include "MeshEncoder.hpp"
+#include "MeshOptimizer.hpp"
+#include "ObjLoader.hpp"
+
+using namespace vkp::assets;
+using Clock = std::chrono::high_resolution_clock;
+
+namespace
+{
+	const uint32_t CacheSizes[] = { 16, 32 };
+
+	void printUsage()
+	{
+		auto log = spdlog::get("logger");
+		log->info("usage: MeshImporter <input.obj> <output.vkmesh> [--no-optimize]");
+		log->info("       MeshImporter --bench <input.vkmesh> [iterations]");
+	}
+
+	void logCacheStats(const char* label, const std::vector<uint32_t>& indices, size_t vertexCount)
+	{
+		for (const auto cacheSize : CacheSizes)
+		{
+			const auto stats = AnalyzeVertexCache(indices, vertexCount, cacheSize);
+			spdlog::get("logger")->info("{0} (FIFO {1}): ACMR {2:.3f}, ATVR {3:.3f}", label, cacheSize, stats.acmr, stats.atvr);
+		}
+	}
+
+	const MeshHeader& validateMesh(const vkp::ByteSpan& data, const std::string& filename)
+	{
+		if (data.size < sizeof(MeshHeader))
+			throw std::exception(std::string("mesh truncated: " + filename).c_str());
+		const auto& header = *data.as<MeshHeader>();
+		if (header.magic != MeshMagic || header.version != MeshVersion)
+			throw std::exception(std::string("not a mesh file: " + filename).c_str());
+		if (!IsMeshLayoutValid(header, data.size))
+			throw std::exception(std::string("invalid mesh layout: " + filename).c_str());
+		return header;
+	}
+
+	int import(const std::string& input, const std::string& output, bool optimize)
+	{
+		auto log = spdlog::get("logger");
+
+		const auto extension = std::filesystem::path(input).extension().string();
+		if (extension != ".obj")
+			throw std::exception(std::string("unsupported input format " + extension + ", only .obj is supported").c_str());
+
+		auto mesh = LoadObj(input);
+		log->info("Loaded {0}: {1} vertices, {2} triangles", input, mesh.vertices.size(), mesh.indices.size() / 3);
+
+		if (optimize)
+		{
+			logCacheStats("before", mesh.indices, mesh.vertices.size());
+			OptimizeVertexCache(mesh.indices, mesh.vertices.size());
+			OptimizeOverdraw(mesh, CacheSizes[0]);
+			OptimizeVertexFetch(mesh);
+			logCacheStats("after", mesh.indices, mesh.vertices.size());
+		}
+
+		const auto data = EncodeMesh(mesh);
+
+		// report the worst quantization error so bad inputs (huge bounds, tiled uvs) are easy to spot
+		const auto& header = *reinterpret_cast<const MeshHeader*>(data.data());
+		const auto packed = reinterpret_cast<const PackedVertex*>(data.data() + header.vertexOffset);
+		auto positionError = 0.f, normalError = 0.f, uvError = 0.f;
+		for (size_t i = 0; i < mesh.vertices.size(); i++)
+		{
+			const auto decoded = DecodeVertex(header, packed[i]);
+			for (auto k = 0; k < 3; k++)
+			{
+				positionError = std::max(positionError, std::abs(decoded.position[k] - mesh.vertices[i].position[k]));
+				normalError = std::max(normalError, std::abs(decoded.normal[k] - mesh.vertices[i].normal[k]));
+			}
+			for (auto k = 0; k < 2; k++)
+				uvError = std::max(uvError, std::abs(decoded.uv[k] - mesh.vertices[i].uv[k]));
+		}
+		log->info("Max quantization error: position {0}, normal {1}, uv {2}", positionError, normalError, uvError);
+
+		std::ofstream file(output, std::ios::binary | std::ios::trunc);
+		if (file.fail())
+			throw std::exception(std::string("unable to open " + output).c_str());
+		file.write(reinterpret_cast<const char*>(data.data()), data.size());
+		log->info("Wrote {0} ({1} bytes, {2} bytes per vertex)", output, data.size(), header.vertexStride);
+		return EXIT_SUCCESS;
+	}
+
+	template <typename TCallback>
+	double measureMs(int iterations, TCallback callback)
+	{
+		const auto start = Clock::now();
+		for (auto i = 0; i < iterations; i++)
+			callback();
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count() / iterations;
+	}
+
+	// emulates the input assembler: every index fetches its whole vertex
+	template <typename TVertex>
+	uint64_t fetchVertices(const TVertex* vertices, const std::vector<uint32_t>& indices)
+	{
+		uint64_t checksum = 0;
+		for (const auto index : indices)
+		{
+			uint32_t words[sizeof(TVertex) / sizeof(uint32_t)];
+			std::memcpy(words, &vertices[index], sizeof(TVertex));
+			for (const auto word : words)
+				checksum += word;
+		}
+		return checksum;
+	}
+
+	int benchmark(const std::string& input, int iterations)
+	{
+		auto log = spdlog::get("logger");
+
+		// the unquantized baseline uses the same container with 32 byte float vertices and 32 bit indices
+		std::vector<ImportedVertex> floatVertices;
+		std::vector<uint32_t> indices;
+		std::vector<PackedVertex> packedVertices;
+		{
+			vkp::MappedFile file(input);
+			const auto data = file.GetData();
+			const auto& header = validateMesh(data, input);
+			const auto packed = reinterpret_cast<const PackedVertex*>(data.data + header.vertexOffset);
+			packedVertices.assign(packed, packed + header.vertexCount);
+			for (uint32_t i = 0; i < header.vertexCount; i++)
+				floatVertices.push_back(DecodeVertex(header, packed[i]));
+
+			for (uint32_t i = 0; i < header.indexCount; i++)
+			{
+				if (header.indexType == MeshIndexType::UInt16)
+					indices.push_back(reinterpret_cast<const uint16_t*>(data.data + header.indexOffset)[i]);
+				else
+					indices.push_back(reinterpret_cast<const uint32_t*>(data.data + header.indexOffset)[i]);
+			}
+		}
+
+		const auto baseline = input + ".float.bin";
+		{
+			std::ofstream file(baseline, std::ios::binary | std::ios::trunc);
+			file.write(reinterpret_cast<const char*>(floatVertices.data()), floatVertices.size() * sizeof(ImportedVertex));
+			file.write(reinterpret_cast<const char*>(indices.data()), indices.size() * sizeof(uint32_t));
+		}
+
+		std::vector<uint8_t> staging;
+		const auto loadPacked = measureMs(iterations, [&]()
+		{
+			vkp::MappedFile file(input);
+			const auto data = file.GetData();
+			const auto& header = validateMesh(data, input);
+			const auto size = header.indexOffset + header.indexSize - header.vertexOffset;
+			staging.resize(size);
+			std::memcpy(staging.data(), data.data + header.vertexOffset, size);
+		});
+		const auto loadFloat = measureMs(iterations, [&]()
+		{
+			vkp::MappedFile file(baseline);
+			const auto data = file.GetData();
+			staging.resize(data.size);
+			std::memcpy(staging.data(), data.data, data.size);
+		});
+		std::filesystem::remove(baseline);
+
+		uint64_t checksum = 0;
+		const auto fetchPacked = measureMs(iterations, [&]() { checksum += fetchVertices(packedVertices.data(), indices); });
+		const auto fetchFloat = measureMs(iterations, [&]() { checksum += fetchVertices(floatVertices.data(), indices); });
+
+		const auto misses = AnalyzeVertexCache(indices, packedVertices.size(), CacheSizes[1]).misses;
+		const auto packedIndexSize = packedVertices.size() <= std::numeric_limits<uint16_t>::max() ? sizeof(uint16_t) : sizeof(uint32_t);
+
+		log->info("{0}: {1} vertices, {2} triangles, {3} iterations (checksum {4})", input, packedVertices.size(), indices.size() / 3, iterations, checksum);
+		log->info("{0:<12} {1:>12} {2:>12} {3:>14} {4:>16} {5:>12}", "layout", "bytes/vertex", "load ms", "stream bytes", "fetched bytes", "fetch ms");
+		log->info("{0:<12} {1:>12} {2:>12.4f} {3:>14} {4:>16} {5:>12.4f}", "quantized", sizeof(PackedVertex), loadPacked,
+			packedVertices.size() * sizeof(PackedVertex) + indices.size() * packedIndexSize, uint64_t(misses) * sizeof(PackedVertex), fetchPacked);
+		log->info("{0:<12} {1:>12} {2:>12.4f} {3:>14} {4:>16} {5:>12.4f}", "float", sizeof(ImportedVertex), loadFloat,
+			floatVertices.size() * sizeof(ImportedVertex) + indices.size() * sizeof(uint32_t), uint64_t(misses) * sizeof(ImportedVertex), fetchFloat);
+		log->info("fetched bytes assume a {0} entry post-transform cache", CacheSizes[1]);
+		return EXIT_SUCCESS;
+	}
+}
+
+int main(int argc, const char* argv[])
+{
+	spdlog::stdout_color_mt("logger")->set_level(spdlog::level::level_enum::info);
+	auto log = spdlog::get("logger");
+
+	std::vector<std::string> args(argv + 1, argv + argc);
+	try
+	{
+		if (args.size() >= 2 && args[0] == "--bench")
+			return benchmark(args[1], args.size() >= 3 ? std::stoi(args[2]) : 100);
+
+		if (args.size() >= 2)
+			return import(args[0], args[1], std::find(args.begin(), args.end(), "--no-optimize") == args.end());
+	}
+	catch (const std::exception& e)
+	{
+		log->error("Mesh import failed: {0}", e.what());
+		return EXIT_FAILURE;
+	}
+
+	printUsage();
+	return EXIT_FAILURE;
+}
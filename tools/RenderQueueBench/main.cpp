@@ -0,0 +1,180 @@
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+#include <spdlog/spdlog.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include "../../src/gfx/RenderQueue.hpp"
+
+using Clock = std::chrono::high_resolution_clock;
+
+namespace
+{
+	const size_t DrawCounts[] = { 10000, 100000, 1000000 };
+	const uint32_t PipelineCount = 32;
+	const uint32_t MaterialCount = 1024;
+	const uint32_t MeshCount = 2048;
+	const uint32_t Iterations = 3;
+
+	// stands in for vk::CommandBuffer so the recorder can be measured without a device, only counts what would be recorded
+	struct CountingCommandBuffer
+	{
+		uint64_t commands = 0;
+		uint64_t indices = 0;
+
+		void bindPipeline(vk::PipelineBindPoint, vk::Pipeline) { this->commands++; }
+		void bindDescriptorSets(vk::PipelineBindPoint, vk::PipelineLayout, uint32_t, const vk::DescriptorSet&, std::nullptr_t) { this->commands++; }
+		void bindVertexBuffers(uint32_t, uint32_t, const vk::Buffer*, const vk::DeviceSize*) { this->commands++; }
+		void bindIndexBuffer(vk::Buffer, vk::DeviceSize, vk::IndexType) { this->commands++; }
+		void drawIndexed(uint32_t indexCount, uint32_t, uint32_t, int32_t, uint32_t)
+		{
+			this->commands++;
+			this->indices += indexCount;
+		}
+	};
+
+	struct Scene
+	{
+		std::vector<RenderPipeline> pipelines;
+		std::vector<RenderMaterial> materials;
+		std::vector<RenderMesh> meshes;
+		std::vector<std::pair<uint64_t, DrawItem>> draws;
+	};
+
+	void printUsage()
+	{
+		spdlog::get("logger")->info("usage: RenderQueueBench [draw count...]");
+	}
+
+	Scene generateScene(size_t drawCount, std::mt19937& random)
+	{
+		Scene scene;
+		scene.pipelines.resize(PipelineCount);
+		scene.materials.resize(MaterialCount);
+		scene.meshes.resize(MeshCount);
+		for (uint32_t i = 0; i < MeshCount; i++)
+			scene.meshes[i] = { vk::Buffer(), vk::Buffer(), vk::IndexType::eUint16, 36 + i % 7 * 3 };
+
+		// materials belong to a pipeline, like they would in a real scene
+		std::uniform_int_distribution<uint32_t> materialDistribution(0, MaterialCount - 1);
+		std::uniform_int_distribution<uint32_t> meshDistribution(0, MeshCount - 1);
+		std::uniform_real_distribution<float> depthDistribution(0.f, 1.f);
+		scene.draws.reserve(drawCount);
+		for (size_t i = 0; i < drawCount; i++)
+		{
+			DrawItem item = {};
+			item.material = materialDistribution(random);
+			item.pipeline = item.material % PipelineCount;
+			item.mesh = meshDistribution(random);
+			item.instance = static_cast<uint32_t>(i);
+			scene.draws.emplace_back(RenderQueue::MakeKey(0, item.pipeline, item.material, item.mesh, depthDistribution(random)), item);
+		}
+		return scene;
+	}
+
+	struct RunResult
+	{
+		RenderQueueStats stats;
+		uint64_t commands;
+	};
+
+	RunResult run(const Scene& scene, RenderQueue& queue, bool sort, bool skipRedundantState)
+	{
+		RunResult best = {};
+		for (uint32_t i = 0; i < Iterations; i++)
+		{
+			queue.Clear();
+			for (const auto& draw : scene.draws)
+				queue.Add(draw.first, draw.second);
+			if (sort)
+				queue.Sort();
+
+			CountingCommandBuffer commandBuffer;
+			uint64_t pushedInstances = 0;
+			queue.Record(commandBuffer, scene.pipelines, scene.materials, scene.meshes,
+				[&pushedInstances](CountingCommandBuffer&, vk::PipelineLayout, uint32_t instance) { pushedInstances += instance; }, skipRedundantState);
+
+			const auto& stats = queue.GetStats();
+			if (i == 0 || stats.recordMilliseconds + stats.sortMilliseconds < best.stats.recordMilliseconds + best.stats.sortMilliseconds)
+				best = { stats, commandBuffer.commands };
+		}
+		return best;
+	}
+
+	void validateOrder(const Scene& scene, const RenderQueue& queue)
+	{
+		const auto& order = queue.GetOrder();
+		for (size_t i = 1; i < order.size(); i++)
+		{
+			if (scene.draws[order[i - 1]].first > scene.draws[order[i]].first)
+				throw std::exception("radix sort produced an unsorted draw list");
+		}
+	}
+
+	double measureStdSort(const Scene& scene)
+	{
+		std::vector<std::pair<uint64_t, uint32_t>> keys(scene.draws.size());
+		for (uint32_t i = 0; i < keys.size(); i++)
+			keys[i] = { scene.draws[i].first, i };
+
+		const auto start = Clock::now();
+		std::sort(keys.begin(), keys.end());
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+
+	void logResult(const char* label, const RunResult& result)
+	{
+		const auto& stats = result.stats;
+		const auto stateChanges = stats.pipelineBinds + stats.descriptorBinds + stats.vertexBufferBinds + stats.indexBufferBinds;
+		spdlog::get("logger")->info("  {0:<28} state changes {1:>8} (pipeline {2:>7}, descriptor {3:>8}, vertex {4:>8}, index {5:>8}), sort {6:>8.3f} ms, record {7:>8.3f} ms",
+			label, stateChanges, stats.pipelineBinds, stats.descriptorBinds, stats.vertexBufferBinds, stats.indexBufferBinds, stats.sortMilliseconds, stats.recordMilliseconds);
+	}
+}
+
+int main(int argc, const char* argv[])
+{
+	spdlog::stdout_color_mt("logger")->set_level(spdlog::level::level_enum::info);
+	auto log = spdlog::get("logger");
+
+	std::vector<std::string> args(argv + 1, argv + argc);
+	if (!args.empty() && args[0] == "--help")
+	{
+		printUsage();
+		return EXIT_SUCCESS;
+	}
+
+	try
+	{
+		std::vector<size_t> drawCounts(std::begin(DrawCounts), std::end(DrawCounts));
+		if (!args.empty())
+		{
+			drawCounts.clear();
+			for (const auto& arg : args)
+				drawCounts.push_back(std::stoull(arg));
+		}
+
+		std::mt19937 random(1234);
+		RenderQueue queue;
+		for (const auto drawCount : drawCounts)
+		{
+			const auto scene = generateScene(drawCount, random);
+			log->info("{0} draws, {1} pipelines, {2} materials, {3} meshes", drawCount, PipelineCount, MaterialCount, MeshCount);
+
+			logResult("unsorted, every bind", run(scene, queue, false, false));
+			logResult("unsorted, redundant skipped", run(scene, queue, false, true));
+			const auto sorted = run(scene, queue, true, true);
+			validateOrder(scene, queue);
+			logResult("radix sorted, skipped", sorted);
+			log->info("  std::sort of the same keys {0:>8.3f} ms", measureStdSort(scene));
+		}
+	}
+	catch (const std::exception& e)
+	{
+		log->error("Benchmark failed: {0}", e.what());
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,509 @@
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+#define SDL_MAIN_HANDLED
+#include <SDL.h>
+#include <spdlog/spdlog.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include "../../src/gfx/VulkanRenderer.h"
+
+using Clock = std::chrono::high_resolution_clock;
+
+namespace
+{
+	std::atomic<uint64_t> hostAllocations(0);
+}
+
+// every heap allocation of the process is counted, the scenarios report how many happened while they were measured
+void* operator new(size_t size)
+{
+	hostAllocations++;
+	if (const auto memory = std::malloc(size > 0 ? size : 1))
+		return memory;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void* memory, size_t size) noexcept
+{
+	std::free(memory);
+}
+
+namespace
+{
+	const int WINDOW_WIDTH = 1280;
+	const int WINDOW_HEIGHT = 720;
+	const uint64_t WARMUP_FRAMES = 30;       // pipelines, descriptor pools and swap chain images settle before measuring
+	const uint32_t STARTUP_RUNS = 5;
+	const uint32_t HIGH_DRAW_COUNT = 2000;
+	const double FRAME_TIME = 1.0 / 60.0;
+	const double DEFAULT_TOLERANCE = 10.0;   // percent
+	const int RESIZE_SIZES[][2] = { { 1280, 720 }, { 960, 540 }, { 1600, 900 }, { 640, 360 }, { 1024, 768 }, { 800, 480 } };
+	const double PERCENTILES[] = { 50.0, 95.0, 99.0 };
+	const char* PERCENTILE_NAMES[] = { "p50", "p95", "p99" };
+
+	enum class ScenarioType
+	{
+		Startup,
+		Steady,
+		ResizeStorm
+	};
+
+	struct Scenario
+	{
+		const char* name;
+		ScenarioType type;
+		RenderSessionSettings settings;
+	};
+
+	struct ScenarioResult
+	{
+		std::string name;
+		uint64_t frames;                   // measured frames, or runs for the startup scenario
+		std::vector<double> cpuMilliseconds;
+		std::vector<double> gpuMilliseconds;
+		uint64_t hostAllocations;          // while measuring
+		uint64_t memoryAllocations;        // buffers and images created while measuring
+		uint64_t deviceMemoryAllocations;  // vkAllocateMemory calls while measuring
+		uint64_t peakDeviceMemoryBytes;
+	};
+
+	void printUsage()
+	{
+		auto log = spdlog::get("logger");
+		log->info("usage: RendererBench run <results.json> [frames] [scenarios...]");
+		log->info("       RendererBench compare <baseline.json> <results.json> [tolerance %]");
+		log->info("scenarios: startup, steady, resize_storm, high_draw_count (all by default)");
+	}
+
+	std::vector<Scenario> makeScenarios()
+	{
+		RenderSessionSettings steady;
+		RenderSessionSettings highDrawCount;
+		highDrawCount.sceneInstances = HIGH_DRAW_COUNT;
+
+		return
+		{
+			{ "startup", ScenarioType::Startup, steady },
+			{ "steady", ScenarioType::Steady, steady },
+			{ "resize_storm", ScenarioType::ResizeStorm, steady },
+			{ "high_draw_count", ScenarioType::Steady, highDrawCount }
+		};
+	}
+
+	// same camera as the application, so the numbers are comparable with its vk-perf output
+	FrameSnapshot makeSnapshot(uint64_t frame, uint32_t width, uint32_t height)
+	{
+		FrameSnapshot snapshot = {};
+		snapshot.frame = frame;
+		snapshot.time = frame * FRAME_TIME;
+		snapshot.deltaTime = static_cast<float>(FRAME_TIME);
+		snapshot.windows = { { width, height, false } };
+		snapshot.cameraPosition = { 3.f, 2.5f, 4.f };
+		snapshot.cameraTarget = { 0.f, 0.f, 0.f };
+		snapshot.meshRotation = static_cast<float>(snapshot.time * 0.5);
+		return snapshot;
+	}
+
+	SDL_Window* createWindow()
+	{
+		const auto window = SDL_CreateWindow("RendererBench", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, WINDOW_WIDTH, WINDOW_HEIGHT,
+			SDL_WINDOW_SHOWN | SDL_WINDOW_VULKAN | SDL_WINDOW_RESIZABLE);
+		if (window == nullptr)
+			throw std::exception(SDL_GetError());
+		return window;
+	}
+
+	double percentile(std::vector<double> samples, double p)
+	{
+		if (samples.empty())
+			return 0.0;
+
+		// nearest rank
+		std::sort(samples.begin(), samples.end());
+		const auto rank = static_cast<size_t>(std::ceil(p / 100.0 * samples.size()));
+		return samples[std::min(std::max(rank, size_t(1)), samples.size()) - 1];
+	}
+
+	// the renderer reports the GPU time of a frame once its slot comes around again, at most one per Draw
+	void drawFrame(IRenderer& renderer, const FrameSnapshot& snapshot, ScenarioResult* result)
+	{
+		const auto timedFrames = renderer.GetStats().timedFrames;
+		const auto start = Clock::now();
+		renderer.Draw(snapshot);
+		const auto milliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+		if (!result)
+			return;
+
+		result->cpuMilliseconds.push_back(milliseconds);
+		const auto stats = renderer.GetStats();
+		if (stats.timedFrames > timedFrames)
+			result->gpuMilliseconds.push_back(stats.lastGpuMilliseconds);
+	}
+
+	// time from creating the renderer until its first frame was handed to presentation, on a fresh device every run
+	ScenarioResult runStartup(const Scenario& scenario, SDL_Window* window)
+	{
+		ScenarioResult result = {};
+		result.name = scenario.name;
+
+		for (uint32_t run = 0; run < STARTUP_RUNS; run++)
+		{
+			const auto allocations = hostAllocations.load();
+			const auto start = Clock::now();
+			{
+				VulkanRenderer renderer(scenario.settings);
+				renderer.Initialize({ window });
+				renderer.Draw(makeSnapshot(0, WINDOW_WIDTH, WINDOW_HEIGHT));
+				result.cpuMilliseconds.push_back(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+
+				// every run creates the same resources, the last one is reported
+				const auto stats = renderer.GetStats();
+				result.hostAllocations = hostAllocations - allocations;
+				result.memoryAllocations = stats.memoryAllocations;
+				result.deviceMemoryAllocations = stats.deviceMemoryAllocations;
+				result.peakDeviceMemoryBytes = stats.peakDeviceMemoryBytes;
+			}
+			SDL_PumpEvents();
+		}
+
+		result.frames = STARTUP_RUNS;
+		return result;
+	}
+
+	// steady state drawing, or with resizeStorm a different window size every frame
+	ScenarioResult runFrames(const Scenario& scenario, SDL_Window* window, uint64_t frames)
+	{
+		ScenarioResult result = {};
+		result.name = scenario.name;
+		result.frames = frames;
+
+		VulkanRenderer renderer(scenario.settings);
+		renderer.Initialize({ window });
+
+		uint32_t width = WINDOW_WIDTH;
+		uint32_t height = WINDOW_HEIGHT;
+		uint64_t frame = 0;
+		for (; frame < WARMUP_FRAMES; frame++)
+		{
+			SDL_PumpEvents();
+			drawFrame(renderer, makeSnapshot(frame, width, height), nullptr);
+		}
+
+		const auto statsBefore = renderer.GetStats();
+		const auto allocationsBefore = hostAllocations.load();
+		for (uint64_t i = 0; i < frames; i++, frame++)
+		{
+			SDL_PumpEvents();
+			if (scenario.type == ScenarioType::ResizeStorm)
+			{
+				// the window manager may clamp the size, the renderer gets whatever the window ended up with
+				const auto& size = RESIZE_SIZES[i % std::size(RESIZE_SIZES)];
+				SDL_SetWindowSize(window, size[0], size[1]);
+				int actualWidth, actualHeight;
+				SDL_GetWindowSize(window, &actualWidth, &actualHeight);
+				width = static_cast<uint32_t>(actualWidth);
+				height = static_cast<uint32_t>(actualHeight);
+
+				const auto start = Clock::now();
+				renderer.Resize(0, width, height);
+				const auto resizeMilliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+				drawFrame(renderer, makeSnapshot(frame, width, height), &result);
+				result.cpuMilliseconds.back() += resizeMilliseconds;
+			}
+			else
+				drawFrame(renderer, makeSnapshot(frame, width, height), &result);
+		}
+
+		const auto statsAfter = renderer.GetStats();
+		result.hostAllocations = hostAllocations - allocationsBefore;
+		result.memoryAllocations = statsAfter.memoryAllocations - statsBefore.memoryAllocations;
+		result.deviceMemoryAllocations = statsAfter.deviceMemoryAllocations - statsBefore.deviceMemoryAllocations;
+		result.peakDeviceMemoryBytes = statsAfter.peakDeviceMemoryBytes;
+
+		SDL_SetWindowSize(window, WINDOW_WIDTH, WINDOW_HEIGHT);
+		return result;
+	}
+
+	void writePercentiles(std::ostream& out, const char* name, const std::vector<double>& samples)
+	{
+		out << "      \"" << name << "\": { ";
+		for (size_t i = 0; i < std::size(PERCENTILES); i++)
+			out << (i > 0 ? ", " : "") << "\"" << PERCENTILE_NAMES[i] << "\": " << percentile(samples, PERCENTILES[i]);
+		out << ", \"samples\": " << samples.size() << " },\n";
+	}
+
+	void writeResults(const std::string& filename, const std::vector<ScenarioResult>& results)
+	{
+		std::ofstream file(filename, std::ios::trunc);
+		if (file.fail())
+			throw std::exception(std::string("unable to open " + filename).c_str());
+
+		// scenarios are keyed by name so compare can look them up without caring about their order
+		file << "{\n  \"version\": 1,\n  \"scenarios\": {\n";
+		for (size_t i = 0; i < results.size(); i++)
+		{
+			const auto& result = results[i];
+			file << "    \"" << result.name << "\": {\n";
+			file << "      \"frames\": " << result.frames << ",\n";
+			writePercentiles(file, "cpu_ms", result.cpuMilliseconds);
+			writePercentiles(file, "gpu_ms", result.gpuMilliseconds);
+			file << "      \"host_allocations\": " << result.hostAllocations << ",\n";
+			file << "      \"memory_allocations\": " << result.memoryAllocations << ",\n";
+			file << "      \"device_memory_allocations\": " << result.deviceMemoryAllocations << ",\n";
+			file << "      \"peak_device_memory_bytes\": " << result.peakDeviceMemoryBytes << "\n";
+			file << "    }" << (i + 1 < results.size() ? "," : "") << "\n";
+		}
+		file << "  }\n}\n";
+	}
+
+	// Reads the JSON written by writeResults into dotted paths, e.g. "scenarios.steady.cpu_ms.p95".
+	// Only objects, strings and numbers are understood, which is all the results contain.
+	class ResultReader
+	{
+		const std::string& text;
+		size_t position = 0;
+
+		void SkipWhitespace()
+		{
+			while (this->position < this->text.size() && std::isspace(static_cast<unsigned char>(this->text[this->position])))
+				this->position++;
+		}
+
+		void Expect(char c)
+		{
+			this->SkipWhitespace();
+			if (this->position >= this->text.size() || this->text[this->position] != c)
+				throw std::exception((std::string("malformed results, expected '") + c + "' at offset " + std::to_string(this->position)).c_str());
+			this->position++;
+		}
+
+		std::string ReadString()
+		{
+			this->Expect('"');
+			const auto end = this->text.find('"', this->position);
+			if (end == std::string::npos)
+				throw std::exception("malformed results, unterminated string");
+			auto value = this->text.substr(this->position, end - this->position);
+			this->position = end + 1;
+			return value;
+		}
+
+		void ReadValue(const std::string& path, std::map<std::string, double>& values)
+		{
+			this->SkipWhitespace();
+			if (this->position >= this->text.size())
+				throw std::exception("malformed results, unexpected end");
+
+			const auto c = this->text[this->position];
+			if (c == '{')
+				this->ReadObject(path + ".", values);
+			else if (c == '"')
+				this->ReadString();
+			else
+			{
+				size_t length;
+				values[path] = std::stod(this->text.substr(this->position, 32), &length);
+				this->position += length;
+			}
+		}
+
+	public:
+		explicit ResultReader(const std::string& text) : text(text) {}
+
+		void ReadObject(const std::string& prefix, std::map<std::string, double>& values)
+		{
+			this->Expect('{');
+			this->SkipWhitespace();
+			if (this->position < this->text.size() && this->text[this->position] == '}')
+			{
+				this->position++;
+				return;
+			}
+
+			while (true)
+			{
+				const auto key = this->ReadString();
+				this->Expect(':');
+				this->ReadValue(prefix + key, values);
+				this->SkipWhitespace();
+				if (this->position < this->text.size() && this->text[this->position] == ',')
+				{
+					this->position++;
+					continue;
+				}
+				this->Expect('}');
+				return;
+			}
+		}
+	};
+
+	std::map<std::string, double> readResults(const std::string& filename)
+	{
+		std::ifstream file(filename);
+		if (file.fail())
+			throw std::exception(std::string("unable to open " + filename).c_str());
+		std::stringstream buffer;
+		buffer << file.rdbuf();
+		const auto text = buffer.str();
+
+		std::map<std::string, double> values;
+		ResultReader(text).ReadObject("", values);
+		return values;
+	}
+
+	bool endsWith(const std::string& value, const std::string& suffix)
+	{
+		return value.size() >= suffix.size() && value.compare(value.size() - suffix.size(), suffix.size(), suffix) == 0;
+	}
+
+	// every reported metric is lower is better, returns the number of regressions
+	int compare(const std::string& baselineFile, const std::string& currentFile, double tolerance)
+	{
+		auto log = spdlog::get("logger");
+		const auto baseline = readResults(baselineFile);
+		const auto current = readResults(currentFile);
+
+		int regressions = 0;
+		log->info("{0:<48} {1:>14} {2:>14} {3:>9}", "metric", "baseline", "current", "change");
+		for (const auto& [path, baselineValue] : baseline)
+		{
+			if (path.compare(0, 10, "scenarios.") != 0 || endsWith(path, ".frames") || endsWith(path, ".samples"))
+				continue;
+
+			const auto found = current.find(path);
+			if (found == current.end())
+			{
+				log->warn("{0:<48} missing from {1}", path, currentFile);
+				continue;
+			}
+
+			// percentiles without samples (no timestamps on the device) are not comparable
+			const auto samples = path.substr(0, path.rfind('.')) + ".samples";
+			if (baseline.count(samples) && (baseline.at(samples) == 0.0 || current.count(samples) == 0 || current.at(samples) == 0.0))
+				continue;
+
+			// counts that were 0 regress with any increase, a steady state that starts allocating is always worth a look
+			const auto currentValue = found->second;
+			const auto change = baselineValue > 0.0 ? 100.0 * (currentValue - baselineValue) / baselineValue : (currentValue > 0.0 ? 100.0 : 0.0);
+			const auto regressed = change > tolerance;
+			if (regressed)
+			{
+				regressions++;
+				log->error("{0:<48} {1:>14.3f} {2:>14.3f} {3:>+8.1f}% REGRESSION", path, baselineValue, currentValue, change);
+			}
+			else
+				log->info("{0:<48} {1:>14.3f} {2:>14.3f} {3:>+8.1f}%", path, baselineValue, currentValue, change);
+		}
+
+		for (const auto& [path, value] : current)
+		{
+			if (path.compare(0, 10, "scenarios.") == 0 && baseline.count(path) == 0)
+				log->warn("{0:<48} not in the baseline {1}", path, baselineFile);
+		}
+
+		if (regressions > 0)
+			log->error("{0} regression(s) beyond {1:.1f}%", regressions, tolerance);
+		else
+			log->info("No regressions beyond {0:.1f}%", tolerance);
+		return regressions;
+	}
+
+	int run(const std::string& output, uint64_t frames, const std::vector<std::string>& names)
+	{
+		auto log = spdlog::get("logger");
+
+		std::vector<Scenario> scenarios;
+		for (const auto& scenario : makeScenarios())
+		{
+			if (names.empty() || std::find(names.begin(), names.end(), scenario.name) != names.end())
+				scenarios.push_back(scenario);
+		}
+		if (scenarios.empty())
+			throw std::exception("no known scenario selected");
+
+		SDL_SetMainReady();
+		if (SDL_Init(SDL_INIT_VIDEO) < 0)
+			throw std::exception(SDL_GetError());
+
+		std::vector<ScenarioResult> results;
+		try
+		{
+			// one window for all scenarios, every renderer creates its own surface on it
+			const auto window = createWindow();
+			for (const auto& scenario : scenarios)
+			{
+				auto result = scenario.type == ScenarioType::Startup ? runStartup(scenario, window) : runFrames(scenario, window, frames);
+				log->info("{0:<16} CPU p50 {1:>7.3f} p95 {2:>7.3f} p99 {3:>7.3f} ms, GPU p50 {4:>7.3f} p95 {5:>7.3f} p99 {6:>7.3f} ms, {7} host / {8} resource / {9} device memory allocations, peak {10:.1f} MiB",
+					result.name, percentile(result.cpuMilliseconds, 50.0), percentile(result.cpuMilliseconds, 95.0), percentile(result.cpuMilliseconds, 99.0),
+					percentile(result.gpuMilliseconds, 50.0), percentile(result.gpuMilliseconds, 95.0), percentile(result.gpuMilliseconds, 99.0),
+					result.hostAllocations, result.memoryAllocations, result.deviceMemoryAllocations, result.peakDeviceMemoryBytes / (1024.0 * 1024.0));
+				results.push_back(std::move(result));
+			}
+			SDL_DestroyWindow(window);
+		}
+		catch (...)
+		{
+			SDL_Quit();
+			throw;
+		}
+		SDL_Quit();
+
+		writeResults(output, results);
+		log->info("Wrote {0}", output);
+		return EXIT_SUCCESS;
+	}
+}
+
+int main(int argc, const char* argv[])
+{
+	spdlog::stdout_color_mt("logger")->set_level(spdlog::level::level_enum::info);
+	spdlog::stdout_color_mt("vk-perf")->set_level(spdlog::level::level_enum::warn);
+	spdlog::stdout_color_mt("vk-general")->set_level(spdlog::level::level_enum::warn);
+	spdlog::stdout_color_mt("vk-val")->set_level(spdlog::level::level_enum::warn);
+	auto log = spdlog::get("logger");
+
+	std::vector<std::string> args(argv + 1, argv + argc);
+	if (args.size() < 2 || args[0] == "--help")
+	{
+		printUsage();
+		return args.empty() || args[0] != "--help" ? EXIT_FAILURE : EXIT_SUCCESS;
+	}
+
+	try
+	{
+		if (args[0] == "run")
+		{
+			const auto frames = args.size() >= 3 ? std::max(std::stoull(args[2]), 1ull) : 600;
+			const std::vector<std::string> names(args.begin() + std::min<size_t>(args.size(), 3), args.end());
+			return run(args[1], frames, names);
+		}
+		if (args[0] == "compare" && args.size() >= 3)
+		{
+			const auto tolerance = args.size() >= 4 ? std::stod(args[3]) : DEFAULT_TOLERANCE;
+			return compare(args[1], args[2], tolerance) > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+		}
+
+		printUsage();
+		return EXIT_FAILURE;
+	}
+	catch (const std::exception& e)
+	{
+		log->error("Benchmark failed: {0}", e.what());
+		return EXIT_FAILURE;
+	}
+}